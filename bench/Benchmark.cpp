@@ -0,0 +1,618 @@
+#include "tga/tga.hpp"
+#include "tga/tga_utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numbers>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Camera.hpp"
+#include "Config.hpp"
+#include "FrustumCuller.hpp"
+#include "GpuUtils.hpp"
+#include "LPCBuilder.hpp"
+#include "PointCloud.hpp"
+#include "PointRasterizer.hpp"
+#include "ThreadPool.hpp"
+
+#ifndef POINTSPIRE_REVISION
+#define POINTSPIRE_REVISION "unknown"
+#endif
+
+/*
+ * pointspire-bench: timings of the LPC build and of the per-frame cull and
+ * draw over synthetic point clouds, written as JSON or CSV for tracking
+ * regressions across commits.
+ *
+ * Renders offscreen and needs no window or swapchain, so it runs on a
+ * CPU-only box with lavapipe (e.g. VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json).
+ *
+ * Usage: pointspire-bench [--points=1M,10M,...] [--distribution=uniform,clustered,terrain]
+ *                         [--frames=<n>] [--seed=<n>] [--output=<results.json|results.csv>]
+ *                         [viewer options]
+ * The viewer options that shape the build and the culling (--sort,
+ * --morton-bits, --point-format, --cull, --lod, --build) are accepted as
+ * well. Every build stage is submitted and waited for on its own, so the
+ * stage times add up to more than an untimed build takes.
+ */
+
+namespace {
+
+/// Half the side of the cube the synthetic points are generated in (viewer units).
+constexpr float BENCH_HALF_EXTENT = 200.0f;
+
+/// Resolution of the offscreen render target, the viewer's window size.
+constexpr uint32_t BENCH_WIDTH = 1600;
+constexpr uint32_t BENCH_HEIGHT = 900;
+
+/// Untimed frames before the measured ones, to settle pipeline creation and caches.
+constexpr uint32_t BENCH_WARMUP_FRAMES = 5;
+
+/// Gaussian clusters of the clustered distribution.
+constexpr uint32_t BENCH_CLUSTER_COUNT = 64;
+
+/// Points per chunk of the parallel generation.
+constexpr size_t BENCH_GENERATE_GRAIN = 1 << 16;
+
+enum class Distribution {
+    uniform,   ///< Uniform in a cube, the worst case for voxel compaction.
+    clustered, ///< Gaussian blobs, dense voxels separated by empty space.
+    terrain    ///< A height field, points on a 2D manifold like airborne scans.
+};
+
+struct BenchOptions {
+    std::vector<uint64_t> pointCounts{1'000'000};
+    std::vector<Distribution> distributions{Distribution::uniform, Distribution::clustered, Distribution::terrain};
+    uint32_t frames = 60;
+    uint64_t seed = 1;
+    std::string outputPath = "bench_results.json";
+};
+
+/// Summary of one timed quantity over the measured frames.
+struct Summary {
+    double mean = 0.0;
+    double median = 0.0;
+    double p95 = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+struct RunResult {
+    Distribution distribution;
+    uint64_t points = 0;
+    uint32_t voxels = 0;
+    uint32_t cutNodes = 0;
+    double generateMs = 0.0;
+    double uploadMs = 0.0;
+    std::vector<LPCStageTiming> buildStages;
+    Summary cull;
+    Summary draw;
+    double visiblePoints = 0.0;  ///< Mean over the measured frames.
+    double nodesVisited = 0.0;
+    double pointsTested = 0.0;
+};
+
+const char* toString(Distribution distribution) {
+    switch (distribution) {
+        case Distribution::uniform: return "uniform";
+        case Distribution::clustered: return "clustered";
+        case Distribution::terrain: return "terrain";
+    }
+    return "";
+}
+
+const char* toString(SortAlgorithm sort) { return sort == SortAlgorithm::radix ? "radix" : "bitonic"; }
+const char* toString(CullingMode mode) { return mode == CullingMode::tree ? "tree" : "points"; }
+const char* toString(CullOutput output) { return output == CullOutput::indices ? "indices" : "points"; }
+const char* toString(RenderMode mode) { return mode == RenderMode::compute ? "compute" : "quads"; }
+
+const char* toString(PointFormat format) {
+    switch (format) {
+        case PointFormat::full: return "full";
+        case PointFormat::compact: return "compact";
+        case PointFormat::soa: return "soa";
+    }
+    return "";
+}
+
+const char* toString(BuildBackend backend) {
+    switch (backend) {
+        case BuildBackend::gpu: return "gpu";
+        case BuildBackend::cpu: return "cpu";
+        case BuildBackend::validate: return "validate";
+    }
+    return "";
+}
+
+/// Splits a comma separated option value.
+std::vector<std::string_view> splitList(std::string_view value) {
+    std::vector<std::string_view> items;
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        items.push_back(value.substr(0, comma));
+        value = comma == std::string_view::npos ? std::string_view{} : value.substr(comma + 1);
+    }
+    return items;
+}
+
+/// Parses a point count with an optional K, M or G suffix, e.g. "500M" or "2.5M".
+uint64_t parsePointCount(std::string_view value) {
+    double scale = 1.0;
+    if (!value.empty()) {
+        switch (value.back()) {
+            case 'K': case 'k': scale = 1e3; break;
+            case 'M': case 'm': scale = 1e6; break;
+            case 'G': case 'g': scale = 1e9; break;
+            default: break;
+        }
+        if (scale != 1.0) value.remove_suffix(1);
+    }
+    double count = 0.0;
+    size_t parsed = 0;
+    try {
+        count = std::stod(std::string(value), &parsed) * scale;
+    } catch (const std::exception&) {
+        parsed = 0;
+    }
+    if (parsed != value.size() || count < 1.0 || count > 0xFFFFFFFFu) {
+        throw std::invalid_argument("Invalid point count: " + std::string(value));
+    }
+    return static_cast<uint64_t>(count);
+}
+
+Distribution parseDistribution(std::string_view value) {
+    if (value == "uniform") return Distribution::uniform;
+    if (value == "clustered") return Distribution::clustered;
+    if (value == "terrain") return Distribution::terrain;
+    throw std::invalid_argument("Invalid distribution: " + std::string(value) + " (expected uniform, clustered or terrain)");
+}
+
+uint64_t parseUnsigned(std::string_view name, std::string_view value) {
+    size_t parsed = 0;
+    uint64_t result = 0;
+    try {
+        result = std::stoull(std::string(value), &parsed);
+    } catch (const std::exception&) {
+        parsed = 0;
+    }
+    if (value.empty() || parsed != value.size()) {
+        throw std::invalid_argument("Invalid value for " + std::string(name) + ": " + std::string(value));
+    }
+    return result;
+}
+
+/// Takes the benchmark options out of args, leaving the viewer options.
+BenchOptions parseBenchOptions(std::vector<std::string>& args) {
+    BenchOptions options;
+    std::vector<std::string> remaining;
+    for (const std::string& arg : args) {
+        std::string_view view(arg);
+        size_t eq = view.find('=');
+        std::string_view name = view.substr(0, eq);
+        std::string_view value = eq == std::string_view::npos ? std::string_view{} : view.substr(eq + 1);
+
+        if (name == "--points") {
+            options.pointCounts.clear();
+            for (std::string_view item : splitList(value)) options.pointCounts.push_back(parsePointCount(item));
+        } else if (name == "--distribution") {
+            options.distributions.clear();
+            for (std::string_view item : splitList(value)) options.distributions.push_back(parseDistribution(item));
+        } else if (name == "--frames") {
+            options.frames = static_cast<uint32_t>(std::max<uint64_t>(parseUnsigned(name, value), 1));
+        } else if (name == "--seed") {
+            options.seed = parseUnsigned(name, value);
+        } else if (name == "--output") {
+            if (value.empty()) throw std::invalid_argument("--output requires a path");
+            options.outputPath = std::string(value);
+        } else {
+            remaining.push_back(arg);
+        }
+    }
+    if (options.pointCounts.empty() || options.distributions.empty()) {
+        throw std::invalid_argument("--points and --distribution need at least one value");
+    }
+    args = std::move(remaining);
+    return options;
+}
+
+/// splitmix64: a counter based generator, so every point is reproducible regardless of the thread generating it.
+struct Random {
+    uint64_t state;
+
+    Random(uint64_t seed, uint64_t stream) : state(seed * 0x9E3779B97F4A7C15ull ^ (stream + 0x632BE59BD9B4E019ull)) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    /// Uniform in [0, 1).
+    float uniform() { return static_cast<float>(next() >> 40) * 0x1.0p-24f; }
+
+    /// Standard normal (Box-Muller).
+    float normal() {
+        float u = std::max(uniform(), 1e-7f);
+        float v = uniform();
+        return std::sqrt(-2.0f * std::log(u)) * std::cos(2.0f * std::numbers::pi_v<float> * v);
+    }
+};
+
+/// Height of the terrain distribution: a few octaves of waves, about +-10% of the extent.
+float terrainHeight(float x, float z) {
+    float height = 0.0f;
+    float amplitude = 0.06f * BENCH_HALF_EXTENT;
+    float frequency = 1.5f / BENCH_HALF_EXTENT;
+    for (int octave = 0; octave < 4; ++octave) {
+        height += amplitude * std::sin(x * frequency + octave) * std::cos(z * frequency * 1.3f - octave);
+        amplitude *= 0.45f;
+        frequency *= 2.1f;
+    }
+    return height;
+}
+
+/**
+ * @brief Generates a synthetic cloud, in parallel and deterministic for a given seed.
+ */
+PointAttributes generateCloud(Distribution distribution, uint64_t count, uint64_t seed, ThreadPool& pool) {
+    PointAttributes points;
+    points.resize(count);
+
+    struct Cluster { glm::vec3 center; float sigma; glm::vec3 color; };
+    std::vector<Cluster> clusters(BENCH_CLUSTER_COUNT);
+    for (uint32_t c = 0; c < BENCH_CLUSTER_COUNT; ++c) {
+        Random random(seed, ~static_cast<uint64_t>(c));
+        glm::vec3 center{random.uniform(), random.uniform(), random.uniform()};
+        clusters[c].center = (center * 2.0f - 1.0f) * (0.8f * BENCH_HALF_EXTENT);
+        clusters[c].sigma = (0.01f + 0.05f * random.uniform()) * BENCH_HALF_EXTENT;
+        clusters[c].color = {random.uniform(), random.uniform(), random.uniform()};
+    }
+
+    pool.parallelFor(count, BENCH_GENERATE_GRAIN, [&](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Random random(seed, i);
+            glm::vec3 position;
+            glm::vec3 color;
+            switch (distribution) {
+                case Distribution::uniform: {
+                    glm::vec3 unit{random.uniform(), random.uniform(), random.uniform()};
+                    position = (unit * 2.0f - 1.0f) * BENCH_HALF_EXTENT;
+                    color = unit;
+                    break;
+                }
+                case Distribution::clustered: {
+                    const Cluster& cluster = clusters[random.next() % BENCH_CLUSTER_COUNT];
+                    glm::vec3 offset{random.normal(), random.normal(), random.normal()};
+                    position = glm::clamp(cluster.center + offset * cluster.sigma,
+                                          glm::vec3(-BENCH_HALF_EXTENT), glm::vec3(BENCH_HALF_EXTENT));
+                    color = cluster.color;
+                    break;
+                }
+                case Distribution::terrain: {
+                    float x = (random.uniform() * 2.0f - 1.0f) * BENCH_HALF_EXTENT;
+                    float z = (random.uniform() * 2.0f - 1.0f) * BENCH_HALF_EXTENT;
+                    position = {x, terrainHeight(x, z) + 0.1f * random.normal(), z};
+                    float t = glm::clamp(position.y / (0.2f * BENCH_HALF_EXTENT) + 0.5f, 0.0f, 1.0f);
+                    color = glm::mix(glm::vec3(0.2f, 0.45f, 0.15f), glm::vec3(0.9f, 0.9f, 0.85f), t);
+                    break;
+                }
+            }
+            points.positions[i] = position;
+            points.colors[i] = color;
+            points.intensities[i] = random.uniform();
+        }
+    });
+    return points;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+Summary summarize(std::vector<double> samples) {
+    Summary summary;
+    if (samples.empty()) return summary;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples) sum += sample;
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+        return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+    };
+    summary.mean = sum / samples.size();
+    summary.median = percentile(0.5);
+    summary.p95 = percentile(0.95);
+    summary.min = samples.front();
+    summary.max = samples.back();
+    return summary;
+}
+
+/**
+ * @brief Offscreen copy of the viewer's point pass: same shaders and bindings, drawn into a texture.
+ *
+ * With --render=compute, the compute rasterizer takes the place of the quads.
+ */
+struct OffscreenPointPass {
+    tga::Interface& tgai;
+    const PointCloud& pointCloud;
+    tga::Texture target;
+    tga::Shader vertShader;
+    tga::Shader fragShader;
+    tga::RenderPass renderPass;
+    tga::InputSet inputSet;
+    std::unique_ptr<PointRasterizer> rasterizer;
+
+    OffscreenPointPass(tga::Interface& _tgai, const PointCloud& _pointCloud, const Config& config, const Camera& camera)
+        : tgai(_tgai), pointCloud(_pointCloud) {
+        target = tgai.createTexture(tga::TextureInfo(BENCH_WIDTH, BENCH_HEIGHT, tga::Format::r8g8b8a8_unorm));
+
+        // Without the skybox pass in front, the point pass clears the target itself
+        if (config.renderMode == RenderMode::compute) {
+            rasterizer = std::make_unique<PointRasterizer>(tgai, pointCloud, camera.getUbos(), target,
+                                                           BENCH_WIDTH, BENCH_HEIGHT, tga::ClearOperation::all);
+            return;
+        }
+
+        vertShader = tga::loadShader(shaderPath(pointCloud, "bunny_primitive", SHADER_POINT_FORMAT | SHADER_CULL_OUTPUT, "vert"),
+                                     tga::ShaderType::vertex, tgai);
+        fragShader = tga::loadShader("shaders/bunny_primitive_frag.spv", tga::ShaderType::fragment, tgai);
+
+        std::vector<tga::BindingLayout> layouts;
+        std::vector<tga::Binding> bindings;
+        getPointDrawBindings(pointCloud, camera.getUbo(), 0, layouts, bindings);
+
+        renderPass = tgai.createRenderPass({
+            vertShader, fragShader, target, {},
+            tga::InputLayout{layouts},
+            tga::ClearOperation::all,
+            tga::PerPixelOperations{tga::CompareOperation::less, false},
+            tga::RasterizerConfig{tga::FrontFace::counterclockwise, tga::CullMode::back}
+        });
+        inputSet = tgai.createInputSet({renderPass, bindings, 0});
+    }
+
+    ~OffscreenPointPass() {
+        rasterizer.reset();
+        if (inputSet) tgai.free(inputSet);
+        if (renderPass) tgai.free(renderPass);
+        if (fragShader) tgai.free(fragShader);
+        if (vertShader) tgai.free(vertShader);
+        tgai.free(target);
+    }
+
+    /// Records the drawing of the culled points into the target.
+    void record(tga::CommandRecorder& recorder) {
+        if (rasterizer) {
+            rasterizer->recordRaster(recorder, 0);
+            rasterizer->recordResolve(recorder, 0, 0);
+            return;
+        }
+        recorder.setRenderPass(renderPass, 0)
+                .bindInputSet(inputSet)
+                .drawIndirect(pointCloud.getIndirectBuffer(), 1, 0, sizeof(tga::DrawIndirectCommand));
+    }
+
+    OffscreenPointPass(const OffscreenPointPass&) = delete;
+    OffscreenPointPass& operator=(const OffscreenPointPass&) = delete;
+};
+
+/// Submits a recorded command buffer and returns the time until it has completed.
+double submitTimed(tga::Interface& tgai, tga::CommandBuffer cmd) {
+    auto start = std::chrono::steady_clock::now();
+    tgai.execute(cmd);
+    tgai.waitForCompletion(cmd);
+    return millisecondsSince(start);
+}
+
+RunResult runBenchmark(tga::Interface& tgai, const Config& config, const BenchOptions& options,
+                       Distribution distribution, uint64_t count, ThreadPool& pool) {
+    RunResult result;
+    result.distribution = distribution;
+    result.points = count;
+    std::cout << "=== " << toString(distribution) << ", " << count << " points ===" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    PointAttributes points = generateCloud(distribution, count, options.seed, pool);
+    result.generateMs = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    PointCloud pointCloud(tgai, std::move(points), config);
+    result.uploadMs = millisecondsSince(start);
+
+    buildLayeredPointCloud(tgai, pointCloud, config, &result.buildStages);
+    result.voxels = pointCloud.getUniqueCount();
+    result.cutNodes = pointCloud.getCullCutCount();
+
+    Camera camera(tgai);
+    FrustumCuller culler(tgai, pointCloud, config, camera.getUbos(), BENCH_WIDTH, BENCH_HEIGHT);
+    OffscreenPointPass pointPass(tgai, pointCloud, config, camera);
+    tga::StagingBuffer drawReadback = tgai.createStagingBuffer({sizeof(tga::DrawIndirectCommand)});
+
+    // Orbit the cloud once over the measured frames, looking slightly down at its center
+    const AABB& bounds = pointCloud.getBounds();
+    const glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+    const float radius = 1.2f * glm::length(bounds.max - bounds.min) * 0.5f + 1.0f;
+    const float aspect = static_cast<float>(BENCH_WIDTH) / static_cast<float>(BENCH_HEIGHT);
+
+    std::vector<double> cullTimes, drawTimes;
+    tga::CommandBuffer cullCmd{};
+    tga::CommandBuffer drawCmd{};
+    for (uint32_t frame = 0; frame < BENCH_WARMUP_FRAMES + options.frames; ++frame) {
+        float angle = 2.0f * std::numbers::pi_v<float> * frame / options.frames;
+        glm::vec3 eye = center + glm::vec3(std::cos(angle), 0.5f, std::sin(angle)) * radius;
+
+        {
+            tga::CommandRecorder recorder{tgai, cullCmd};
+            camera.lookAt(recorder, eye, center, aspect);
+            recorder.barrier(tga::PipelineStage::Transfer, tga::PipelineStage::ComputeShader);
+            culler.record(recorder);
+            recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::Transfer);
+            recorder.bufferDownload(pointCloud.getIndirectBuffer(), drawReadback, sizeof(tga::DrawIndirectCommand));
+            cullCmd = recorder.endRecording();
+        }
+        double cullMs = submitTimed(tgai, cullCmd);
+
+        {
+            tga::CommandRecorder recorder{tgai, drawCmd};
+            pointPass.record(recorder);
+            drawCmd = recorder.endRecording();
+        }
+        double drawMs = submitTimed(tgai, drawCmd);
+
+        if (frame < BENCH_WARMUP_FRAMES) continue;
+        cullTimes.push_back(cullMs);
+        drawTimes.push_back(drawMs);
+
+        tga::DrawIndirectCommand drawn{};
+        std::memcpy(&drawn, tgai.getMapping(drawReadback), sizeof(drawn));
+        CullStats stats = culler.getStats();
+        result.visiblePoints += drawn.instanceCount;
+        result.nodesVisited += stats.nodesVisited;
+        result.pointsTested += stats.pointsTested;
+    }
+    tgai.free(drawCmd);
+    tgai.free(cullCmd);
+    tgai.free(drawReadback);
+
+    result.cull = summarize(cullTimes);
+    result.draw = summarize(drawTimes);
+    result.visiblePoints /= options.frames;
+    result.nodesVisited /= options.frames;
+    result.pointsTested /= options.frames;
+
+    double buildMs = 0.0;
+    for (const LPCStageTiming& timing : result.buildStages) buildMs += timing.milliseconds;
+    std::cout << std::fixed << std::setprecision(2)
+              << "build " << buildMs << " ms, cull " << result.cull.median << " ms, draw " << result.draw.median
+              << " ms (median), " << static_cast<uint64_t>(result.visiblePoints) << " visible points" << std::endl;
+    return result;
+}
+
+std::string currentTimestamp() {
+    std::time_t now = std::time(nullptr);
+    std::tm utc{};
+    gmtime_r(&now, &utc);
+    std::ostringstream out;
+    out << std::put_time(&utc, "%Y-%m-%dT%H:%M:%SZ");
+    return out.str();
+}
+
+void writeSummaryJson(std::ostream& out, const Summary& summary) {
+    out << "{\"meanMs\": " << summary.mean << ", \"medianMs\": " << summary.median << ", \"p95Ms\": " << summary.p95
+        << ", \"minMs\": " << summary.min << ", \"maxMs\": " << summary.max << "}";
+}
+
+void writeJson(std::ostream& out, const Config& config, const BenchOptions& options, const std::vector<RunResult>& results) {
+    out << std::fixed << std::setprecision(4);
+    out << "{\n"
+        << "  \"benchmark\": \"pointspire-bench\",\n"
+        << "  \"revision\": \"" << POINTSPIRE_REVISION << "\",\n"
+        << "  \"timestamp\": \"" << currentTimestamp() << "\",\n"
+        << "  \"config\": {\"sort\": \"" << toString(config.sortAlgorithm) << "\", \"mortonBits\": " << config.mortonBits
+        << ", \"pointFormat\": \"" << toString(config.pointFormat) << "\", \"cull\": \"" << toString(config.cullingMode)
+        << "\", \"cullOutput\": \"" << toString(config.cullOutput) << "\", \"render\": \"" << toString(config.renderMode)
+        << "\", \"lod\": " << config.lodPixelThreshold << ", \"occlusion\": " << (config.occlusionCulling ? "true" : "false")
+        << ", \"build\": \"" << toString(config.buildBackend)
+        << "\", \"frames\": " << options.frames << ", \"width\": " << BENCH_WIDTH << ", \"height\": " << BENCH_HEIGHT
+        << ", \"seed\": " << options.seed << "},\n"
+        << "  \"runs\": [";
+    for (size_t r = 0; r < results.size(); ++r) {
+        const RunResult& run = results[r];
+        out << (r ? ",\n" : "\n")
+            << "    {\"distribution\": \"" << toString(run.distribution) << "\", \"points\": " << run.points
+            << ", \"voxels\": " << run.voxels << ", \"cutNodes\": " << run.cutNodes
+            << ", \"generateMs\": " << run.generateMs << ", \"uploadMs\": " << run.uploadMs << ",\n"
+            << "     \"build\": [";
+        for (size_t s = 0; s < run.buildStages.size(); ++s) {
+            out << (s ? ", " : "") << "{\"stage\": \"" << run.buildStages[s].stage << "\", \"ms\": "
+                << run.buildStages[s].milliseconds << "}";
+        }
+        out << "],\n     \"cull\": ";
+        writeSummaryJson(out, run.cull);
+        out << ",\n     \"draw\": ";
+        writeSummaryJson(out, run.draw);
+        out << ",\n     \"visiblePoints\": " << run.visiblePoints << ", \"nodesVisited\": " << run.nodesVisited
+            << ", \"pointsTested\": " << run.pointsTested << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+/// One row per measurement: distribution,points,metric,value (milliseconds unless the metric is a count).
+void writeCsv(std::ostream& out, const std::vector<RunResult>& results) {
+    out << std::fixed << std::setprecision(4);
+    out << "distribution,points,metric,value\n";
+    for (const RunResult& run : results) {
+        auto row = [&](const std::string& metric, double value) {
+            out << toString(run.distribution) << ',' << run.points << ',' << metric << ',' << value << '\n';
+        };
+        row("generate_ms", run.generateMs);
+        row("upload_ms", run.uploadMs);
+        double buildMs = 0.0;
+        for (const LPCStageTiming& timing : run.buildStages) {
+            row("build." + timing.stage + "_ms", timing.milliseconds);
+            buildMs += timing.milliseconds;
+        }
+        row("build.total_ms", buildMs);
+        for (auto [name, summary] : {std::pair{"cull", run.cull}, std::pair{"draw", run.draw}}) {
+            row(std::string(name) + ".mean_ms", summary.mean);
+            row(std::string(name) + ".median_ms", summary.median);
+            row(std::string(name) + ".p95_ms", summary.p95);
+            row(std::string(name) + ".min_ms", summary.min);
+            row(std::string(name) + ".max_ms", summary.max);
+        }
+        row("voxels", run.voxels);
+        row("cut_nodes", run.cutNodes);
+        row("visible_points", run.visiblePoints);
+        row("nodes_visited", run.nodesVisited);
+        row("points_tested", run.pointsTested);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        std::vector<std::string> args(argv + std::min(argc, 1), argv + argc);
+        BenchOptions options = parseBenchOptions(args);
+
+        // Generated clouds live in host memory and are never cached
+        args.insert(args.begin(), {std::string(argv[0]), "--load=memory", "--cache=off"});
+        std::vector<char*> forwarded;
+        for (std::string& arg : args) forwarded.push_back(arg.data());
+        Config config = parseCommandLine(static_cast<int>(forwarded.size()), forwarded.data());
+        config.framesInFlight = 1; // Frames are timed one at a time
+
+        tga::Interface tgai;
+        ThreadPool pool;
+        std::vector<RunResult> results;
+        for (Distribution distribution : options.distributions) {
+            for (uint64_t count : options.pointCounts) {
+                results.push_back(runBenchmark(tgai, config, options, distribution, count, pool));
+            }
+        }
+
+        std::ofstream out(options.outputPath);
+        if (!out) throw std::runtime_error("Cannot write " + options.outputPath);
+        if (std::string_view(options.outputPath).ends_with(".csv")) {
+            writeCsv(out, results);
+        } else {
+            writeJson(out, config, options, results);
+        }
+        std::cout << "Wrote " << options.outputPath << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal Error: " << e.what() << "\n";
+        return -1;
+    }
+    return 0;
+}
@@ -3,12 +3,21 @@
 #define POINTSPIRE_APPLICATION_HPP
 
 #include "tga/tga.hpp"
+#include <array>
+#include <chrono>
 #include <memory>
-#include <utility> // For std::pair
+#include <string>
+#include <vector>
 
+#include "Config.hpp"
+#include "FrameProfiler.hpp"
+#include "GpuUtils.hpp"
 #include "PointCloud.hpp"
 #include "Camera.hpp"
+#include "FrustumCuller.hpp"
+#include "PointRasterizer.hpp"
 #include "Scene.hpp"
+#include "TileManager.hpp"
 
 /**
  * @brief The main application class orchestrating the rendering engine.
@@ -22,8 +31,9 @@ struct Application {
     /// @name Core Resources
     /// @{
     tga::Interface& tgai;           ///< Reference to the TGA Vulkan wrapper interface.
+    Config config;                  ///< Options parsed from the command line.
     tga::Window window;             ///< The OS window handle.
-    tga::CommandBuffer commandBuffer; ///< Recyclable command buffer for frame commands.
+    std::vector<tga::CommandBuffer> commandBuffers; ///< Recyclable command buffer of every frame in flight.
     /// @}
 
     /// @name Point Cloud Render Pipeline
@@ -31,7 +41,7 @@ struct Application {
     tga::Shader pcVertShader;       ///< Vertex shader for point sprites (quads).
     tga::Shader pcFragShader;       ///< Fragment shader for point coloring.
     tga::RenderPass pcRenderPass;   ///< Pass config: Loads previous buffer, Writes Depth.
-    tga::InputSet pcInputSet;       ///< Bindings: Camera UBO, Visible Point Storage Buffer.
+    std::vector<tga::InputSet> pcInputSets; ///< Per frame in flight. Bindings: Camera UBO, Visible Point Storage Buffer.
     /// @}
 
     /// @name Skybox Render Pipeline
@@ -39,24 +49,27 @@ struct Application {
     tga::Shader skyVertShader;      ///< Vertex shader for the skybox cube.
     tga::Shader skyFragShader;      ///< Fragment shader for cubemap sampling.
     tga::RenderPass skyRenderPass;  ///< Pass config: Clears screen, Read-Only Depth.
-    tga::InputSet skyInputSet;      ///< Bindings: Camera UBO, Cubemap Texture.
+    std::vector<tga::InputSet> skyInputSets; ///< Per frame in flight. Bindings: Camera UBO, Cubemap Texture.
     /// @}
 
     /// @name Logical Components
     /// @{
-    PointCloud pointCloud;          ///< Manages point data, normalization, and buffers.
+    std::unique_ptr<PointCloud> pointCloud; ///< Manages point data, normalization, and buffers; null with --tiles.
+    std::unique_ptr<TileManager> tiles;     ///< Streams the tiles of a --tiles dataset, null otherwise.
     Camera camera;                  ///< Manages view/projection matrices and input.
     Scene scene;                    ///< Manages background assets (Skybox).
     /// @}
 
     /// @name Compute Culling Pipeline
     /// @{
-    tga::Shader cullingShader;      ///< Compute shader for frustum culling and compaction.
-    tga::Buffer cullingBuffer;      ///< (Unused variable/placeholder).
-    tga::ComputePass cullPass;      ///< Pipeline state for the compute shader.
-    tga::InputSet cullInputSet;     ///< Bindings: Cam, Source, Visible, Indirect, Info.
+    std::unique_ptr<FrustumCuller> culler; ///< Fills the visible buffer, created once the LPC is built; null with --tiles.
+    std::unique_ptr<PointRasterizer> rasterizer; ///< Draws the visible points with --render=compute, null for quads.
+    std::vector<uint64_t> culledRevisions; ///< Per frame in flight: camera revision its culling output was computed for, 0 if none.
+    uint32_t reprojectedFrames = 0; ///< Frames reprojected in a row since the last full one (--reproject).
     /// @}
 
+    std::unique_ptr<FrameProfiler> profiler; ///< Per-pass timings (--profile), null when profiling is off.
+
     /**
      * @brief Initializes the application, window, and all GPU resources.
      *
@@ -64,8 +77,9 @@ struct Application {
      * the compute pipeline for frustum culling.
      *
      * @param _tgai Reference to the initialized TGA interface.
+     * @param _config Options parsed from the command line.
      */
-    Application(tga::Interface& _tgai);
+    Application(tga::Interface& _tgai, const Config& _config = {});
 
     ~Application();
 
@@ -77,40 +91,20 @@ struct Application {
      */
     void run();
 
+    std::chrono::high_resolution_clock::time_point m_lastTitleUpdate{}; ///< Throttles the culling stats in the title.
+
     /**
-     * @brief Calculates 2D dispatch dimensions to bypass hardware limits.
-     *
-     * Most GPUs limit the X dimension of a dispatch group to 65535. This helper
-     * converts a large 1D total count into a 2D (X, Y) grid layout.
-     *
-     * @param numThreads The total number of items (points) to process.
-     * @param workGroupSize The local workgroup size defined in the shader (default 256).
-     * @return std::pair<uint32_t, uint32_t> The {GroupCountX, GroupCountY} dimensions.
+     * @brief Shows the culling counters (and the pass timings when profiling) in the window title, at most once per second.
+     * @param now The timestamp of the current frame.
+     * @param frame The frame in flight, whose last use has completed.
      */
-    std::pair<uint32_t, uint32_t> getDispatchDimensions(size_t numThreads, uint32_t workGroupSize = 256);
+    void updateCullStatsTitle(std::chrono::high_resolution_clock::time_point now, uint32_t frame);
 
-    struct LayeredPointCloudPasses {
-        tga::ComputePass mortonPass;
-        tga::ComputePass bitonicSortPass;
-        tga::ComputePass reorderPass;
-        tga::ComputePass markHeadsPass;
-        tga::ComputePass scatterPass;
-        tga::ComputePass initLeavesPass;
-        tga::ComputePass buildInternalPass;
-    } m_lpcPasses;
-
-    struct LayeredPointCloudSets {
-        tga::InputSet mortonSet;
-        tga::InputSet bitonicSortSet;
-        tga::InputSet reorderSet;
-        tga::InputSet markHeadsSet;
-        tga::InputSet scatterSet;
-        tga::InputSet initLeavesSet;
-        tga::InputSet buildInternalSet;
-    } m_lpcInputSets;
-
-    void createLPCPipelines();
-    void buildLPC();
+    /**
+     * @brief Shows the tile residency counters in the window title, at most once per second.
+     * @param now The timestamp of the current frame.
+     */
+    void updateTileStatsTitle(std::chrono::high_resolution_clock::time_point now);
 };
 
 #endif //POINTSPIRE_APPLICATION_HPP
\ No newline at end of file
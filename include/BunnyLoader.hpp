@@ -2,14 +2,56 @@
 #ifndef POINTSPIRE_BUNNYLOADER_HPP
 #define POINTSPIRE_BUNNYLOADER_HPP
 
-#include <vector>
+#include <cstddef>
 #include <string>
+#include <vector>
 #include <tga/tga_math.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+constexpr size_t PLY_TRANSFORM_BATCH = 1024; ///< Vertices parsed before one batched transform into the output.
 
-struct PositionVertex {
-    alignas(16) glm::vec3 position;
+/**
+ * @brief One registered scan of a bun.conf file (a `bmesh` line).
+ */
+struct BunnyScan {
+    std::string filename;   ///< PLY file, relative to the PLY directory.
+    glm::vec3 translation;
+    glm::quat rotation;     ///< Rotation into the common frame, applied before the translation.
 };
 
-std::vector<PositionVertex> loadBunny(const std::string& confFilePath, const std::string& plyDirectory);
+/**
+ * @brief Whether a path names a registered scan set (a .conf file) rather than a LAS/LAZ file.
+ *
+ * @param path The input path.
+ * @return True for the .conf extension.
+ */
+bool isBunnyConf(const std::string& path);
+
+/**
+ * @brief Reads the `bmesh` entries of a bun.conf file, in file order.
+ *
+ * @param confFilePath The path to the .conf file.
+ * @return The scans; throws std::runtime_error if the file cannot be opened.
+ */
+std::vector<BunnyScan> parseBunnyConf(const std::string& confFilePath);
+
+/**
+ * @brief Loads the vertex positions of all scans of a bun.conf file into the common frame.
+ *
+ * The PLY files are memory-mapped and parsed concurrently, one scan per
+ * task: all headers first, which gives every scan its offset in the presized
+ * output, then the bodies. Binary PLYs (either endianness) are read straight
+ * from the mapping; ASCII PLYs are parsed with std::from_chars. Positions are
+ * gathered in batches of PLY_TRANSFORM_BATCH and transformed by the scan
+ * rotation and translation in one pass per batch.
+ *
+ * Missing or malformed scans are reported and skipped. Prints the throughput
+ * in MB/s of mapped PLY data when done.
+ *
+ * @param confFilePath The path to the .conf file.
+ * @param plyDirectory The directory the PLY file names are relative to.
+ * @return The positions of all scans, in conf order.
+ */
+std::vector<glm::vec3> loadBunny(const std::string& confFilePath, const std::string& plyDirectory);
 
-#endif //POINTSPIRE_BUNNYLOADER_HPP
\ No newline at end of file
+#endif //POINTSPIRE_BUNNYLOADER_HPP
@@ -4,6 +4,7 @@
 
 #include <tga/tga.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <vector>
 
 // Forward declare to avoid including the header
 namespace tga {
@@ -14,17 +15,54 @@ namespace tga {
 
 class Camera {
 public:
-    Camera(tga::Interface& tgai);
+    /**
+     * @param tgai Reference to the TGA interface for resource creation.
+     * @param frameCount Number of frames in flight, each gets its own uniform buffer.
+     */
+    Camera(tga::Interface& tgai, uint32_t frameCount = 1);
     ~Camera();
 
     // Prevent copying
     Camera(const Camera&) = delete;
     Camera& operator=(const Camera&) = delete;
 
-    void update(tga::CommandRecorder& recorder, tga::Window& window, float dt);
-    tga::Buffer getUbo() const;
+    void update(tga::CommandRecorder& recorder, tga::Window& window, float dt, uint32_t frame = 0);
+
+    /**
+     * @brief Places the camera for scripted views, e.g. benchmark flights without a window.
+     *
+     * Keyboard updates continue from the new pose.
+     *
+     * @param recorder The recorder the uniform buffer update is recorded into.
+     * @param position The eye position.
+     * @param target The point looked at.
+     * @param aspect Width over height of the render target.
+     * @param frame The frame in flight whose uniform buffer is written.
+     */
+    void lookAt(tga::CommandRecorder& recorder, const glm::vec3& position, const glm::vec3& target, float aspect,
+                uint32_t frame = 0);
+
+    tga::Buffer getUbo(uint32_t frame = 0) const;
+    const std::vector<tga::Buffer>& getUbos() const { return uniformBuffers; }
+
+    /**
+     * @brief Gets a counter that changes whenever an upload changed the matrices.
+     *
+     * Frames uploaded with the same revision see the same camera, so their culling results are interchangeable.
+     *
+     * @return The revision of the last uploaded matrices, 0 before the first upload.
+     */
+    uint64_t getRevision() const { return revision; }
+
+    /// Gets proj * view * model of the last upload, for culling on the host.
+    glm::mat4 getViewProjection() const { return cameraData.proj * cameraData.view * cameraData.model; }
+
+    /// Gets the eye position.
+    const glm::vec3& getPosition() const { return pos; }
 
 private:
+    void upload(tga::CommandRecorder& recorder, float aspect, uint32_t frame);
+
     tga::Interface& tgai;
 
     struct CameraData {
@@ -32,8 +70,9 @@ private:
         alignas(16) glm::mat4 view;
         alignas(16) glm::mat4 proj;
     };
-    CameraData cameraData;
-    tga::Buffer uniformBuffer;
+    CameraData cameraData{};
+    uint64_t revision = 0; ///< Incremented by every upload that changes cameraData.
+    std::vector<tga::Buffer> uniformBuffers; ///< One per frame in flight.
 
     // State
     glm::vec3 pos{100.0f, 100.0f, 100.0f};//{631680, 5.26862e+06, 950.0f};
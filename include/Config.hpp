@@ -0,0 +1,128 @@
+#pragma once
+#ifndef POINTSPIRE_CONFIG_HPP
+#define POINTSPIRE_CONFIG_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Algorithm used to sort the Morton codes during the LPC build.
+ */
+enum class SortAlgorithm {
+    radix,   ///< Multi-pass LSD radix sort with a fixed number of passes.
+    bitonic  ///< Legacy bitonic network, one dispatch per (j, k) stage.
+};
+
+/**
+ * @brief How the per-frame frustum culling finds the visible points.
+ */
+enum class CullingMode {
+    tree,   ///< Walk the LPC hierarchy and only test points of straddling leaves.
+    points  ///< Test every point of the dataset.
+};
+
+/**
+ * @brief What the frustum culling writes for the draw pass.
+ */
+enum class CullOutput {
+    points, ///< Copy every visible point into the visible buffer (a full point per visible point).
+    indices ///< Write the 32-bit index of every visible point, the vertex shader fetches it from the source buffer.
+};
+
+/**
+ * @brief How the visible points are drawn.
+ */
+enum class RenderMode {
+    quads,  ///< One instanced quad per point through the hardware rasterizer.
+    compute ///< Compute-shader rasterization to one pixel per point with 64-bit atomics, resolved into the target.
+};
+
+/**
+ * @brief Layout of the points in GPU memory.
+ */
+enum class PointFormat {
+    full,    ///< Float position, color and intensity (32 bytes per point).
+    compact, ///< 21-bit quantized position, RGBA8 color, 16-bit intensity (16 bytes per point).
+    soa      ///< Full precision, one buffer per attribute (positions, colors, intensities).
+};
+
+/**
+ * @brief How the point cloud file is brought into GPU memory.
+ */
+enum class LoadMode {
+    memory, ///< Read the whole file into host memory, then upload it at once.
+    stream  ///< Read and upload fixed-size chunks, host memory stays bounded by the chunk size.
+};
+
+/**
+ * @brief Use of the .pspire cache of the built hierarchy.
+ */
+enum class CacheMode {
+    on,     ///< Restore from a matching cache, write one after building otherwise.
+    off,    ///< Always build, never touch the cache file.
+    rebuild ///< Always build, then overwrite the cache file.
+};
+
+/**
+ * @brief Where the LPC hierarchy is built.
+ */
+enum class BuildBackend {
+    gpu,     ///< Compute shaders (LPCBuilder).
+    cpu,     ///< Multi-threaded host implementation (CpuLPCBuilder), uploaded afterwards.
+    validate ///< GPU build, checked against the CPU build.
+};
+
+/// Upper bound of --frames-in-flight; every frame costs a visible buffer as large as the point cloud
+/// (4 bytes per point with --cull-output=indices).
+constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+
+/// Upper bound of --tile-budget in MiB; every arena stream is one storage buffer, which
+/// must stay below the common 4 GiB maxStorageBufferRange.
+constexpr uint32_t MAX_TILE_BUDGET_MB = 4095;
+
+/// Upper bound of --reproject; every reprojection moves the samples to pixel centers, so
+/// longer chains drift further from what the points would draw.
+constexpr uint32_t MAX_REPROJECT_FRAMES = 64;
+
+/**
+ * @brief Runtime options selected on the command line.
+ *
+ * Every field has a sensible default so the viewer can be started without
+ * any arguments.
+ */
+struct Config {
+    SortAlgorithm sortAlgorithm = SortAlgorithm::radix; ///< --sort=radix|bitonic
+    uint32_t mortonBits = 30;                           ///< --morton-bits=30|63 (10 or 21 bits per axis)
+    CullingMode cullingMode = CullingMode::tree;        ///< --cull=tree|points
+    CullOutput cullOutput = CullOutput::points;         ///< --cull-output=points|indices
+    RenderMode renderMode = RenderMode::quads;          ///< --render=quads|compute
+    bool occlusionCulling = false;                      ///< --occlusion=on|off, skip tree nodes behind the drawn points (requires --cull=tree)
+    bool temporalReuse = true;                          ///< --temporal-reuse=on|off, frames with an unchanged camera reuse the last culling
+    uint32_t reprojectFrames = 0;                       ///< --reproject=<frames>, moving frames reuse the previous image and draw only its gaps, at most this many in a row; 0 disables (requires --render=compute, --cull=tree, --frames-in-flight>=2)
+    uint32_t framesInFlight = 2;                        ///< --frames-in-flight=1..4, each frame has its own visible buffer
+    PointFormat pointFormat = PointFormat::full;        ///< --point-format=full|compact|soa
+    float lodPixelThreshold = 0.0f;                     ///< --lod=<pixels>, 0 draws every point (requires --cull=tree)
+    LoadMode loadMode = LoadMode::memory;               ///< --load=memory|stream
+    BuildBackend buildBackend = BuildBackend::gpu;      ///< --build=gpu|cpu|validate (cpu and validate require --load=memory)
+    CacheMode cacheMode = CacheMode::on;                ///< --cache=on|off|rebuild, reuse the built LPC from a .pspire file
+    std::vector<std::string> inputPaths{"assets/neuschwanstein/3DRM_Neuschwanstein.las"}; ///< --input=<file.las|bun.conf>[,...], merged in order, or a single <file.pspire>
+    std::string tilesPath;                              ///< --tiles=<dir|list.txt>, stream a tiled LAS dataset instead of --input (requires --render=quads, --cull-output=points)
+    uint32_t tileBudgetMB = 2048;                       ///< --tile-budget=<MiB>, GPU memory of the resident tiles
+    std::string cachePath;                              ///< --cache-file=<path>, defaults to the first input with a .pspire extension
+    std::string profilePath;                            ///< --profile=<trace.json>, per-pass timings as a Chrome trace, empty disables profiling
+};
+
+/**
+ * @brief Parses the command line into a Config.
+ *
+ * Accepts options of the form `--name=value`.
+ *
+ * @param argc Argument count as passed to main().
+ * @param argv Argument vector as passed to main().
+ * @return The parsed configuration.
+ * @throws std::invalid_argument On unknown options, invalid values or conflicting options.
+ */
+Config parseCommandLine(int argc, char** argv);
+
+#endif //POINTSPIRE_CONFIG_HPP
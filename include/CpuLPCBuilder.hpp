@@ -0,0 +1,122 @@
+#pragma once
+#ifndef POINTSPIRE_CPU_LPC_BUILDER_HPP
+#define POINTSPIRE_CPU_LPC_BUILDER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "LPCBuilder.hpp"
+#include "PointCloud.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * @brief Host copy of a built Layered Point Cloud hierarchy.
+ *
+ * Holds everything the GPU build leaves in the buffers of a PointCloud,
+ * indexed the same way.
+ */
+struct LPCHierarchy {
+    std::vector<uint32_t> order;          ///< Original index of every Morton-sorted point.
+    PointAttributes sortedPoints;         ///< The points in Morton order.
+    std::vector<uint64_t> uniqueCodes;    ///< One Morton key per voxel (the high word is 0 for 30-bit keys).
+    std::vector<uint32_t> voxelStarts;    ///< First sorted point of every voxel.
+    std::vector<Node> nodes;              ///< numUnique - 1 internal nodes followed by numUnique leaves.
+    std::vector<AABB> nodeBounds;         ///< Refitted bounds, indexed like the nodes.
+    PointAttributes proxies;              ///< LOD proxy of every node.
+    std::vector<float> proxySplatSizes;   ///< Splat size of every proxy.
+    std::vector<uint32_t> cutNodes;       ///< Roots of the culling subtrees, ascending.
+
+    uint32_t getUniqueCount() const { return static_cast<uint32_t>(uniqueCodes.size()); }
+
+    /**
+     * @brief Gets the unique codes laid out like the GPU buffer.
+     * @param keySize PointCloud::getMortonKeySize(): uint keys, or uvec2(low, high) keys.
+     * @return The packed keys.
+     */
+    std::vector<uint8_t> packUniqueCodes(size_t keySize) const;
+};
+
+/**
+ * @brief Multi-threaded CPU implementation of the LPC build.
+ *
+ * Runs the same stages as LPCBuilder (Morton keys, stable LSD radix sort,
+ * head flags + scan + compaction, Karras tree construction, bottom-up refit
+ * and the culling cut) on a thread pool, over the points still held in host
+ * memory. It serves as a build backend without GPU compute (--build=cpu)
+ * and as the reference the shaders are validated against (--build=validate).
+ *
+ * The Morton keys use the same correctly rounded float operations as
+ * 1_morton.comp and the tree stages are deterministic, so the unique codes,
+ * voxel starts, Node array and bounds match the GPU build bit for bit. The
+ * sorted points match too with the stable radix sort; the bitonic sort may
+ * order the points of one voxel differently. Proxies are float averages and
+ * only match approximately. Compact points are decoded with
+ * origin + q * step, which a GPU compiler may contract into an FMA.
+ */
+class CpuLPCBuilder {
+public:
+    /**
+     * @brief Prepares a build of a cloud loaded into host memory.
+     *
+     * @param pointCloud The cloud to build, its attributes must still be in host memory (--load=memory).
+     * @param threadCount Worker threads, 0 for one per hardware thread.
+     * @throws std::runtime_error If the cloud holds no host attributes.
+     */
+    explicit CpuLPCBuilder(const PointCloud& pointCloud, unsigned threadCount = 0);
+
+    /**
+     * @brief Runs the whole build.
+     * @param timings If given, the time of every stage is appended.
+     * @return The hierarchy, ready for PointCloud::uploadLPC().
+     */
+    LPCHierarchy build(std::vector<LPCStageTiming>* timings = nullptr);
+
+    /**
+     * @brief Computes the Morton key of a position exactly like 1_morton.comp.
+     *
+     * @param position The point position.
+     * @param boundsMin The minimum of the cloud bounds.
+     * @param scale The result of computeMortonScale() for the bounds.
+     * @param bitsPerAxis 10 for 30-bit keys, 21 for 63-bit keys.
+     * @return The key, x in the most significant bit of every triple.
+     */
+    static uint64_t mortonKey(const glm::vec3& position, const glm::vec3& boundsMin,
+                              const glm::vec3& scale, uint32_t bitsPerAxis);
+
+private:
+    /// Positions as the shaders see them: decoded from the quantization grid in the compact format.
+    std::vector<glm::vec3> loadPositions();
+    /// Sorts (key, index) pairs by key with an LSD radix sort, keeping equal keys in index order.
+    void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values);
+    /// Head flags, exclusive scan and compaction of the sorted keys into unique codes and voxel starts.
+    void compactVoxels(const std::vector<uint64_t>& sortedKeys, LPCHierarchy& lpc);
+    /// Leaves and the Karras construction of the internal nodes.
+    void buildTree(LPCHierarchy& lpc);
+    /// Bottom-up bounds, point ranges and LOD proxies.
+    void refit(const std::vector<glm::vec3>& sortedPositions, LPCHierarchy& lpc);
+    /// Nodes whose prefix first reaches the cut depth.
+    void findCut(LPCHierarchy& lpc);
+
+    const PointCloud& m_pointCloud;
+    const PointAttributes& m_attributes;
+    uint32_t m_mortonBits;
+    ThreadPool m_pool;
+};
+
+/**
+ * @brief Compares the hierarchy the GPU built into a cloud with the CPU reference.
+ *
+ * Reads back the unique codes, voxel starts, nodes, node bounds and the
+ * culling cut and reports every buffer that differs. The cut is compared as
+ * a set, since 10_cull_cut appends in any order. Proxies are float averages
+ * and are not compared.
+ *
+ * @param pointCloud The cloud after LPCBuilder::build().
+ * @param reference The result of CpuLPCBuilder::build() for the same cloud.
+ * @param comparePoints Whether to also compare the sorted points; only the
+ *        stable radix sort orders points within a voxel like the CPU build.
+ * @return True if all compared buffers are identical.
+ */
+bool validateLPC(const PointCloud& pointCloud, const LPCHierarchy& reference, bool comparePoints);
+
+#endif //POINTSPIRE_CPU_LPC_BUILDER_HPP
@@ -0,0 +1,29 @@
+#pragma once
+#ifndef POINTSPIRE_DEVICE_FEATURES_HPP
+#define POINTSPIRE_DEVICE_FEATURES_HPP
+
+#include <string>
+
+/**
+ * @brief Optional features of the Vulkan device TGA created.
+ *
+ * TGA enables a fixed feature set and exposes neither its physical device nor
+ * its device creation. The executables drawing with --render=compute are
+ * linked with --wrap=vkCreateDevice (see CMakeLists.txt), so the device
+ * creation of TGA passes through src/DeviceFeatures.cpp. There the physical
+ * device TGA picked is queried, and the 64-bit buffer atomics are enabled on
+ * it when it supports them.
+ */
+struct DeviceFeatures {
+    bool intercepted = false;        ///< Whether the device creation passed through the wrapper at all.
+    bool bufferInt64Atomics = false; ///< shaderInt64 and shaderBufferInt64Atomics are enabled.
+    std::string deviceName;          ///< The physical device the device was created on.
+};
+
+/**
+ * @brief Gets the features of the device created last.
+ * @return The features, with intercepted unset before any tga::Interface exists.
+ */
+const DeviceFeatures& getDeviceFeatures();
+
+#endif //POINTSPIRE_DEVICE_FEATURES_HPP
@@ -0,0 +1,96 @@
+#pragma once
+#ifndef POINTSPIRE_FRAME_PROFILER_HPP
+#define POINTSPIRE_FRAME_PROFILER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Rolling per-pass timing statistics and a Chrome trace of the profiled passes.
+ *
+ * TGA exposes no GPU timestamp queries, so the caller submits every pass on
+ * its own, waits for it and reports its host-side span from submission to
+ * completion. Every sample is appended to a trace file in the Chrome trace
+ * event format (chrome://tracing, ui.perfetto.dev) as it arrives, so memory
+ * stays bounded over long sessions.
+ */
+class FrameProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Rolling statistics of one pass, in milliseconds.
+    struct PassStats {
+        std::string name;
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double max = 0.0;
+    };
+
+    /**
+     * @brief Opens the trace file.
+     *
+     * @param tracePath Path of the Chrome trace JSON.
+     * @param historySize Number of recent samples per pass the statistics are computed over.
+     * @throws std::runtime_error If the trace file cannot be created.
+     */
+    explicit FrameProfiler(const std::string& tracePath, size_t historySize = 240);
+
+    /// Closes the trace, making it valid JSON.
+    ~FrameProfiler();
+
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    /**
+     * @brief Adds a timed pass to the rolling statistics and the trace.
+     *
+     * @param pass The pass name, e.g. "cull" or "points".
+     * @param begin When the pass was submitted.
+     * @param end When it had completed.
+     */
+    void addSample(std::string_view pass, Clock::time_point begin, Clock::time_point end);
+
+    /**
+     * @brief Adds a span to the trace only, e.g. a stage of the one-time LPC build.
+     *
+     * @param name The span name.
+     * @param category The trace category, e.g. "build".
+     * @param begin Start of the span.
+     * @param milliseconds Length of the span.
+     */
+    void addTraceEvent(std::string_view name, std::string_view category, Clock::time_point begin, double milliseconds);
+
+    /**
+     * @brief Computes the statistics of every pass over its recent samples.
+     * @return One entry per pass, in the order the passes were first seen.
+     */
+    std::vector<PassStats> getStats() const;
+
+    /**
+     * @brief Formats the statistics in one line, e.g. for the window title.
+     * @return "cull 1.20/1.80 ms, points 4.10/4.60 ms" (median/p95 of every pass).
+     */
+    std::string getSummary() const;
+
+private:
+    struct PassHistory {
+        std::string name;
+        std::vector<double> samples; ///< Ring of the most recent samples.
+        size_t next = 0;
+    };
+
+    void writeEvent(std::string_view name, std::string_view category, Clock::time_point begin, double milliseconds);
+
+    Clock::time_point m_origin;
+    size_t m_historySize;
+    std::vector<PassHistory> m_passes;
+    std::ofstream m_trace;
+    bool m_firstEvent = true;
+};
+
+#endif //POINTSPIRE_FRAME_PROFILER_HPP
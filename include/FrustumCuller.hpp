@@ -0,0 +1,148 @@
+#pragma once
+#ifndef POINTSPIRE_FRUSTUM_CULLER_HPP
+#define POINTSPIRE_FRUSTUM_CULLER_HPP
+
+#include "tga/tga.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Config.hpp"
+#include "HiZBuffer.hpp"
+#include "PointCloud.hpp"
+
+/**
+ * @brief Per-frame frustum culling of a built PointCloud into its visible buffer.
+ *
+ * Owns the compute passes of both culling modes: one thread per point
+ * (--cull=point) or the hierarchical traversal of the LPC tree (--cull=tree),
+ * writing visible points or their indices (--cull-output). With --occlusion,
+ * the tree traversal also skips nodes behind a HiZBuffer of the frame, in two
+ * passes: nodes behind the pyramid of the previous frame are re-tested against
+ * the pyramid of what the first pass emitted before they are dropped. Given
+ * the compute framebuffers, frames can also be culled against their
+ * reprojected framebuffer (--reproject), keeping only the nodes over its gaps.
+ * It needs no window, so the viewer and the benchmark share it. Every frame
+ * in flight of the cloud gets its own input sets, binding the culling
+ * outputs and the camera of that frame.
+ */
+class FrustumCuller {
+public:
+    /**
+     * @brief Creates the passes and input sets of the configured culling mode.
+     *
+     * Must run after the LPC build, which swaps the sorted points into the source buffer.
+     *
+     * @param tgai Reference to the TGA interface for resource creation.
+     * @param pointCloud The built cloud; its buffers are bound, so it must outlive the culler.
+     * @param config Options selecting the culling mode and the LOD threshold.
+     * @param cameraUbos The camera uniform buffer (model, view, proj) of every frame in flight of the cloud.
+     * @param viewportWidth Width of the render target in pixels, used for the occlusion culling.
+     * @param viewportHeight Height of the render target in pixels, used for the LOD screen-space error.
+     * @param framebuffers The compute framebuffer of every frame in flight (PointRasterizer::getFramebuffers())
+     *                     for recordReprojected(), empty if reprojected frames are not culled.
+     */
+    FrustumCuller(tga::Interface& tgai, PointCloud& pointCloud, const Config& config,
+                  const std::vector<tga::Buffer>& cameraUbos, uint32_t viewportWidth, uint32_t viewportHeight,
+                  const std::vector<tga::Buffer>& framebuffers = {});
+
+    ~FrustumCuller();
+
+    FrustumCuller(const FrustumCuller&) = delete;
+    FrustumCuller& operator=(const FrustumCuller&) = delete;
+
+    /**
+     * @brief Records the culling of one frame.
+     *
+     * Builds the Hi-Z pyramid of the frame with --occlusion, resets the
+     * instance count of the indirect draw buffer, then fills the visible
+     * buffer (with --occlusion, in two passes around a rebuild of the
+     * pyramid). The caller adds the barrier before the draw.
+     *
+     * @param recorder The recorder of the frame command buffer.
+     * @param frame The frame in flight whose outputs are written.
+     */
+    void record(tga::CommandRecorder& recorder, uint32_t frame = 0);
+
+    /**
+     * @brief Records the culling of a frame whose framebuffer holds the reprojected previous frame.
+     *
+     * Like record(), but the tree traversal skips every node whose footprint the
+     * framebuffer covers, so only the points over its gaps are emitted. Records
+     * after PointRasterizer::recordReprojection(); needs canReproject().
+     *
+     * @param recorder The recorder of the frame command buffer.
+     * @param frame The frame in flight whose outputs are written.
+     */
+    void recordReprojected(tga::CommandRecorder& recorder, uint32_t frame);
+
+    /// True if the culler was given framebuffers and can cull reprojected frames.
+    bool canReproject() const { return !m_treeCull.reprojectSets.empty(); }
+
+    /**
+     * @brief Gets the culling counters of a frame in flight, valid once its command buffer has completed.
+     *
+     * Point culling tests every point and keeps no counters, so only pointsTested is set then.
+     *
+     * @param frame The frame in flight.
+     * @return The counters.
+     */
+    CullStats getStats(uint32_t frame = 0) const;
+
+    CullingMode getMode() const { return m_mode; }
+
+private:
+    /// Creates the per-point culling pass.
+    void createPointCullingPass(const std::vector<tga::Buffer>& cameraUbos);
+
+    /// Creates the passes, input sets and buffers of the hierarchical culling.
+    void createTreeCullingPasses(const std::vector<tga::Buffer>& cameraUbos, uint32_t viewportWidth, uint32_t viewportHeight,
+                                 const Config& config, const std::vector<tga::Buffer>& framebuffers);
+
+    /// Records the per-point frustum culling (one thread per point).
+    void recordPointCulling(tga::CommandRecorder& recorder, uint32_t frame);
+
+    /// Records the hierarchical frustum culling over the LPC tree, of a reprojected frame or not.
+    void recordTreeCulling(tga::CommandRecorder& recorder, uint32_t frame, bool reprojected);
+
+    /// Records one node walk from the roots bound in nodesSet (at most rootCount) and the copy of its ranges.
+    void recordTreePass(tga::CommandRecorder& recorder, uint32_t frame, tga::InputSet nodesSet, uint32_t rootCount);
+
+    tga::Interface& m_tgai;
+    PointCloud& m_pointCloud;
+    CullingMode m_mode;
+
+    /// Per-point culling: cull.comp over every source point.
+    struct PointCulling {
+        tga::ComputePass pass;
+        std::vector<tga::InputSet> inputSets; ///< Per frame. Bindings: Cam, Source, Visible, Indirect, Info, Quantization.
+    } m_pointCull;
+
+    /**
+     * @brief Passes of the hierarchical frustum culling (--cull=tree).
+     *
+     * cull_nodes walks the subtrees below the cut and emits point ranges,
+     * cull_args sizes the point pass, and cull_points copies the ranges into
+     * the visible buffer, testing points only where a leaf straddles the frustum.
+     * With --lod, cull_nodes also draws the averaged proxy of every subtree
+     * that projects smaller than the pixel threshold instead of descending.
+     * With --occlusion, the same passes run again from the retest list.
+     */
+    struct TreeCulling {
+        tga::ComputePass nodesPass;
+        tga::ComputePass argsPass;
+        tga::ComputePass pointsPass;
+        std::vector<tga::InputSet> nodesSets;  ///< Per frame in flight, like the sets and staging below.
+        std::vector<tga::InputSet> retestSets; ///< Second pass of cull_nodes from the retest list (--occlusion=on only).
+        std::vector<tga::InputSet> reprojectSets; ///< cull_nodes against the reprojected framebuffer (with framebuffers only).
+        std::vector<tga::InputSet> argsSets;
+        std::vector<tga::InputSet> pointsSets;
+        std::vector<tga::StagingBuffer> statsStaging; ///< Host copies of the CullStats.
+        tga::Buffer lodParamsBuffer;     ///< LODParams of the traversal.
+        std::unique_ptr<HiZBuffer> hiZ;  ///< Pyramids of the occlusion culling or the reprojection, null without either.
+        bool occlusion = false;          ///< --occlusion=on, the regular frames test against hiZ.
+        tga::Buffer noOcclusionBuffer;   ///< Zeroed HiZParams bound as the Hi-Z and retest buffers without occlusion culling.
+    } m_treeCull;
+};
+
+#endif //POINTSPIRE_FRUSTUM_CULLER_HPP
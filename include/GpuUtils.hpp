@@ -0,0 +1,94 @@
+#pragma once
+#ifndef POINTSPIRE_GPU_UTILS_HPP
+#define POINTSPIRE_GPU_UTILS_HPP
+
+#include "tga/tga.hpp"
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <utility> // For std::pair
+#include <vector>
+
+#include "PointCloud.hpp"
+
+/**
+ * @brief Compile-time variants a shader is built with (see shaders/CMakeLists.txt).
+ */
+enum ShaderVariants : uint32_t {
+    SHADER_MORTON_KEYS = 1u << 0,  ///< Includes include/morton.glsl, "_64" variant for 63-bit keys.
+    SHADER_POINT_FORMAT = 1u << 1, ///< Includes include/point.glsl, one variant per non-default point format.
+    SHADER_CULL_OUTPUT = 1u << 2   ///< Includes include/visible.glsl, "_indices" variant for --cull-output=indices.
+};
+
+/**
+ * @brief Calculates 2D dispatch dimensions to bypass hardware limits.
+ *
+ * Most GPUs limit the X dimension of a dispatch group to 65535. This helper
+ * converts a large 1D total count into a 2D (X, Y) grid layout.
+ *
+ * @param numThreads The total number of items (points) to process.
+ * @param workGroupSize The local workgroup size defined in the shader (default 256).
+ * @return std::pair<uint32_t, uint32_t> The {GroupCountX, GroupCountY} dimensions.
+ */
+std::pair<uint32_t, uint32_t> getDispatchDimensions(size_t numThreads, uint32_t workGroupSize = 256);
+
+/**
+ * @brief Resolves the SPIR-V path of a shader for the key width and point format of a cloud.
+ *
+ * Shaders including include/morton.glsl or include/point.glsl are compiled
+ * in several variants; the 63-bit key variant carries a "_64" suffix, the
+ * point format variants a "_compact" or "_soa" suffix. Shaders including
+ * include/visible.glsl add an "_indices" suffix for the index cull output.
+ *
+ * @param pointCloud The cloud whose Morton key width, point format and cull output select the variant.
+ * @param name The shader file name without extension (e.g. "1_morton").
+ * @param variants The ShaderVariants the shader is built with.
+ * @param stage The shader stage extension ("comp", "vert", ...).
+ * @return The path of the compiled shader.
+ */
+std::string shaderPath(const PointCloud& pointCloud, const std::string& name, uint32_t variants,
+                       const std::string& stage = "comp");
+
+/**
+ * @brief Resolves the SPIR-V path of a shader for the options of a run without a single cloud (e.g. --tiles).
+ *
+ * @param config The options whose Morton key width, point format and cull output select the variant.
+ * @param name The shader file name without extension.
+ * @param variants The ShaderVariants the shader is built with.
+ * @param stage The shader stage extension ("comp", "vert", ...).
+ * @return The path of the compiled shader.
+ */
+std::string shaderPath(const Config& config, const std::string& name, uint32_t variants,
+                       const std::string& stage = "comp");
+
+/**
+ * @brief Appends the color and intensity streams of SoA point buffers to a pass layout and its bindings.
+ *
+ * The streams take the next free slots, two per point set in the given order,
+ * matching the POINT_BUFFER declarations of the shader. The interleaved formats
+ * keep every attribute in the primary binding, so nothing is appended for them.
+ *
+ * @param pointCloud The cloud whose point format decides whether streams are appended.
+ * @param layout The binding layouts of the pass, extended in place.
+ * @param bindings The bindings of the input set, extended in place.
+ * @param pointSets The point buffers in the order of their POINT_BUFFER declarations.
+ */
+void appendPointStreams(const PointCloud& pointCloud, std::vector<tga::BindingLayout>& layout,
+                        std::vector<tga::Binding>& bindings, std::initializer_list<PointBuffers> pointSets);
+
+/**
+ * @brief Gets the binding layout and bindings of the point draw pass (bunny_primitive.vert) of a frame in flight.
+ *
+ * The pass reads the visible points of the frame, or with --cull-output=indices
+ * the source points and LOD proxies through the visible indices of the frame.
+ *
+ * @param pointCloud The built cloud.
+ * @param cameraUbo The camera uniform buffer of the frame.
+ * @param frame The frame in flight.
+ * @param layout Receives the binding layouts of the pass.
+ * @param bindings Receives the bindings of the input set.
+ */
+void getPointDrawBindings(const PointCloud& pointCloud, const tga::Buffer& cameraUbo, uint32_t frame,
+                          std::vector<tga::BindingLayout>& layout, std::vector<tga::Binding>& bindings);
+
+#endif //POINTSPIRE_GPU_UTILS_HPP
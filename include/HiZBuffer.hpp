@@ -0,0 +1,144 @@
+#pragma once
+#ifndef POINTSPIRE_HIZ_BUFFER_HPP
+#define POINTSPIRE_HIZ_BUFFER_HPP
+
+#include "tga/tga.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "PointCloud.hpp"
+
+/// @name Occlusion Culling Constants
+/// @{
+constexpr uint32_t HIZ_MAX_LEVELS = 16;            ///< Levels of the Hi-Z pyramid (must match include/hiz.glsl).
+constexpr uint32_t HIZ_RETEST_CAPACITY = 1u << 16; ///< Occluded nodes deferred to the second culling pass per frame.
+/// @}
+
+/**
+ * @brief Layout of the Hi-Z pyramid (uniform buffer, std140).
+ */
+struct HiZParams {
+    uint32_t baseWidth;
+    uint32_t baseHeight;
+    uint32_t levelCount;
+    uint32_t enabled;                      ///< 0 makes hizOccluded() pass every node.
+    uint32_t levelOffsets[HIZ_MAX_LEVELS]; ///< First texel of every level in the pyramid buffer.
+    uint32_t quadSplats;                   ///< 1 if points are drawn as quads (--render=quads), 0 as single pixels.
+    uint32_t padding[3];
+};
+
+/**
+ * @brief Parameters of one tree culling pass (uniform buffer, std140, see cull_nodes.comp).
+ */
+struct OcclusionPassParams {
+    uint32_t retestCapacity; ///< Occluded nodes the pass may defer to the retest list, 0 if they are final.
+    uint32_t coverage;       ///< 1 to skip the nodes the pyramid covers instead of those it occludes.
+    uint32_t padding[2];
+};
+
+/**
+ * @brief What a pyramid is built from.
+ */
+enum class HiZSource : uint32_t {
+    previousFrame, ///< The visible set of the frame before, for the first culling pass.
+    currentFrame,  ///< The visible set the first culling pass emitted, for the second pass.
+    framebuffer    ///< The reprojected compute framebuffer of the frame, for reprojected frames (--reproject).
+};
+
+/**
+ * @brief Per-frame hierarchical depth buffer for the occlusion culling (--occlusion=on).
+ *
+ * TGA gives compute passes no access to the depth attachment, so the depth is
+ * rebuilt from points instead: the points of a draw are projected with the
+ * camera of the current frame into the base level at viewport resolution,
+ * each writing only the pixels it is drawn to (its quad, or its single pixel
+ * with --render=compute) and keeping the nearest depth per pixel. The coarser
+ * levels keep the farthest depth of the texels below them.
+ *
+ * The culling runs in two passes. The first tests against the pyramid of the
+ * previous frame's points and defers the nodes it finds occluded to a retest
+ * list; the pyramid is then rebuilt from the points the first pass emitted,
+ * and the second pass draws the deferred nodes that are not behind it. Empty
+ * pixels stay at the far plane, so gaps between points never occlude anything.
+ *
+ * Reprojected frames (--reproject) copy the depth of their compute framebuffer
+ * into the base level instead, which marks the gaps the reprojection left, and
+ * skip the nodes whose footprint has none.
+ */
+class HiZBuffer {
+public:
+    /**
+     * @brief Creates the pyramid of every frame in flight and the passes building it.
+     *
+     * @param tgai Reference to the TGA interface for resource creation.
+     * @param pointCloud The built cloud; its culling outputs are read, so it must outlive the buffer.
+     * @param cameraUbos The camera uniform buffer of every frame in flight of the cloud.
+     * @param viewportWidth Width of the render target in pixels.
+     * @param viewportHeight Height of the render target in pixels.
+     * @param renderMode How the points are drawn, which decides the footprint they are splatted with.
+     * @param framebuffers The compute framebuffer (viewport size) of every frame in flight for
+     *                     HiZSource::framebuffer, empty if that source is not used.
+     */
+    HiZBuffer(tga::Interface& tgai, const PointCloud& pointCloud, const std::vector<tga::Buffer>& cameraUbos,
+              uint32_t viewportWidth, uint32_t viewportHeight, RenderMode renderMode,
+              const std::vector<tga::Buffer>& framebuffers = {});
+
+    ~HiZBuffer();
+
+    HiZBuffer(const HiZBuffer&) = delete;
+    HiZBuffer& operator=(const HiZBuffer&) = delete;
+
+    /**
+     * @brief Records the build of the pyramid of a frame from the visible set of a draw or its framebuffer.
+     *
+     * With HiZSource::previousFrame, must be recorded before the culling of the
+     * frame resets its outputs; with HiZSource::currentFrame, after the first
+     * culling pass; with HiZSource::framebuffer, after the reprojection. The
+     * barriers on both sides are included.
+     *
+     * @param recorder The recorder of the frame command buffer.
+     * @param frame The frame in flight whose camera and pyramid are used.
+     * @param source What the base level is built from.
+     */
+    void record(tga::CommandRecorder& recorder, uint32_t frame, HiZSource source);
+
+    /// Gets the pyramid (all levels, uint depth bits) of a frame in flight.
+    const tga::Buffer& getPyramid(uint32_t frame) const { return m_pyramids[frame]; }
+
+    /// Gets the HiZParams uniform buffer describing the pyramid.
+    const tga::Buffer& getParams() const { return m_paramsBuffer; }
+
+    /// Gets the retest list (count, then up to HIZ_RETEST_CAPACITY node indices) of a frame in flight.
+    const tga::Buffer& getRetestList(uint32_t frame) const { return m_retestLists[frame]; }
+
+    /// Gets the OcclusionPassParams of the culling pass testing against a pyramid built from source.
+    const tga::Buffer& getPassParams(HiZSource source) const {
+        return m_passParams[static_cast<uint32_t>(source)];
+    }
+
+private:
+    tga::Interface& m_tgai;
+    HiZParams m_params{};
+    std::vector<uint32_t> m_levelTexels;      ///< Texel count of every level.
+
+    tga::Buffer m_paramsBuffer;
+    std::array<tga::Buffer, 3> m_passParams{}; ///< Per HiZSource.
+    std::vector<tga::Buffer> m_levelBuffers;  ///< Per level from 1: the level index read by hiz_reduce.
+    std::vector<tga::Buffer> m_pyramids;      ///< Per frame in flight.
+    std::vector<tga::Buffer> m_dispatchArgs;  ///< Per frame: DispatchIndirectCommand of hiz_splat.
+    std::vector<tga::Buffer> m_retestLists;   ///< Per frame: nodes deferred by the first culling pass.
+
+    tga::ComputePass m_clearPass;
+    tga::ComputePass m_argsPass;
+    tga::ComputePass m_splatPass;
+    tga::ComputePass m_reducePass;
+    tga::ComputePass m_framebufferPass;       ///< Copies a framebuffer depth into the base level, null without framebuffers.
+    std::vector<tga::InputSet> m_clearSets;   ///< Per frame in flight.
+    std::vector<std::array<tga::InputSet, 2>> m_argsSets;  ///< Per frame, then per HiZSource.
+    std::vector<std::array<tga::InputSet, 2>> m_splatSets; ///< Per frame, then per HiZSource.
+    std::vector<tga::InputSet> m_framebufferSets;
+    std::vector<std::vector<tga::InputSet>> m_reduceSets; ///< Per frame, then per level from 1.
+};
+
+#endif //POINTSPIRE_HIZ_BUFFER_HPP
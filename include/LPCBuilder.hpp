@@ -0,0 +1,144 @@
+#pragma once
+#ifndef POINTSPIRE_LPC_BUILDER_HPP
+#define POINTSPIRE_LPC_BUILDER_HPP
+
+#include "tga/tga.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Config.hpp"
+#include "PointCloud.hpp"
+
+/**
+ * @brief Wall time of one stage of an LPC build.
+ */
+struct LPCStageTiming {
+    std::string stage;    ///< Stage name, e.g. "morton" or "sort".
+    double milliseconds;  ///< Time from submission to completion, or of the CPU stage.
+};
+
+/**
+ * @brief Builds the Layered Point Cloud hierarchy of a PointCloud on the GPU.
+ *
+ * Owns the compute passes of the build (Morton codes, sort, reorder, unique
+ * voxels, tree construction, refit and the culling cut). It needs no window
+ * or swapchain, so the viewer and the headless pointspire-build tool share it.
+ * The passes are only needed once, so the builder is meant to be destroyed
+ * right after build(). The cloud's build scratch and its tree, sized for
+ * one voxel per point, are created with the builder; build() releases the
+ * scratch and compacts the tree.
+ */
+class LPCBuilder {
+public:
+    /**
+     * @brief Creates the build scratch and the upper-bound tree of a cloud, and the passes and input sets of the build.
+     *
+     * @param tgai Reference to the TGA interface for resource creation.
+     * @param pointCloud The cloud to build; its buffers are bound, so it must outlive the builder.
+     * @param config Options selecting e.g. the sort algorithm.
+     */
+    LPCBuilder(tga::Interface& tgai, PointCloud& pointCloud, const Config& config);
+
+    ~LPCBuilder();
+
+    LPCBuilder(const LPCBuilder&) = delete;
+    LPCBuilder& operator=(const LPCBuilder&) = delete;
+
+    /**
+     * @brief Records and runs the whole build in one command buffer and waits for it.
+     *
+     * The tree stages are sized on the GPU through indirect dispatches. Reads
+     * back numUnique and the culling cut size, swaps the Morton-sorted points
+     * into the source buffer of the cloud and compacts its tree to numUnique.
+     *
+     * @param timings If given, every stage is submitted separately and its
+     *        time from submission to completion is appended. The extra
+     *        synchronization makes the total slower than an untimed build.
+     */
+    void build(std::vector<LPCStageTiming>* timings = nullptr);
+
+private:
+    /**
+     * @brief Records the LSD radix sort of the Morton code / index pairs.
+     *
+     * Runs getRadixPassCount() passes of upsweep (per-tile histograms), scan
+     * (global digit offsets) and stable scatter, ping-ponging between the
+     * primary and alternate buffers. The pass count is even for both key
+     * widths, so the sorted result ends up back in the primary buffers.
+     *
+     * @param rec The recorder of the LPC build command buffer.
+     * @param numPoints The number of keys to sort.
+     */
+    void recordRadixSort(tga::CommandRecorder& rec, uint32_t numPoints);
+
+    /**
+     * @brief Records the bitonic sort network (one dispatch per (j, k) stage).
+     *
+     * @param rec The recorder of the LPC build command buffer.
+     * @param numPoints The number of keys to sort.
+     */
+    void recordBitonicSort(tga::CommandRecorder& rec, uint32_t numPoints);
+
+    tga::Interface& m_tgai;
+    PointCloud& m_pointCloud;
+    SortAlgorithm m_sortAlgorithm;
+
+    struct LayeredPointCloudPasses {
+        tga::ComputePass mortonPass;
+        tga::ComputePass bitonicSortPass;
+        tga::ComputePass radixUpsweepPass;
+        tga::ComputePass radixScanPass;
+        tga::ComputePass radixScatterPass;
+        tga::ComputePass reorderPass;
+        tga::ComputePass markHeadsPass;
+        tga::ComputePass scanReducePass;
+        tga::ComputePass scanPartialsPass;
+        tga::ComputePass scanDownsweepPass;
+        tga::ComputePass dispatchArgsPass;
+        tga::ComputePass scatterPass;
+        tga::ComputePass initLeavesPass;
+        tga::ComputePass buildInternalPass;
+        tga::ComputePass refitLeavesPass;
+        tga::ComputePass refitInternalPass;
+        tga::ComputePass cullCutPass;
+    } m_passes;
+
+    struct LayeredPointCloudSets {
+        tga::InputSet mortonSet;
+        tga::InputSet bitonicSortSet;
+        std::array<tga::InputSet, 2> radixUpsweepSets;  ///< [0]: reads primary keys, [1]: reads alternate keys.
+        tga::InputSet radixScanSet;
+        std::array<tga::InputSet, 2> radixScatterSets;  ///< [0]: primary -> alternate, [1]: alternate -> primary.
+        tga::InputSet reorderSet;
+        tga::InputSet markHeadsSet;
+        tga::InputSet scanReduceSet;
+        tga::InputSet scanPartialsSet;
+        tga::InputSet scanDownsweepSet;
+        tga::InputSet dispatchArgsSet;
+        tga::InputSet scatterSet;
+        tga::InputSet initLeavesSet;
+        tga::InputSet buildInternalSet;
+        tga::InputSet refitLeavesSet;
+        tga::InputSet refitInternalSet;
+        tga::InputSet cullCutSet;
+    } m_sets;
+};
+
+/**
+ * @brief Builds the hierarchy of a cloud with the backend selected by --build.
+ *
+ * gpu runs LPCBuilder, cpu runs CpuLPCBuilder and uploads its result,
+ * validate runs both and compares them.
+ *
+ * @param tgai Reference to the TGA interface for resource creation.
+ * @param pointCloud The cloud to build.
+ * @param config Options selecting the backend and the sort algorithm.
+ * @param timings If given, receives the stage times of the build (of the GPU build when validating).
+ * @throws std::runtime_error If validation finds a difference.
+ */
+void buildLayeredPointCloud(tga::Interface& tgai, PointCloud& pointCloud, const Config& config,
+                            std::vector<LPCStageTiming>* timings = nullptr);
+
+#endif //POINTSPIRE_LPC_BUILDER_HPP
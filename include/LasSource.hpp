@@ -0,0 +1,39 @@
+#pragma once
+#ifndef POINTSPIRE_LAS_SOURCE_HPP
+#define POINTSPIRE_LAS_SOURCE_HPP
+
+#include "PointSource.hpp"
+#include <string>
+
+/**
+ * @brief Point source reading LAS/LAZ files through PDAL.
+ *
+ * The file is streamed with a fixed-size PDAL point table, so host memory
+ * stays O(STREAM_CHUNK_SIZE); every chunk is converted on all hardware
+ * threads. LAS is Z-up, so positions come out as (x, z, -y). Colors and
+ * intensities are normalized from 16 bit to [0, 1].
+ */
+class LasSource : public PointSource {
+public:
+    /**
+     * @brief Opens a file and reads its bounds and point count.
+     *
+     * Both come from the LAS header. Files without header bounds are scanned
+     * once up front.
+     *
+     * @param path The path to the .las or .laz file.
+     */
+    explicit LasSource(const std::string& path);
+
+    std::string getName() const override { return m_path; }
+    size_t getPointCount() const override { return m_pointCount; }
+    const SourceBounds& getBounds() const override { return m_bounds; }
+    void read(const glm::dvec3& origin, const BatchFn& fn) override;
+
+private:
+    std::string m_path;
+    size_t m_pointCount = 0;
+    SourceBounds m_bounds;
+};
+
+#endif //POINTSPIRE_LAS_SOURCE_HPP
@@ -0,0 +1,194 @@
+#pragma once
+#ifndef POINTSPIRE_POINT_CACHE_HPP
+#define POINTSPIRE_POINT_CACHE_HPP
+
+#include "PointCloud.hpp"
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+constexpr uint32_t POINT_CACHE_VERSION = 3; ///< Bumped whenever the header or a section layout changes.
+
+/**
+ * @brief Identifies the source file a cache was built from.
+ *
+ * The hash covers evenly spaced 64 KiB blocks from the first to the last
+ * byte of the file (the LAS header, the tail of the point records and the
+ * records between), which together with the size catches replaced or
+ * rewritten files without reading gigabytes. Only contents are keyed, so a
+ * copied or re-downloaded source still matches its cache.
+ */
+struct PointCacheKey {
+    uint64_t fileSize = 0;
+    uint64_t contentHash = 0; ///< FNV-1a over the sampled file contents.
+
+    bool operator==(const PointCacheKey&) const = default;
+};
+
+/**
+ * @brief The GPU buffers stored in a cache, in file order.
+ *
+ * Together they are the complete state after the LPC build, so a cached run
+ * uploads them and skips the Morton, sort and tree passes.
+ */
+enum class CacheSection : uint32_t {
+    points,           ///< Morton-sorted source points (or SoA positions).
+    colors,           ///< SoA only: sorted color stream.
+    intensities,      ///< SoA only: sorted intensity stream.
+    lpcUniforms,      ///< LPCUniforms with the final numUnique.
+    uniqueCodes,      ///< One Morton key per voxel.
+    voxelStarts,      ///< First sorted point of every voxel.
+    nodes,            ///< The Node array.
+    nodeBounds,       ///< Refitted per-node AABBs.
+    proxyPoints,      ///< Per-node LOD proxies (or SoA positions).
+    proxyColors,      ///< SoA only: proxy color stream.
+    proxyIntensities, ///< SoA only: proxy intensity stream.
+    cullCut,          ///< Count and node indices of the culling subtrees.
+    lpcDispatch,      ///< Indirect dispatch arguments of the tree stages.
+    count
+};
+
+constexpr size_t POINT_CACHE_SECTION_COUNT = static_cast<size_t>(CacheSection::count);
+
+/**
+ * @brief Fixed-size header at the start of a .pspire file.
+ *
+ * Sections follow the header, each aligned to POINT_CACHE_ALIGNMENT so they
+ * can be used in place from the mapping.
+ */
+struct PointCacheHeader {
+    char magic[8] = {'P', 'S', 'P', 'I', 'R', 'E', '\0', '\0'};
+    uint32_t version = POINT_CACHE_VERSION;
+    uint32_t pointFormat = 0;  ///< PointFormat the point sections are encoded in.
+    uint32_t mortonBits = 0;   ///< Key width of the unique codes.
+    uint32_t cutCount = 0;     ///< Number of culling subtrees.
+    PointCacheKey key;
+    AABB bounds{};
+    PointQuantization quantization{};
+    uint64_t numPoints = 0;
+    uint64_t numUnique = 0;
+
+    /// Byte ranges of the sections, indexed by CacheSection.
+    struct Section {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    } sections[POINT_CACHE_SECTION_COUNT];
+};
+
+constexpr size_t POINT_CACHE_ALIGNMENT = 64; ///< Alignment of every section in the file.
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull; ///< Initial state of the FNV-1a content hash.
+
+/**
+ * @brief Whether a path names a .pspire cache rather than a point cloud.
+ *
+ * A cache given as --input is restored on its own, without its sources.
+ *
+ * @param path The input path.
+ * @return True for the .pspire extension.
+ */
+bool isPointCachePath(const std::string& path);
+
+/**
+ * @brief Computes the cache key of a source file.
+ * @param sourcePath The point cloud file the cache is derived from.
+ * @param seed The FNV-1a state the content hash continues from.
+ * @return The key, all zero if the file cannot be read.
+ */
+PointCacheKey computePointCacheKey(const std::string& sourcePath, uint64_t seed = FNV_OFFSET_BASIS);
+
+/**
+ * @brief Computes the cache key of a set of inputs (--input with several files).
+ *
+ * Equal to the key of the file for a single input. For a .conf input only the
+ * .conf file itself is keyed, not the PLY scans it lists.
+ *
+ * @param sourcePaths The inputs, in command line order.
+ * @return The combined key, all zero if any input cannot be read.
+ */
+PointCacheKey computePointCacheKey(const std::vector<std::string>& sourcePaths);
+
+/**
+ * @brief A .pspire file mapped read-only into memory.
+ */
+class PointCache {
+public:
+    /**
+     * @brief Maps a cache file if it exists and matches the expected source and options.
+     *
+     * @param path The .pspire file.
+     * @param key The key of the current source file, or std::nullopt to accept a cache of any source.
+     * @param pointFormat The point format the viewer runs with.
+     * @param mortonBits The Morton key width the viewer runs with.
+     * @return The mapped cache, or nullptr if it is missing, stale or of another version.
+     */
+    static std::unique_ptr<PointCache> open(const std::string& path, const std::optional<PointCacheKey>& key,
+                                            PointFormat pointFormat, uint32_t mortonBits);
+
+    ~PointCache();
+
+    PointCache(const PointCache&) = delete;
+    PointCache& operator=(const PointCache&) = delete;
+
+    /**
+     * @brief Gets the validated header.
+     * @return A const reference to the header at the start of the mapping.
+     */
+    const PointCacheHeader& getHeader() const { return *reinterpret_cast<const PointCacheHeader*>(m_data); }
+
+    /**
+     * @brief Gets the contents of a section.
+     * @param section The section to look up.
+     * @return The bytes of the section inside the mapping, empty if absent.
+     */
+    std::span<const uint8_t> getSection(CacheSection section) const;
+
+private:
+    PointCache(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    const uint8_t* m_data;
+    size_t m_size;
+};
+
+/**
+ * @brief Writes a .pspire file section by section.
+ *
+ * The header is written last, so an interrupted write leaves a file without
+ * a valid magic that open() rejects.
+ */
+class PointCacheWriter {
+public:
+    /**
+     * @brief Creates (or truncates) the cache file.
+     * @param path The .pspire file.
+     * @throws std::runtime_error If the file cannot be created.
+     */
+    explicit PointCacheWriter(const std::string& path);
+
+    /**
+     * @brief Appends a section.
+     * @param section The section the data belongs to.
+     * @param data The section contents.
+     * @param size The size in bytes.
+     * @throws std::runtime_error On write errors.
+     */
+    void writeSection(CacheSection section, const void* data, size_t size);
+
+    /**
+     * @brief Writes the header with the recorded section table and closes the file.
+     * @param header The header, its section table is filled in by the writer.
+     * @throws std::runtime_error On write errors.
+     */
+    void finish(PointCacheHeader header);
+
+private:
+    std::string m_path;
+    std::ofstream m_file;
+    PointCacheHeader::Section m_sections[POINT_CACHE_SECTION_COUNT]{};
+};
+
+#endif //POINTSPIRE_POINT_CACHE_HPP
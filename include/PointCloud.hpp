@@ -4,7 +4,12 @@
 
 #include "tga/tga.hpp"
 #include "tga/tga_math.hpp"
+#include "Config.hpp"
+#include <array>
+#include <memory>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
 
 /**
@@ -15,10 +20,97 @@
  */
 struct Point {
     alignas(16) glm::vec3 position;
+    float splatSize;                ///< View-space half size of the splat, 0 for the default size (LOD proxies).
     alignas(16) glm::vec3 color;
     float intensity;
 };
 
+class PointCache;
+class PointSource;
+struct LPCHierarchy;
+enum class CacheSection : uint32_t;
+
+/**
+ * @brief CPU-side storage of the loaded points, one array per attribute.
+ *
+ * Kept as structure of arrays so position-only work (bounds, quantization,
+ * uploads of the SoA position stream) streams through positions alone.
+ */
+struct PointAttributes {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colors;   ///< RGB in [0, 1].
+    std::vector<float> intensities;  ///< In [0, 1].
+
+    size_t size() const { return positions.size(); }
+    bool empty() const { return positions.empty(); }
+
+    void reserve(size_t count) {
+        positions.reserve(count);
+        colors.reserve(count);
+        intensities.reserve(count);
+    }
+
+    void resize(size_t count) {
+        positions.resize(count);
+        colors.resize(count);
+        intensities.resize(count);
+    }
+
+    void push_back(const glm::vec3& position, const glm::vec3& color, float intensity) {
+        positions.push_back(position);
+        colors.push_back(color);
+        intensities.push_back(intensity);
+    }
+};
+
+/**
+ * @brief GPU buffers holding one set of points (source, visible or node proxies).
+ *
+ * The interleaved formats (full, compact) only use `points`. The SoA format
+ * keeps positions (xyz + splat size) in `points` and every other attribute in
+ * its own buffer, so position-only passes touch a fraction of the memory.
+ */
+struct PointBuffers {
+    tga::Buffer points;      ///< Point/CompactPoint array, or vec4 positions in the SoA format.
+    tga::Buffer colors;      ///< SoA only: unorm16 RGBA colors (uvec2 per point).
+    tga::Buffer intensities; ///< SoA only: float intensities.
+};
+
+/// @name SoA Stream Element Sizes
+/// Must match POINT_BUFFER in include/point.glsl.
+/// @{
+constexpr size_t SOA_POSITION_SIZE = 4 * sizeof(float);     ///< vec4: xyz + splat size.
+constexpr size_t SOA_COLOR_SIZE = 2 * sizeof(uint32_t);     ///< uvec2: unorm16 RG, unorm16 BA.
+constexpr size_t SOA_INTENSITY_SIZE = sizeof(float);        ///< float.
+/// @}
+
+/**
+ * @brief Packed GPU point of the compact format (--point-format=compact).
+ *
+ * Positions are quantized to POINT_QUANTIZATION_BITS per axis relative to the
+ * cloud bounds (see PointQuantization). Decoded by include/point.glsl.
+ */
+struct CompactPoint {
+    uint32_t positionLow;    ///< x (bits 0-20) and the low 11 bits of y.
+    uint32_t positionHigh;   ///< The high 10 bits of y and z (bits 10-30).
+    uint32_t color;          ///< RGBA8, red in the lowest byte.
+    uint32_t intensitySplat; ///< unorm16 intensity, half-float splat size in the high 16 bits.
+};
+
+constexpr uint32_t POINT_QUANTIZATION_BITS = 21; ///< Bits per axis of a CompactPoint position.
+
+/**
+ * @brief Dequantization parameters of the compact point format (uniform buffer).
+ *
+ * position = origin + quantized * step. Bound to every shader touching points,
+ * also in the full format where it is ignored.
+ */
+struct PointQuantization {
+    alignas(16) glm::vec3 origin;  ///< Minimum of the cloud bounds.
+    alignas(16) glm::vec3 step;    ///< Size of one quantization step per axis.
+    alignas(16) glm::vec3 invStep; ///< 1 / step, 0 for flat axes.
+};
+
 /**
  * @brief Axis-Aligned Bounding Box (AABB) defining the spatial extents of the cloud.
  */
@@ -28,14 +120,73 @@ struct AABB {
 };
 
 /**
- * TODO write docs
+ * @brief Computes the quantization grid of the compact format over some bounds.
+ * @param bounds The bounds every encoded position lies in, 2^21 - 1 steps per axis.
+ * @return The dequantization parameters of the grid.
+ */
+PointQuantization computePointQuantization(const AABB& bounds);
+
+/**
+ * @brief Quantizes a position to the grid of the compact format.
+ * @param quantization The grid.
+ * @param position A position in the bounds of the grid.
+ * @return The POINT_QUANTIZATION_BITS-bit grid coordinates per axis.
+ */
+glm::uvec3 quantizePointPosition(const PointQuantization& quantization, const glm::vec3& position);
+
+/**
+ * @brief Gets the bytes per point of each GPU stream of a point format.
+ * @param format The point format.
+ * @return Element sizes of the points, colors and intensities buffers, 0 for unused streams.
+ */
+std::array<size_t, 3> getPointStreamStrides(PointFormat format);
+
+/**
+ * @brief Encodes a range of points into host arrays laid out like the GPU buffers of a point format.
+ *
+ * Point i of the attributes is written to element i of every stream, so
+ * callers pass stream pointers offset to wherever the range should land.
+ *
+ * @param format The point format of the streams.
+ * @param quantization The grid of the compact format, ignored by the others.
+ * @param attributes The points to encode.
+ * @param begin The first point to encode.
+ * @param count The number of points to encode.
+ * @param streams Destination of the points, colors and intensities streams (see getPointStreamStrides()).
+ * @param splatSizes Optional splat size of every point (LOD proxies), 0 if null.
+ */
+void encodePointRange(PointFormat format, const PointQuantization& quantization, const PointAttributes& attributes,
+                      size_t begin, size_t count, const std::array<uint8_t*, 3>& streams, const float* splatSizes = nullptr);
+
+/**
+ * @brief Parameters shared by all LPC build stages (uniform buffer).
  */
 struct LPCUniforms {
     AABB bounds;
     uint32_t numPoints;
     uint32_t numUnique;
+    alignas(16) glm::vec3 mortonScale; ///< 1 / extent of the bounds per axis, see computeMortonScale().
 };
 
+/**
+ * @brief Gets the factor mapping positions relative to the bounds minimum into [0, 1] for the Morton keys.
+ *
+ * Computed once on the host and multiplied in 1_morton.comp: GPU division
+ * is not correctly rounded, a multiplication is, so the CPU build
+ * (CpuLPCBuilder) reproduces the GPU keys bit for bit.
+ *
+ * @param bounds The cloud bounds.
+ * @return 1 / extent per axis, 1 for axes thinner than 0.0001.
+ */
+inline glm::vec3 computeMortonScale(const AABB& bounds) {
+    glm::vec3 extent = bounds.max - bounds.min;
+    glm::vec3 scale;
+    for (int axis = 0; axis < 3; ++axis) {
+        scale[axis] = extent[axis] < 0.0001f ? 1.0f : 1.0f / extent[axis];
+    }
+    return scale;
+}
+
 /**
  * TODO write docs
  */
@@ -44,16 +195,115 @@ struct Node {
     uint32_t left;
     uint32_t right;
     uint32_t isLeaf;
-    uint32_t mortonCode;
+    uint32_t mortonCode;      ///< Low 32 bits of the Morton code.
+    uint32_t mortonCodeHigh;  ///< High 31 bits of a 63-bit code, 0 for 30-bit codes.
     uint32_t prefixLen;
     uint32_t pointStart;
     uint32_t pointCount;
 };
 
+/**
+ * @brief Layout of a VkDispatchIndirectCommand (workgroup counts).
+ */
+struct DispatchIndirectCommand {
+    uint32_t groupCountX;
+    uint32_t groupCountY;
+    uint32_t groupCountZ;
+};
+
+/**
+ * @brief Slots of the LPC dispatch-indirect buffer, written by 5_dispatch_args.comp.
+ */
+enum LPCDispatchSlot : uint32_t {
+    LPC_DISPATCH_LEAVES = 0,   ///< numUnique threads (6_init_leaves).
+    LPC_DISPATCH_INTERNAL = 1, ///< numUnique - 1 threads (7_build_internal).
+    LPC_DISPATCH_NODES = 2,    ///< 2 * numUnique - 1 threads (10_cull_cut).
+    LPC_DISPATCH_COUNT
+};
+
+/// @name Radix Sort Constants
+/// Must match the defines in the 2_radix_*.comp shaders.
+/// @{
+constexpr uint32_t RADIX_SORT_BITS = 8;                                      ///< Bits sorted per pass.
+constexpr uint32_t RADIX_SORT_BINS = 1u << RADIX_SORT_BITS;                  ///< Digits per pass (= workgroup size).
+constexpr uint32_t RADIX_SORT_ITEMS_PER_THREAD = 16;                         ///< Keys per thread per tile.
+constexpr uint32_t RADIX_SORT_TILE_SIZE = RADIX_SORT_BINS * RADIX_SORT_ITEMS_PER_THREAD; ///< Keys per workgroup.
+constexpr uint32_t RADIX_SORT_MAX_PASSES = 64 / RADIX_SORT_BITS;             ///< Passes for a 64-bit key.
+/// @}
+
+/// @name Prefix Scan Constants
+/// Must match the defines in the 4_scan_*.comp shaders.
+/// @{
+constexpr uint32_t SCAN_ITEMS_PER_THREAD = 16;                               ///< Flags summed serially per thread.
+constexpr uint32_t SCAN_BLOCK_SIZE = 256 * SCAN_ITEMS_PER_THREAD;            ///< Flags per workgroup.
+/// @}
+
+/// @name Hierarchical Culling Constants
+/// Must match the defines in cull_nodes.comp.
+/// @{
+constexpr uint32_t CULL_CHUNK_SIZE = 4096; ///< Maximum points per work item (one cull_points workgroup).
+/// Set in visible indices (--cull-output=indices) that address a LOD proxy instead of a source point.
+/// Must match include/visible.glsl.
+constexpr uint32_t VISIBLE_PROXY_BIT = 0x80000000u;
+/// @}
+
+/// @name Streaming Loader Constants
+/// @{
+constexpr size_t STREAM_CHUNK_SIZE = 1 << 20;  ///< Points per batch of a PointSource, encoded and uploaded per chunk with --load=stream.
+constexpr uint32_t STREAM_UPLOAD_SLOTS = 3;     ///< Staging buffers in flight while streaming.
+/// @}
+
+/**
+ * @brief A range of Morton-sorted points emitted by the node culling pass.
+ */
+struct CullWorkItem {
+    uint32_t pointStart; ///< First point of the range in the sorted source buffer.
+    uint32_t pointCount; ///< Number of points, at most CULL_CHUNK_SIZE.
+    uint32_t needsTest;  ///< 1 if the range straddles the frustum and every point must be tested.
+};
+
+/**
+ * @brief Header of the culling work list buffer, followed by CullWorkItems.
+ */
+struct CullWorkListHeader {
+    uint32_t itemCount;
+    uint32_t padding[3];
+};
+
+/**
+ * @brief Per-frame counters of the hierarchical culling, for comparing it against per-point culling.
+ */
+struct CullStats {
+    uint32_t nodesVisited;  ///< Tree nodes whose bounds were tested against the frustum.
+    uint32_t pointsTested;  ///< Points tested individually (ranges of straddling leaves).
+    uint32_t rangesEmitted; ///< Node ranges appended to the work list.
+    uint32_t proxiesEmitted; ///< LOD proxies drawn in place of subtrees below the pixel threshold.
+    uint32_t nodesOccluded;  ///< Nodes still behind the Hi-Z pyramid in the second pass (--occlusion=on), or covered by the reprojected frame (--reproject).
+};
+
+/**
+ * @brief Screen-space-error parameters of the LOD traversal (uniform buffer).
+ */
+struct LODParams {
+    float pixelThreshold; ///< Subtrees projecting smaller than this many pixels are drawn as one proxy, 0 disables LOD.
+    float viewportHeight; ///< Height of the render target in pixels.
+    float padding[2];
+};
+
+/**
+ * @brief Per-pass parameters of the radix sort (uniform buffer).
+ */
+struct RadixSortParams {
+    uint32_t shift;    ///< Bit offset of the digit sorted in this pass.
+    uint32_t pass;     ///< Pass index, selects the slice of the global histogram.
+    uint32_t numTiles; ///< Number of RADIX_SORT_TILE_SIZE tiles covering the keys.
+};
+
 /**
  * @brief Manages the loading, processing, and GPU resource allocation for a point cloud.
  *
- * This class handles loading LAS/LAZ files via PDAL, normalizing coordinates,
+ * This class handles loading the inputs through their PointSource (LAS/LAZ
+ * files via PDAL, registered PLY scan sets), normalizing coordinates,
  * and creating the necessary Vulkan buffers (Source, Visible, Indirect, and Uniforms)
  * required for compute culling and rendering.
  */
@@ -63,39 +313,189 @@ public:
      * @brief Constructs the PointCloud instance and initializes GPU resources.
      *
      * @param tgai Reference to the TGA interface for resource creation.
+     * @param config Options selecting e.g. the Morton key width.
      */
-    PointCloud(tga::Interface& tgai);
+    PointCloud(tga::Interface& tgai, const Config& config = {});
+
+    /**
+     * @brief Constructs a PointCloud from points already in memory (e.g. generated ones).
+     *
+     * The points are used as they are, in viewer space; the bounds are
+     * computed from them. Nothing is read from or written to a cache.
+     *
+     * @param tgai Reference to the TGA interface for resource creation.
+     * @param points The points, moved into the cloud.
+     * @param config Options selecting e.g. the point format.
+     */
+    PointCloud(tga::Interface& tgai, PointAttributes points, const Config& config = {});
 
     ~PointCloud();
 
     /**
-     * @brief Loads point cloud data from a file using PDAL.
+     * @brief Loads all points of a source into host memory.
      *
-     * Performs two passes over the data:
-     * 1. Calculates global bounds for normalization.
-     * 2. Normalizes positions and remaps the coordinate system (Z-up to Y-up).
+     * The source delivers batches already normalized (viewer axes, shifted to
+     * start at 0 by the lower corner of its bounds), which are copied into the
+     * attribute arrays. Prints the ingest throughput in points per second.
      *
-     * @param filepath The path to the .las or .laz file.
+     * @param source The opened inputs (see openPointSources).
      */
-    void loadLAS(const std::string& filepath);
+    void loadPoints(PointSource& source);
+
+    /**
+     * @brief Streams a source to the GPU without holding it in host memory.
+     *
+     * Encodes each batch of the source in the configured point format into a
+     * ring of staging buffers and uploads it to the source buffers, so host
+     * memory stays O(STREAM_CHUNK_SIZE) instead of a multiple of the dataset.
+     * The bounds and point count the source reports when opened size the
+     * buffers and set up the quantization; points beyond that count are
+     * dropped. Leaves the CPU attribute arrays empty.
+     *
+     * @param source The opened inputs (see openPointSources).
+     */
+    void streamPoints(PointSource& source);
+
+    /**
+     * @brief Whether the LPC hierarchy was restored from a .pspire cache.
+     *
+     * All buffers the build would produce are then already filled, so the
+     * build can be skipped entirely.
+     *
+     * @return True if the points came from the cache.
+     */
+    bool isCached() const { return m_loadedFromCache; }
+
+    /**
+     * @brief Writes the built LPC hierarchy to the .pspire cache (next to the source file by default).
+     *
+     * Downloads the sorted points, the tree and the culling cut section by
+     * section. Does nothing if caching is disabled or the data came from the
+     * cache. Failures are reported and otherwise ignored.
+     *
+     * @return True if the cache file was written.
+     */
+    bool writeCache();
+
+    /**
+     * @brief Uploads a hierarchy built on the CPU in place of the GPU build.
+     *
+     * Fills the same buffers LPCBuilder::build() leaves behind: the sorted
+     * points become the source buffer, and the tree, bounds, proxies, culling
+     * cut, LPC uniforms and dispatch arguments are written directly.
+     *
+     * @param lpc The result of CpuLPCBuilder::build() for this cloud.
+     */
+    void uploadLPC(const LPCHierarchy& lpc);
+
+    /**
+     * @brief Reads back the current contents of one of the buffers stored in the cache.
+     * @param section The buffer to read, sized as in the cache (see getCacheSections()).
+     * @return The bytes of the buffer, empty if the section is unused in this point format.
+     */
+    std::vector<uint8_t> downloadSection(CacheSection section) const;
+
+    /**
+     * @brief Gets the points held in host memory.
+     * @return The loaded attributes in file order, empty when streamed or restored from the cache.
+     */
+    const PointAttributes& getAttributes() const { return m_attributes; }
+
+    /**
+     * @brief Gets a position as the shaders load it from the point buffers.
+     * @param position A position in the cloud bounds.
+     * @return The position itself, or its decoded quantized value in the compact format.
+     */
+    glm::vec3 getStoredPosition(const glm::vec3& position) const;
 
     /**
      * @brief Gets the buffer containing all loaded points.
      * @return A const reference to the GPU storage buffer containing the full dataset.
      */
-    const tga::Buffer& getSourceBuffer() const { return m_pointBuffer; }
+    const tga::Buffer& getSourceBuffer() const { return m_sourcePoints.points; }
 
     /**
      * @brief Gets the buffer destined to hold culled, visible points.
+     *
+     * With --cull-output=indices only frame 0 has one, as scratch of the GPU LPC
+     * build, and it is released once the build has finished.
+     *
+     * @param frame The frame in flight; frame 0 also serves as scratch of the LPC build.
      * @return A const reference to the GPU storage buffer for visible points.
      */
-    const tga::Buffer& getVisibleBuffer() const { return m_visiblePointBuffer; }
+    const tga::Buffer& getVisibleBuffer(uint32_t frame = 0) const { return m_frames[frame].visiblePoints.points; }
+
+    /**
+     * @brief Gets the buffer the culling writes the visible point indices into (--cull-output=indices).
+     * @param frame The frame in flight.
+     * @return A const reference to the buffer of 32-bit indices, empty with --cull-output=points.
+     */
+    const tga::Buffer& getVisibleIndexBuffer(uint32_t frame = 0) const { return m_frames[frame].visibleIndices; }
+
+    /**
+     * @brief Gets the buffer the culling of a frame writes, points or indices depending on the cull output.
+     * @param frame The frame in flight.
+     * @return The visible index buffer with --cull-output=indices, the visible point buffer otherwise.
+     */
+    const tga::Buffer& getCullOutputBuffer(uint32_t frame = 0) const {
+        return m_cullOutput == CullOutput::indices ? getVisibleIndexBuffer(frame) : getVisibleBuffer(frame);
+    }
+
+    /**
+     * @brief Gets what the culling writes for the draw pass.
+     * @return The --cull-output the cloud was created with.
+     */
+    CullOutput getCullOutput() const { return m_cullOutput; }
+
+    /**
+     * @brief Gets all attribute buffers of the source points.
+     * @return The source buffer and, in the SoA format, its color and intensity streams.
+     */
+    const PointBuffers& getSourcePoints() const { return m_sourcePoints; }
+
+    /**
+     * @brief Gets all attribute buffers of the visible points.
+     * @param frame The frame in flight.
+     * @return The visible buffer and, in the SoA format, its color and intensity streams.
+     */
+    const PointBuffers& getVisiblePoints(uint32_t frame = 0) const { return m_frames[frame].visiblePoints; }
+
+    /**
+     * @brief Gets the PointQuantization uniform buffer that decodes compact points.
+     * @return A const reference to the quantization uniform buffer.
+     */
+    const tga::Buffer& getQuantizationBuffer() const { return m_quantizationBuffer; }
+
+    /**
+     * @brief Gets the layout of the points in the GPU buffers.
+     * @return The format selected with --point-format.
+     */
+    PointFormat getPointFormat() const { return m_pointFormat; }
+
+    /**
+     * @brief Gets the GPU memory of one point, summed over all attribute buffers.
+     * @return sizeof(Point), sizeof(CompactPoint) or the sum of the SoA stream elements.
+     */
+    size_t getPointSize() const {
+        switch (m_pointFormat) {
+            case PointFormat::compact: return sizeof(CompactPoint);
+            case PointFormat::soa: return SOA_POSITION_SIZE + SOA_COLOR_SIZE + SOA_INTENSITY_SIZE;
+            default: return sizeof(Point);
+        }
+    }
 
     /**
      * @brief Gets the buffer containing indirect draw commands.
+     * @param frame The frame in flight.
      * @return A const reference to the indirect buffer modified by the compute shader.
      */
-    const tga::Buffer& getIndirectBuffer() const { return m_indirectDrawBuffer; }
+    const tga::Buffer& getIndirectBuffer(uint32_t frame = 0) const { return m_frames[frame].indirectDraw; }
+
+    /**
+     * @brief Gets the number of frames in flight with their own culling outputs.
+     * @return The --frames-in-flight the cloud was created with.
+     */
+    uint32_t getFramesInFlight() const { return static_cast<uint32_t>(m_frames.size()); }
 
     /**
      * @brief Gets the Uniform Buffer Object containing the total point count.
@@ -107,7 +507,7 @@ public:
      * @brief Gets the total number of points loaded on the CPU.
      * @return The number of points in the dataset.
      */
-    uint32_t getTotalPointCount() const { return static_cast<uint32_t>(m_points.size()); }
+    uint32_t getTotalPointCount() const { return static_cast<uint32_t>(m_pointCount); }
 
     /**
      * @brief Gets the Axis-Aligned Bounding Box of the normalized point cloud.
@@ -116,14 +516,32 @@ public:
     const AABB& getBounds() const { return m_bounds; }
 
     /**
-     * TODO write docs
-     * @return
+     * @brief Gets the number of meaningful bits in a Morton key (30 or 63).
+     * @return The key width selected with --morton-bits.
+     */
+    uint32_t getMortonKeyBits() const { return m_mortonBits; }
+
+    /**
+     * @brief Gets the size of one Morton key on the GPU (uint or uvec2).
+     * @return 4 for 30-bit keys, 8 for 63-bit keys.
+     */
+    size_t getMortonKeySize() const { return m_mortonBits > 32 ? sizeof(uint64_t) : sizeof(uint32_t); }
+
+    /**
+     * @brief Gets the number of radix sort passes needed for the key width.
+     * @return 4 for 30-bit keys, 8 for 63-bit keys.
+     */
+    uint32_t getRadixPassCount() const { return (m_mortonBits + RADIX_SORT_BITS - 1) / RADIX_SORT_BITS; }
+
+    /**
+     * @brief Gets the Morton key of every point, sorted in place by the build (build scratch).
+     * @return A const reference to a buffer of numPoints keys (see getMortonKeySize()).
      */
     const tga::Buffer& getMortonCodesBuffer() const { return m_mortonCodesBuffer; }
 
     /**
-     * TODO write docs
-     * @return
+     * @brief Gets the original index of every sorted point, read by the reorder stage (build scratch).
+     * @return A const reference to a buffer of numPoints indices.
      */
     const tga::Buffer& getSortIndicesBuffer() const { return m_sortIndicesBuffer; }
 
@@ -140,57 +558,352 @@ public:
     const tga::Buffer& getBitonicParamsBuffer() const { return m_bitonicParamsBuffer; }
 
     /**
-     * TODO write docs
-     * @return
+     * @brief Gets the flag marking the first point of every voxel, written once the sort is done.
+     *
+     * Aliases the alternate sort indices, which the radix sort leaves behind unused.
+     *
+     * @return A const reference to a buffer of numPoints flags.
      */
-    const tga::Buffer& getHeadFlagsBuffer() const { return m_headFlagsBuffer; }
+    const tga::Buffer& getHeadFlagsBuffer() const { return m_sortIndicesAltBuffer; }
 
     /**
-     * TODO write docs
-     * @return
+     * @brief Gets the exclusive scan of the head flags, i.e. the voxel of every point.
+     *
+     * Aliases the sort indices, which the reorder stage has consumed by then.
+     *
+     * @return A const reference to a buffer of numPoints indices.
      */
-    const tga::Buffer& getScannedIndicesBuffer() const { return m_scannedIndicesBuffer; }
+    const tga::Buffer& getScannedIndicesBuffer() const { return m_sortIndicesBuffer; }
 
     /**
-     * TODO write docs
-     * @return
+     * @brief Gets the Morton key of every voxel (leaf).
+     * @return A const reference to a buffer of numUnique keys.
      */
     const tga::Buffer& getUniqueCodesBuffer() const { return m_uniqueCodesBuffer; }
 
     /**
-     * TODO write docs
-     * @return
+     * @brief Gets the first sorted point of every voxel (leaf).
+     * @return A const reference to a buffer of numUnique indices.
      */
     const tga::Buffer& getVoxelStartsBuffer() const { return m_voxelStartsBuffer; }
 
     /**
-     * TODO write docs
-     * @return
+     * @brief Gets the nodes of the hierarchy, internal nodes first, then the leaves.
+     * @return A const reference to a buffer of 2 * numUnique - 1 Nodes.
      */
     const tga::Buffer& getNodesBuffer() const { return m_nodesBuffer; }
 
+    /**
+     * @brief Gets the ping-pong partner of the Morton codes buffer used by the radix sort.
+     * @return A const reference to the alternate key buffer.
+     */
+    const tga::Buffer& getMortonCodesAltBuffer() const { return m_mortonCodesAltBuffer; }
+
+    /**
+     * @brief Gets the ping-pong partner of the sort indices buffer used by the radix sort.
+     * @return A const reference to the alternate value buffer.
+     */
+    const tga::Buffer& getSortIndicesAltBuffer() const { return m_sortIndicesAltBuffer; }
+
+    /**
+     * @brief Gets the per-tile digit histograms (scanned in place into scatter offsets).
+     * @return A const reference to the buffer of RADIX_SORT_BINS * numTiles counters.
+     */
+    const tga::Buffer& getRadixTileHistogramBuffer() const { return m_radixTileHistogramBuffer; }
+
+    /**
+     * @brief Gets the global digit histograms, one slice of RADIX_SORT_BINS counters per pass.
+     * @return A const reference to the global histogram buffer.
+     */
+    const tga::Buffer& getRadixGlobalHistogramBuffer() const { return m_radixGlobalHistogramBuffer; }
+
+    /**
+     * @brief Gets the uniform buffer holding the RadixSortParams of the current pass.
+     * @return A const reference to the radix parameter buffer.
+     */
+    const tga::Buffer& getRadixParamsBuffer() const { return m_radixParamsBuffer; }
+
+    /**
+     * @brief Gets the number of radix sort tiles covering the dataset.
+     * @return The tile count, i.e. the number of workgroups per radix pass.
+     */
+    uint32_t getRadixTileCount() const { return (getTotalPointCount() + RADIX_SORT_TILE_SIZE - 1) / RADIX_SORT_TILE_SIZE; }
+
+    /**
+     * @brief Gets the per-block head flag sums of the GPU prefix scan (scanned in place into block offsets).
+     * @return A const reference to the buffer of getScanBlockCount() counters.
+     */
+    const tga::Buffer& getScanBlockSumsBuffer() const { return m_scanBlockSumsBuffer; }
+
+    /**
+     * @brief Gets the number of SCAN_BLOCK_SIZE blocks covering the dataset.
+     * @return The block count, i.e. the number of workgroups of the reduce/downsweep passes.
+     */
+    uint32_t getScanBlockCount() const { return (getTotalPointCount() + SCAN_BLOCK_SIZE - 1) / SCAN_BLOCK_SIZE; }
+
+    /**
+     * @brief Gets the dispatch-indirect buffer of the numUnique-sized LPC stages.
+     * @return A const reference to a buffer of LPC_DISPATCH_COUNT DispatchIndirectCommands.
+     */
+    const tga::Buffer& getLPCDispatchBuffer() const { return m_lpcDispatchBuffer; }
+
+    /**
+     * @brief Gets the per-node bounding boxes produced by the bottom-up refit.
+     * @return A const reference to a buffer of 2 * numUnique - 1 AABBs, indexed like the nodes.
+     */
+    const tga::Buffer& getNodeBoundsBuffer() const { return m_nodeBoundsBuffer; }
+
+    /**
+     * @brief Gets the per-internal-node visit counters used by the refit.
+     *
+     * Aliases the head flags, which the scatter stage has consumed by then;
+     * 8_refit_leaves clears the counters before 9_refit_internal climbs.
+     *
+     * @return A const reference to the refit counter buffer.
+     */
+    const tga::Buffer& getRefitFlagsBuffer() const { return m_sortIndicesAltBuffer; }
+
+    /**
+     * @brief Gets the LOD proxy of every node: the average of the points below it.
+     * @return A const reference to a buffer of 2 * numUnique - 1 Points, indexed like the nodes.
+     */
+    const tga::Buffer& getNodeProxyBuffer() const { return m_nodeProxies.points; }
+
+    /**
+     * @brief Gets all attribute buffers of the node proxies.
+     * @return The proxy buffer and, in the SoA format, its color and intensity streams.
+     */
+    const PointBuffers& getNodeProxies() const { return m_nodeProxies; }
+
+    /**
+     * @brief Gets the roots of the culling subtrees (a count followed by node indices).
+     * @return A const reference to the cut buffer written by 10_cull_cut.
+     */
+    const tga::Buffer& getCullCutBuffer() const { return m_cullCutBuffer; }
+
+    /**
+     * @brief Gets the list of point ranges emitted by the node culling pass.
+     * @param frame The frame in flight.
+     * @return A const reference to a CullWorkListHeader followed by CullWorkItems.
+     */
+    const tga::Buffer& getCullWorkListBuffer(uint32_t frame = 0) const { return m_frames[frame].cullWorkList; }
+
+    /**
+     * @brief Gets the dispatch-indirect command of the point culling pass (one workgroup per work item).
+     * @param frame The frame in flight.
+     * @return A const reference to the indirect buffer written by cull_args.
+     */
+    const tga::Buffer& getCullDispatchBuffer(uint32_t frame = 0) const { return m_frames[frame].cullDispatch; }
+
+    /**
+     * @brief Gets the per-frame culling counters.
+     * @param frame The frame in flight.
+     * @return A const reference to the CullStats buffer.
+     */
+    const tga::Buffer& getCullStatsBuffer(uint32_t frame = 0) const { return m_frames[frame].cullStats; }
+
+    /**
+     * @brief Gets the number of culling subtrees found by the last LPC build.
+     * @return The cut size, i.e. the number of threads of the node culling pass.
+     */
+    uint32_t getCullCutCount() const { return m_cullCutCount; }
+
+    /**
+     * @brief Records the number of culling subtrees once the LPC build has finished.
+     * @param cutCount The count 10_cull_cut wrote into the cut buffer.
+     */
+    void setCullCutCount(uint32_t cutCount) { m_cullCutCount = cutCount; }
+
+    /**
+     * @brief Makes the Morton-sorted points the source buffer.
+     *
+     * The reorder stage writes the sorted points into the visible buffer of frame 0.
+     * Swapping the two handles afterwards lets culling and rendering address
+     * points by the node ranges of the hierarchy. Must be called before any
+     * per-frame input set binds either buffer. The build scratch is released
+     * afterwards, with --cull-output=indices including the unsorted points.
+     */
+    void swapSortedPoints();
+
+    /**
+     * @brief Creates the scratch buffers of the GPU build, released again by swapSortedPoints().
+     *
+     * Buffers are shared between stages whose lifetimes do not overlap (see
+     * getHeadFlagsBuffer(), getScannedIndicesBuffer(), getRefitFlagsBuffer()),
+     * so the CPU build and a restored cache never allocate any of them.
+     */
+    void createBuildScratch();
+
+    /**
+     * @brief Creates the tree buffers sized for a hierarchy with the given leaf count.
+     *
+     * The CPU build and a restored cache know the count up front. The GPU
+     * build only learns it from its scan, so it builds into buffers sized for
+     * one leaf per point and shrinks them with compactTreeBuffers() afterwards.
+     *
+     * @param numUnique The number of distinct Morton codes, i.e. leaves.
+     */
+    void createTreeBuffers(uint32_t numUnique);
+
+    /**
+     * @brief Moves the tree built by the GPU into buffers sized for its actual leaf count.
+     *
+     * Downloads the used part of every tree section, recreates the buffers
+     * with createTreeBuffers() and uploads the sections again. Call it after
+     * setCullCutCount(), once the build has completed.
+     *
+     * @param numUnique The number of distinct Morton codes the build found.
+     */
+    void compactTreeBuffers(uint32_t numUnique);
+
+    /**
+     * @brief Gets the number of distinct Morton codes (leaves) found by the last LPC build.
+     * @return The unique count, or 0 if the hierarchy has not been built yet.
+     */
+    uint32_t getUniqueCount() const { return m_numUnique; }
+
+    /**
+     * @brief Gets the number of nodes of the hierarchy: numUnique - 1 internal nodes and numUnique leaves.
+     * @return 2 * numUnique - 1, or 0 if the hierarchy has not been built yet.
+     */
+    size_t getNodeCount() const { return m_numUnique > 0 ? 2 * static_cast<size_t>(m_numUnique) - 1 : 0; }
+
+    /**
+     * @brief Gets the bytes per point of each GPU stream in the configured format.
+     * @return Element sizes of the points, colors and intensities buffers, 0 for unused streams.
+     */
+    std::array<size_t, 3> getStreamStrides() const;
+
+    /**
+     * @brief Encodes a range of points into host arrays laid out like the GPU buffers.
+     *
+     * Point i of the attributes is written to element i of every stream, so
+     * callers pass stream pointers offset to wherever the range should land.
+     *
+     * @param attributes The points to encode.
+     * @param begin The first point to encode.
+     * @param count The number of points to encode.
+     * @param streams Destination of the points, colors and intensities streams (see getStreamStrides()).
+     * @param splatSizes Optional splat size of every point (LOD proxies), 0 if null.
+     */
+    void encodePoints(const PointAttributes& attributes, size_t begin, size_t count,
+                      const std::array<uint8_t*, 3>& streams, const float* splatSizes = nullptr) const;
+
 
 private:
+    /**
+     * @brief Creates the buffers besides the source points that do not depend on the build.
+     *
+     * Uploads the mapped cache into them if there is one. The build scratch and
+     * the tree follow with createBuildScratch() and createTreeBuffers().
+     */
+    void createBuffers();
+
+    /**
+     * @brief Creates the buffers of a set of points in the configured format.
+     * @param count The capacity in points.
+     * @param upload Whether to fill the buffers with the loaded points.
+     * @return The created buffers (color/intensity streams only for the SoA format).
+     */
+    PointBuffers createPointBuffers(size_t count, bool upload);
+
+    void freePointBuffers(PointBuffers& buffers);
+
+    /// Frees a buffer if it exists and clears the handle.
+    void freeBuffer(tga::Buffer& buffer);
+
+    /**
+     * @brief Releases the scratch buffers of the GPU build, nothing if there are none.
+     *
+     * With --cull-output=indices this includes the visible points of frame 0,
+     * whose culling never writes them.
+     */
+    void releaseBuildScratch();
+
+    /// Releases the tree buffers, nothing if there are none.
+    void releaseTreeBuffers();
+
+    /**
+     * @brief Sets the quantization grid of the compact format to the given bounds.
+     * @param bounds The bounds every encoded position lies in, 2^21 - 1 steps per axis.
+     */
+    void computeQuantization(const AABB& bounds);
+
+    /**
+     * @brief Quantizes a position to the grid of the compact format.
+     * @param position A position in the cloud bounds.
+     * @return The POINT_QUANTIZATION_BITS-bit grid coordinates per axis.
+     */
+    glm::uvec3 quantizePosition(const glm::vec3& position) const;
+
+    /**
+     * @brief Gets the buffer and the used size of every cache section.
+     * @return One (buffer, bytes) pair per CacheSection, unused SoA streams have no buffer.
+     */
+    std::vector<std::pair<tga::Buffer, size_t>> getCacheSections() const;
+
+    /**
+     * @brief Uploads every section of the mapped cache into its buffer and releases the mapping.
+     */
+    void uploadCache();
+
+    /**
+     * @brief Uploads host data into the buffers of the cache sections and waits for the copies.
+     * @param data The contents of every section, indexed by CacheSection; empty sections are skipped.
+     */
+    void uploadSections(const std::vector<std::span<const uint8_t>>& data);
+
     tga::Interface& m_tgai;
 
     // Data
-    std::vector<Point> m_points;
+    PointAttributes m_attributes; ///< Empty when the points were streamed (--load=stream).
+    size_t m_pointCount = 0;
+
+    // Cache
+    std::vector<std::string> m_sourcePaths;
+    std::string m_cachePath;             ///< Empty when caching is disabled.
+    std::unique_ptr<PointCache> m_cache; ///< Mapped until the sections are uploaded.
+    bool m_loadedFromCache = false;
     AABB m_bounds;
+    uint32_t m_numUnique = 0;
+    uint32_t m_cullCutCount = 0;
+    uint32_t m_mortonBits;
+    PointFormat m_pointFormat;
+    CullOutput m_cullOutput;
+    PointQuantization m_quantization{};
+
+    /// Outputs of the culling of one frame in flight, so successive frames do not wait for each other.
+    struct FrameBuffers {
+        PointBuffers visiblePoints;
+        tga::Buffer visibleIndices; ///< --cull-output=indices only.
+        tga::Buffer indirectDraw;
+        tga::Buffer cullWorkList;
+        tga::Buffer cullDispatch;
+        tga::Buffer cullStats;
+    };
 
     // Buffers
-    tga::Buffer m_pointBuffer;
-    tga::Buffer m_visiblePointBuffer;
-    tga::Buffer m_indirectDrawBuffer;
+    PointBuffers m_sourcePoints;
+    std::vector<FrameBuffers> m_frames;
     tga::Buffer m_pointCountBuffer;
     tga::Buffer m_mortonCodesBuffer;
-    tga::Buffer m_sortIndicesBuffer;
+    tga::Buffer m_sortIndicesBuffer;        ///< Then the scanned indices (build scratch).
     tga::Buffer m_lpcUniformsBuffer;
     tga::Buffer m_bitonicParamsBuffer;
-    tga::Buffer m_headFlagsBuffer;
-    tga::Buffer m_scannedIndicesBuffer;
     tga::Buffer m_uniqueCodesBuffer;
     tga::Buffer m_voxelStartsBuffer;
     tga::Buffer m_nodesBuffer;
+    tga::Buffer m_mortonCodesAltBuffer;
+    tga::Buffer m_sortIndicesAltBuffer;     ///< Then the head flags, then the refit counters (build scratch).
+    tga::Buffer m_radixTileHistogramBuffer;
+    tga::Buffer m_radixGlobalHistogramBuffer;
+    tga::Buffer m_radixParamsBuffer;
+    tga::Buffer m_scanBlockSumsBuffer;
+    tga::Buffer m_lpcDispatchBuffer;
+    tga::Buffer m_nodeBoundsBuffer;
+    PointBuffers m_nodeProxies;
+    tga::Buffer m_quantizationBuffer;
+    tga::Buffer m_cullCutBuffer;
 
 };
 
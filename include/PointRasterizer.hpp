@@ -0,0 +1,134 @@
+#pragma once
+#ifndef POINTSPIRE_POINT_RASTERIZER_HPP
+#define POINTSPIRE_POINT_RASTERIZER_HPP
+
+#include "tga/tga.hpp"
+#include <cstdint>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "PointCloud.hpp"
+
+/**
+ * @brief Size of the point framebuffer (uniform buffer of the raster shaders).
+ */
+struct RasterParams {
+    uint32_t width;
+    uint32_t height;
+    uint32_t padding[2];
+};
+
+/**
+ * @brief Compute-shader rasterization of the visible points (--render=compute).
+ *
+ * Instead of one instanced quad per point, raster_points projects every
+ * visible point to a single pixel and resolves visibility with a 64-bit
+ * atomicMin on depth | color in a storage buffer framebuffer. A fullscreen
+ * pass then writes the covered pixels into the render target. The point count
+ * comes from the indirect draw command the culling filled, so the raster pass
+ * is dispatched indirectly. Every frame in flight of the cloud gets its own
+ * framebuffer. With --reproject, a frame can instead start from the
+ * framebuffer of the previous frame in flight, moved to its camera, and
+ * rasterize only the points the culling found over its gaps. Requires
+ * shaderInt64 and shaderBufferInt64Atomics, enabled on TGA's device by
+ * DeviceFeatures and checked on construction.
+ */
+class PointRasterizer {
+public:
+    /**
+     * @brief Creates the raster passes, the resolve pass into a window and the per-frame framebuffers.
+     *
+     * The framebuffers match the resolution of the window.
+     *
+     * @param tgai Reference to the TGA interface for resource creation.
+     * @param pointCloud The built cloud; its buffers are bound, so it must outlive the rasterizer.
+     * @param cameraUbos The camera uniform buffer (model, view, proj) of every frame in flight of the cloud.
+     * @param window The window the resolve pass draws into.
+     * @param clear Clear operation of the resolve pass: none to draw over a background, all otherwise.
+     * @throws std::runtime_error If the GPU lacks 64-bit buffer atomics.
+     */
+    PointRasterizer(tga::Interface& tgai, const PointCloud& pointCloud, const std::vector<tga::Buffer>& cameraUbos,
+                    tga::Window window, tga::ClearOperation clear);
+
+    /**
+     * @brief Creates the raster passes, the resolve pass into a texture and the per-frame framebuffers.
+     *
+     * @param tgai Reference to the TGA interface for resource creation.
+     * @param pointCloud The built cloud; its buffers are bound, so it must outlive the rasterizer.
+     * @param cameraUbos The camera uniform buffer (model, view, proj) of every frame in flight of the cloud.
+     * @param texture The texture the resolve pass draws into.
+     * @param width Width of the texture in pixels.
+     * @param height Height of the texture in pixels.
+     * @param clear Clear operation of the resolve pass: none to draw over a background, all otherwise.
+     * @throws std::runtime_error If the GPU lacks 64-bit buffer atomics.
+     */
+    PointRasterizer(tga::Interface& tgai, const PointCloud& pointCloud, const std::vector<tga::Buffer>& cameraUbos,
+                    tga::Texture texture, uint32_t width, uint32_t height, tga::ClearOperation clear);
+
+    ~PointRasterizer();
+
+    PointRasterizer(const PointRasterizer&) = delete;
+    PointRasterizer& operator=(const PointRasterizer&) = delete;
+
+    /**
+     * @brief Records the clear and the rasterization of the visible points of a frame.
+     *
+     * Records after the culling of the frame; the barriers on both sides are included.
+     *
+     * @param recorder The recorder of the frame command buffer.
+     * @param frame The frame in flight whose culling output is rasterized.
+     * @param clear False to rasterize over what recordReprojection() left in the framebuffer.
+     */
+    void recordRaster(tga::CommandRecorder& recorder, uint32_t frame, bool clear = true);
+
+    /**
+     * @brief Records the clear of the framebuffer of a frame and the reprojection of the previous frame into it.
+     *
+     * Every sample of the framebuffer of the previous frame in flight is moved
+     * from the camera it was drawn with to the camera of this frame. Needs at
+     * least two frames in flight; the barriers on both sides are included.
+     *
+     * @param recorder The recorder of the frame command buffer.
+     * @param frame The frame in flight whose framebuffer is written.
+     */
+    void recordReprojection(tga::CommandRecorder& recorder, uint32_t frame);
+
+    /**
+     * @brief Records the resolve of the framebuffer of a frame into the render target.
+     *
+     * @param recorder The recorder of the frame command buffer.
+     * @param frame The frame in flight.
+     * @param targetFrame The image of the render target (the swapchain image of a window, 0 for a texture).
+     */
+    void recordResolve(tga::CommandRecorder& recorder, uint32_t frame, uint32_t targetFrame);
+
+    /// Gets the framebuffer (packed depth | color per pixel, window resolution) of every frame in flight.
+    const std::vector<tga::Buffer>& getFramebuffers() const { return m_framebuffers; }
+
+private:
+    PointRasterizer(tga::Interface& tgai, const PointCloud& pointCloud, const std::vector<tga::Buffer>& cameraUbos,
+                    std::variant<tga::Window, tga::Texture> target, std::pair<uint32_t, uint32_t> size,
+                    tga::ClearOperation clear);
+
+    tga::Interface& m_tgai;
+    const PointCloud& m_pointCloud;
+    uint32_t m_pixelCount;
+
+    tga::Buffer m_paramsBuffer;              ///< RasterParams.
+    std::vector<tga::Buffer> m_framebuffers; ///< Per frame: one packed depth | color uint64 per pixel.
+    std::vector<tga::Buffer> m_dispatchArgs; ///< Per frame: DispatchIndirectCommand of raster_points.
+
+    tga::ComputePass m_clearPass;
+    tga::ComputePass m_argsPass;
+    tga::ComputePass m_rasterPass;
+    tga::ComputePass m_reprojectPass;
+    tga::RenderPass m_resolvePass;
+    std::vector<tga::InputSet> m_clearSets;  ///< Per frame in flight, like the sets below.
+    std::vector<tga::InputSet> m_argsSets;
+    std::vector<tga::InputSet> m_rasterSets;
+    std::vector<tga::InputSet> m_reprojectSets; ///< Reads the framebuffer of the previous frame in flight.
+    std::vector<tga::InputSet> m_resolveSets;
+};
+
+#endif //POINTSPIRE_POINT_RASTERIZER_HPP
@@ -0,0 +1,93 @@
+#pragma once
+#ifndef POINTSPIRE_POINT_SOURCE_HPP
+#define POINTSPIRE_POINT_SOURCE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PointCloud.hpp"
+
+/**
+ * @brief Bounds of a source in viewer axes (Y up), in double precision.
+ *
+ * Kept in double so georeferenced coordinates survive until the common
+ * origin is subtracted; only the shifted positions are stored as float.
+ */
+struct SourceBounds {
+    glm::dvec3 min{std::numeric_limits<double>::max()};
+    glm::dvec3 max{std::numeric_limits<double>::lowest()};
+
+    bool empty() const { return min.x > max.x; }
+
+    void grow(const SourceBounds& other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+};
+
+/**
+ * @brief Reader of one input of the point pipeline (--input).
+ *
+ * Every source delivers the same format: batches of PointAttributes in
+ * viewer axes, shifted by an origin the caller picks from the bounds of all
+ * inputs. The bounds and an upper bound of the point count are known once
+ * the source is opened, so the caller can size its buffers and set up the
+ * normalization before the first point is read.
+ */
+class PointSource {
+public:
+    /**
+     * @brief Called for every batch: the first count points of the batch are valid.
+     *
+     * The batch is reused after the call returns. batchBounds are the bounds of
+     * those points after the shift.
+     */
+    using BatchFn = std::function<void(const PointAttributes& batch, size_t count, const AABB& batchBounds)>;
+
+    virtual ~PointSource() = default;
+
+    /// Gets the input this source reads, for messages.
+    virtual std::string getName() const = 0;
+
+    /// Gets the number of points, an upper bound if the input does not know it exactly.
+    virtual size_t getPointCount() const = 0;
+
+    /// Gets the bounds of all points in viewer axes, before any shift.
+    virtual const SourceBounds& getBounds() const = 0;
+
+    /**
+     * @brief Reads all points once, in batches of at most STREAM_CHUNK_SIZE.
+     *
+     * @param origin Subtracted from every position (in viewer axes) before it is converted to float.
+     * @param fn Called for every batch, in input order.
+     */
+    virtual void read(const glm::dvec3& origin, const BatchFn& fn) = 0;
+};
+
+/**
+ * @brief Opens the reader matching the extension of a path.
+ *
+ * .conf files are registered PLY scan sets (see loadBunny), everything else
+ * is read by PDAL as LAS/LAZ.
+ *
+ * @param path The input path.
+ * @return The opened source; throws std::runtime_error if it cannot be read.
+ */
+std::unique_ptr<PointSource> openPointSource(const std::string& path);
+
+/**
+ * @brief Opens every input and merges them into one source.
+ *
+ * The merged source reads the inputs one after another; its bounds and
+ * point count are those of all inputs together.
+ *
+ * @param paths The input paths, at least one.
+ * @return A single source for one path, the merged source otherwise.
+ */
+std::unique_ptr<PointSource> openPointSources(const std::vector<std::string>& paths);
+
+#endif //POINTSPIRE_POINT_SOURCE_HPP
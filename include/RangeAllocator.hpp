@@ -0,0 +1,54 @@
+#pragma once
+#ifndef POINTSPIRE_RANGE_ALLOCATOR_HPP
+#define POINTSPIRE_RANGE_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+/**
+ * @brief First-fit allocator of ranges in a linear space, e.g. elements or bytes of a GPU buffer.
+ *
+ * Only the bookkeeping lives here; the caller owns the memory the offsets
+ * refer to. Free ranges are kept sorted by offset and merged with their
+ * neighbours when released, so a long-running mix of sizes stays
+ * defragmented as far as the live ranges allow.
+ */
+class RangeAllocator {
+public:
+    static constexpr size_t INVALID_OFFSET = SIZE_MAX; ///< Returned by allocate() when no free range fits.
+
+    /**
+     * @brief Creates an allocator over [0, capacity), all of it free.
+     * @param capacity Size of the space in the caller's units.
+     */
+    explicit RangeAllocator(size_t capacity);
+
+    /**
+     * @brief Takes the first free range that fits.
+     * @param size Size of the range, must be > 0.
+     * @param alignment Alignment of the offset, a power of two.
+     * @return The offset of the range, INVALID_OFFSET if no free range fits.
+     */
+    size_t allocate(size_t size, size_t alignment = 1);
+
+    /**
+     * @brief Returns a range from allocate() to the free ranges.
+     * @param offset The offset allocate() returned.
+     * @param size The size passed to allocate().
+     */
+    void release(size_t offset, size_t size);
+
+    size_t getCapacity() const { return m_capacity; }
+    size_t getUsed() const { return m_used; }
+
+    /// Gets the size of the largest free range, what the next allocate() can at most get.
+    size_t getLargestFree() const;
+
+private:
+    std::map<size_t, size_t> m_free; ///< Offset -> size of every free range.
+    size_t m_capacity;
+    size_t m_used = 0;
+};
+
+#endif //POINTSPIRE_RANGE_ALLOCATOR_HPP
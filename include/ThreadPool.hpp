@@ -0,0 +1,74 @@
+#pragma once
+#ifndef POINTSPIRE_THREAD_POOL_HPP
+#define POINTSPIRE_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads running chunked parallel loops.
+ *
+ * The calling thread takes part in every loop as worker 0, so a pool of one
+ * thread runs everything inline. Loops must not be nested and the loop body
+ * must not throw.
+ */
+class ThreadPool {
+public:
+    /// Calls made by parallelFor: fn(worker, begin, end) for one chunk of the range.
+    using ChunkFn = std::function<void(unsigned worker, size_t begin, size_t end)>;
+
+    /**
+     * @brief Starts the worker threads.
+     * @param threadCount Workers including the caller, 0 for one per hardware thread.
+     */
+    explicit ThreadPool(unsigned threadCount = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Gets the number of workers, i.e. the range of the worker id passed to the loop body.
+     * @return The worker thread count plus the caller.
+     */
+    unsigned size() const { return static_cast<unsigned>(m_threads.size()) + 1; }
+
+    /**
+     * @brief Calls fn for every grain-sized chunk of [0, count) and waits for all of them.
+     *
+     * Chunks are handed out dynamically, so fn may keep per-worker state
+     * indexed by the worker id but must not depend on which worker runs a chunk.
+     *
+     * @param count The number of items.
+     * @param grain The number of items per chunk.
+     * @param fn The loop body.
+     */
+    void parallelFor(size_t count, size_t grain, const ChunkFn& fn);
+
+private:
+    void workerLoop(unsigned worker);
+    void runChunks(unsigned worker);
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+
+    // The current loop, published under the mutex
+    const ChunkFn* m_job = nullptr;
+    size_t m_count = 0;
+    size_t m_grain = 1;
+    std::atomic<size_t> m_nextChunk{0};
+    unsigned m_busyWorkers = 0;
+    uint64_t m_generation = 0;
+    bool m_stop = false;
+};
+
+#endif //POINTSPIRE_THREAD_POOL_HPP
@@ -0,0 +1,203 @@
+#pragma once
+#ifndef POINTSPIRE_TILE_MANAGER_HPP
+#define POINTSPIRE_TILE_MANAGER_HPP
+
+#include "tga/tga.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Config.hpp"
+#include "PointCloud.hpp"
+#include "RangeAllocator.hpp"
+#include "UploadService.hpp"
+
+constexpr size_t TILE_MAX_PENDING_LOADS = 4; ///< Tiles read by the loader thread but not uploaded yet, bounds the host memory.
+constexpr size_t TILE_UPLOAD_POINTS_PER_FRAME = 2 * STREAM_CHUNK_SIZE; ///< Points staged per update at most, bounds the upload work of a frame.
+
+/**
+ * @brief One LAS tile of a tiled dataset (--tiles), as indexed from its header.
+ */
+struct TileInfo {
+    std::string path;
+    AABB bounds;          ///< In the viewer space shared by all tiles (shifted by the lower corner of the dataset).
+    size_t pointCount;    ///< From the header, an upper bound of what the tile holds.
+};
+
+/**
+ * @brief Counters of the tile residency, cumulative except where noted.
+ */
+struct TileStats {
+    size_t tileCount = 0;       ///< Tiles in the index.
+    size_t residentTiles = 0;   ///< Tiles in GPU memory.
+    size_t residentBytes = 0;   ///< GPU memory of the resident tiles.
+    size_t budgetBytes = 0;     ///< --tile-budget.
+    size_t visibleTiles = 0;    ///< Last update: tiles in the frustum that fit the budget.
+    size_t drawnTiles = 0;      ///< Last update: of those, the resident ones.
+    uint64_t hits = 0;          ///< Visible tiles found resident, summed over all updates.
+    uint64_t misses = 0;        ///< Visible tiles that had to be requested.
+    uint64_t evictions = 0;     ///< Tiles dropped to make room for others.
+    uint64_t uploadedBytes = 0; ///< Tile data copied into the arena.
+
+    /// Gets the share of visible tiles that were resident, 0 before the first lookup.
+    double getHitRate() const { return hits + misses > 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0; }
+};
+
+/**
+ * @brief Range of the point arena drawn for one resident tile.
+ *
+ * Drawn as instances [firstPoint, firstPoint + pointCount) of the point quad,
+ * so bunny_primitive reads the tile straight from the arena.
+ */
+struct TileDraw {
+    uint32_t firstPoint;
+    uint32_t pointCount;
+};
+
+/**
+ * @brief Streams a tiled LAS dataset through a fixed GPU memory budget (--tiles, --tile-budget).
+ *
+ * Indexes the header bounds of every tile up front. Each update picks the
+ * tiles in the view frustum, nearest first, as far as they fit the budget
+ * together, and queues the missing ones for a loader thread that reads them
+ * through LasSource. Loaded tiles are encoded in the configured point format
+ * straight into the staging ring of an UploadService, at most
+ * TILE_UPLOAD_POINTS_PER_FRAME per update, and copied without waiting into a
+ * point arena: one storage buffer per stream, sized to the budget and
+ * sub-allocated per tile with a RangeAllocator. A tile is drawn from the
+ * frame its last batch is submitted in. When the arena is
+ * full, the least recently visible tiles are evicted; their ranges are reused
+ * only once every frame in flight that could still draw them has completed.
+ *
+ * Tiles are culled against the frustum as a whole; the points of a drawn tile
+ * are not culled individually.
+ */
+class TileManager {
+public:
+    /**
+     * @brief Indexes the tiles, creates the arena and starts the loader thread.
+     *
+     * @param tgai Reference to the TGA interface for resource creation.
+     * @param config Options: --tiles, --tile-budget, the point format and the frames in flight.
+     */
+    TileManager(tga::Interface& tgai, const Config& config);
+
+    ~TileManager();
+
+    TileManager(const TileManager&) = delete;
+    TileManager& operator=(const TileManager&) = delete;
+
+    /**
+     * @brief Selects, requests, uploads and evicts tiles for a frame and fills the draw list.
+     *
+     * Must be called after the frame's command buffer slot has completed, as
+     * uploads may reuse arena ranges evicted framesInFlight frames before.
+     * The uploads are submitted but not waited for: the frame's command buffer
+     * needs a Transfer -> VertexShader barrier before drawing.
+     *
+     * @param viewProjection proj * view * model of the frame's camera.
+     * @param eye The camera position in viewer space.
+     * @param frameNumber A counter incremented once per frame.
+     */
+    void update(const glm::mat4& viewProjection, const glm::vec3& eye, uint64_t frameNumber);
+
+    /// Gets the arena ranges of the visible resident tiles of the last update.
+    const std::vector<TileDraw>& getDraws() const { return m_draws; }
+
+    /**
+     * @brief Gets the binding layout and bindings of the point draw pass (bunny_primitive.vert) over the arena.
+     *
+     * @param cameraUbo The camera uniform buffer of the frame.
+     * @param layout Receives the binding layouts of the pass.
+     * @param bindings Receives the bindings of the input set.
+     */
+    void getDrawBindings(const tga::Buffer& cameraUbo, std::vector<tga::BindingLayout>& layout,
+                         std::vector<tga::Binding>& bindings) const;
+
+    const TileStats& getStats() const { return m_stats; }
+
+    /// Gets the bandwidth and latency of the tile uploads.
+    const UploadStats& getUploadStats() const { return m_uploads->getStats(); }
+
+    /// Gets the bounds of the whole dataset in viewer space.
+    const AABB& getBounds() const { return m_bounds; }
+
+private:
+    enum class TileState {
+        unloaded,  ///< Neither resident nor queued.
+        requested, ///< Queued for or being read by the loader thread.
+        uploading, ///< Has its arena range, some of its batches are not submitted yet.
+        resident,  ///< In the arena at firstPoint.
+        failed     ///< Could not be read, never requested again.
+    };
+
+    struct Tile {
+        TileInfo info;
+        TileState state = TileState::unloaded;
+        size_t firstPoint = 0;
+        size_t loadedCount = 0;  ///< Points in the arena while uploading or resident.
+        uint64_t lastUsed = 0;   ///< Last update that selected the tile, resident or not.
+    };
+
+    /// A tile read by the loader thread, waiting for (the rest of) its upload.
+    struct LoadedTile {
+        size_t tile;
+        std::vector<PointAttributes> batches; ///< As delivered by LasSource, each uploaded as a whole.
+        size_t pointCount = 0;
+        size_t uploadedBatches = 0;
+        size_t uploadedPoints = 0;
+        UploadService::Clock::time_point loadedAt;
+    };
+
+    /// Arena range of an evicted tile, freed once no frame in flight can draw it anymore.
+    struct RetiredRange {
+        uint64_t frameNumber;
+        size_t firstPoint;
+        size_t count;
+    };
+
+    void loaderLoop();
+
+    /// Allocates arena ranges for loaded tiles and stages their batches as far as the staging ring allows.
+    void uploadTiles(std::vector<LoadedTile>& loaded, uint64_t frameNumber);
+
+    /// Allocates an arena range, evicting least recently selected tiles; INVALID_OFFSET if it does not fit (yet).
+    size_t allocateRange(size_t count, uint64_t frameNumber);
+
+    void evict(size_t tile, uint64_t frameNumber);
+
+    tga::Interface& m_tgai;
+    PointFormat m_pointFormat;
+    uint32_t m_framesInFlight;
+    size_t m_bytesPerPoint = 0;
+
+    std::vector<Tile> m_tiles;
+    glm::dvec3 m_origin{0.0};     ///< Lower corner of the dataset in viewer axes, subtracted by the loader.
+    AABB m_bounds{};
+    PointQuantization m_quantization{};
+
+    tga::Buffer m_quantizationBuffer;
+    PointBuffers m_arena;
+    std::unique_ptr<UploadService> m_uploads;
+    RangeAllocator m_allocator;    ///< In points.
+    std::vector<RetiredRange> m_retired;
+    std::vector<size_t> m_visible; ///< Tiles selected by the last update, nearest first.
+    std::vector<TileDraw> m_draws;
+    TileStats m_stats;
+
+    // Loader thread, the shared state below is guarded by m_mutex
+    std::thread m_loader;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<size_t> m_requests;    ///< Tiles to read, nearest first.
+    std::vector<LoadedTile> m_loaded; ///< Read tiles for the next update.
+    size_t m_loading = 0;             ///< Tiles being read right now.
+    bool m_stop = false;
+};
+
+#endif //POINTSPIRE_TILE_MANAGER_HPP
@@ -0,0 +1,132 @@
+#pragma once
+#ifndef POINTSPIRE_UPLOAD_SERVICE_HPP
+#define POINTSPIRE_UPLOAD_SERVICE_HPP
+
+#include "tga/tga.hpp"
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Counters of the completed upload batches.
+ */
+struct UploadStats {
+    uint64_t bytes = 0;         ///< Copied by completed batches.
+    uint64_t batches = 0;       ///< Completed batches.
+    uint64_t refused = 0;       ///< reserve() calls refused because every staging slot was in flight.
+    double queuedMs = 0.0;      ///< Mean time from the data being on the host to the submission of its batch.
+    double readyMs = 0.0;       ///< Mean time from the data being on the host to its batch being seen complete.
+    double maxReadyMs = 0.0;    ///< Longest of those.
+    double bandwidthMBs = 0.0;  ///< MiB completed per second, over the last second with uploads.
+};
+
+/**
+ * @brief Batches buffer uploads through a bounded ring of reused staging buffers, without waiting for them.
+ *
+ * Every batch owns one staging slot: callers reserve staging memory in the
+ * open batch, write their data straight into the mapping, record copies out
+ * of it and submit the batch once per frame. Submission does not block;
+ * work submitted afterwards on the queue sees the copies behind a
+ * Transfer -> consumer barrier. A slot is reused only after its batch is
+ * known to be complete, so the ring bounds the staging memory and applies
+ * back pressure instead of allocating.
+ *
+ * Completion is learnt from the frames in flight: once the command buffer of
+ * a frame has been waited for, every batch submitted before it has completed
+ * too (see collect()), so the render loop never waits on an upload.
+ */
+class UploadService {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Creates the staging ring.
+     *
+     * @param tgai Reference to the TGA interface for resource creation.
+     * @param slotSize Staging bytes per batch.
+     * @param slotCount Batches in flight at most; a batch per frame needs framesInFlight + 1.
+     */
+    UploadService(tga::Interface& tgai, size_t slotSize, uint32_t slotCount);
+
+    /// Waits for the batches in flight and frees the ring.
+    ~UploadService();
+
+    UploadService(const UploadService&) = delete;
+    UploadService& operator=(const UploadService&) = delete;
+
+    /**
+     * @brief Gets the staging bytes a reserve() without waiting can take right now.
+     * @return What is left in the open batch, the slot size if the next slot is free, 0 otherwise.
+     */
+    size_t getAvailable() const;
+
+    /**
+     * @brief Reserves staging memory in the open batch, opening a batch in the next slot if none is open.
+     *
+     * @param size Bytes to reserve, at most the slot size.
+     * @param wait Whether to wait for the next slot when it is still in flight (loading before the first frame).
+     * @return The mapped staging memory, 16-byte aligned; nullptr if it does not fit in the open batch,
+     *         or if the next slot is in flight and wait is false.
+     */
+    uint8_t* reserve(size_t size, bool wait = false);
+
+    /**
+     * @brief Records a copy out of reserved staging memory into a buffer.
+     *
+     * @param staged Start of the data, inside a reservation of the open batch.
+     * @param dst The destination buffer.
+     * @param dstOffset Byte offset in the destination.
+     * @param size Bytes to copy.
+     */
+    void copy(const uint8_t* staged, const tga::Buffer& dst, size_t dstOffset, size_t size);
+
+    /**
+     * @brief Submits the open batch without waiting for it, nothing if no batch is open.
+     *
+     * @param dataSince When the oldest data of the batch became available on the host.
+     * @param frameNumber The frame the batch belongs to, for collect().
+     */
+    void submit(Clock::time_point dataSince, uint64_t frameNumber = 0);
+
+    /**
+     * @brief Retires the batches submitted up to a frame whose command buffer has completed.
+     *
+     * Batches are submitted before their frame's command buffer on the same
+     * queue, so they completed no later than it.
+     *
+     * @param completedFrame The last frame known to have completed.
+     */
+    void collect(uint64_t completedFrame);
+
+    const UploadStats& getStats() const { return m_stats; }
+
+private:
+    struct Slot {
+        tga::StagingBuffer staging;
+        uint8_t* mapping = nullptr;
+        tga::CommandBuffer commands;
+        size_t used = 0;
+        bool inFlight = false;
+        uint64_t frameNumber = 0;
+        Clock::time_point dataSince;
+        Clock::time_point submitted;
+    };
+
+    /// Waits for the batch of a slot (instant once collect() knows it completed) and counts it.
+    void retire(Slot& slot);
+
+    tga::Interface& m_tgai;
+    size_t m_slotSize;
+    std::vector<Slot> m_slots;
+    size_t m_next = 0;                               ///< Slot of the open or next batch.
+    std::optional<tga::CommandRecorder> m_recorder;  ///< Records the open batch.
+
+    UploadStats m_stats;
+    double m_queuedMsTotal = 0.0;
+    double m_readyMsTotal = 0.0;
+    Clock::time_point m_windowStart{};               ///< Start of the bandwidth window.
+    uint64_t m_windowBytes = 0;
+};
+
+#endif //POINTSPIRE_UPLOAD_SERVICE_HPP
@@ -2,12 +2,14 @@
 #include <iostream>
 #include "Application.hpp"
 #include "Camera.hpp"
+#include "Config.hpp"
 #include "Scene.hpp"
 
-int main() {
+int main(int argc, char** argv) {
     try {
+        Config config = parseCommandLine(argc, argv);
         tga::Interface tgai;
-        Application app(tgai);
+        Application app(tgai, config);
         app.run();
     } catch (const std::exception& e) {
         std::cerr << "Fatal Error: " << e.what() << "\n";
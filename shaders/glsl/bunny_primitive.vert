@@ -1,4 +1,5 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 // Binding 0: Camera/Scene Data
 layout(set = 0, binding = 0) uniform SceneData {
@@ -9,17 +10,28 @@ layout(set = 0, binding = 0) uniform SceneData {
     int colorMode;
 } ubo;
 
-// Binding 1: Point Cloud Data (SSBO)
-// Matching C++ struct Point with alignas(16)
-struct Point {
-    vec3 position;  // std430 aligns vec3 to 16 bytes
-    vec3 color;     // std430 aligns vec3 to 16 bytes
-    float intensity;
-};
+// Binding 1: Point Cloud Data (SSBO), positions only in the SoA layout
+// Binding 2: Point quantization (decodes the compact layout)
+#define POINT_QUANTIZATION_BINDING 2
+#include "include/point.glsl"
+#include "include/visible.glsl"
+
+#ifdef CULL_INDICES
+// Binding 1 holds the source points, fetched through the culled indices
+// Binding 3: Visible indices
+// Binding 4: LOD proxies, fetched for indices with VISIBLE_PROXY_BIT set
+// Binding 5, 6 / 7, 8: Source / proxy colors and intensities (SoA layout only)
+POINT_BUFFER(readonly, points, 1, 5, 6);
+POINT_BUFFER(readonly, proxies, 4, 7, 8);
 
-layout(std430, set = 0, binding = 1) readonly buffer PointBuffer {
-    Point points[];
-} pointData;
+layout(std430, set = 0, binding = 3) readonly buffer VisibleIndices {
+    uint visibleIndices[];
+};
+#else
+// Binding 1 holds the visible points
+// Binding 3, 4: Colors and intensities (SoA layout only)
+POINT_BUFFER(readonly, points, 1, 3, 4);
+#endif
 
 layout(location = 0) out vec3 fragColor;
 
@@ -29,7 +41,17 @@ const vec2 offsets[6] = vec2[](
 );
 
 void main() {
-    Point pt = pointData.points[gl_InstanceIndex];
+#ifdef CULL_INDICES
+    uint index = visibleIndices[gl_InstanceIndex];
+    Point pt;
+    if ((index & VISIBLE_PROXY_BIT) != 0u) {
+        pt = loadPoint(proxies, index & ~VISIBLE_PROXY_BIT);
+    } else {
+        pt = loadPoint(points, index);
+    }
+#else
+    Point pt = loadPoint(points, gl_InstanceIndex);
+#endif
     vec3 centerPos = pt.position;
 
     // --- Render with True Colors ---
@@ -40,7 +62,8 @@ void main() {
     // fragColor = vec3(pt.intensity);
 
     // Quad Generation
-    float pointSize = 0.025;
+    // LOD proxies carry the half extent of the node they stand in for
+    float pointSize = max(POINT_MIN_SPLAT_SIZE, pt.splatSize);
     vec2 offset = offsets[gl_VertexIndex] * pointSize;
 
     vec4 viewPos = ubo.view * ubo.model * vec4(centerPos, 1.0);
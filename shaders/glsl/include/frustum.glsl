@@ -0,0 +1,47 @@
+// Shared frustum tests for the culling shaders.
+#ifndef POINTSPIRE_FRUSTUM_GLSL
+#define POINTSPIRE_FRUSTUM_GLSL
+
+#define FRUSTUM_OUTSIDE 0u
+#define FRUSTUM_INTERSECT 1u
+#define FRUSTUM_INSIDE 2u
+
+// Extracts the six clip planes (Gribb-Hartmann) of a Vulkan projection, depth range [0, 1].
+// Plane normals point inwards, a point p is inside if dot(plane.xyz, p) + plane.w >= 0.
+void extractFrustumPlanes(mat4 m, out vec4 planes[6]) {
+    vec4 r0 = vec4(m[0][0], m[1][0], m[2][0], m[3][0]);
+    vec4 r1 = vec4(m[0][1], m[1][1], m[2][1], m[3][1]);
+    vec4 r2 = vec4(m[0][2], m[1][2], m[2][2], m[3][2]);
+    vec4 r3 = vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = r3 + r0; // Left
+    planes[1] = r3 - r0; // Right
+    planes[2] = r3 + r1; // Bottom
+    planes[3] = r3 - r1; // Top
+    planes[4] = r2;      // Near
+    planes[5] = r3 - r2; // Far
+}
+
+// Classifies an AABB against the planes using its positive/negative vertices.
+uint classifyAABB(vec4 planes[6], vec3 bmin, vec3 bmax) {
+    uint result = FRUSTUM_INSIDE;
+    for (int i = 0; i < 6; ++i) {
+        bvec3 positive = greaterThanEqual(planes[i].xyz, vec3(0.0));
+        vec3 pVertex = mix(bmin, bmax, positive);
+        vec3 nVertex = mix(bmax, bmin, positive);
+
+        if (dot(planes[i].xyz, pVertex) + planes[i].w < 0.0) return FRUSTUM_OUTSIDE;
+        if (dot(planes[i].xyz, nVertex) + planes[i].w < 0.0) result = FRUSTUM_INTERSECT;
+    }
+    return result;
+}
+
+// Same clip-space test as the per-point culling in cull.comp.
+bool pointInFrustum(mat4 viewProj, vec3 position) {
+    vec4 clipPos = viewProj * vec4(position, 1.0);
+    return (abs(clipPos.x) <= clipPos.w) &&
+           (abs(clipPos.y) <= clipPos.w) &&
+           (clipPos.z >= 0.0 && clipPos.z <= clipPos.w);
+}
+
+#endif // POINTSPIRE_FRUSTUM_GLSL
@@ -0,0 +1,110 @@
+// Hierarchical depth buffer (Hi-Z) of the occlusion culling (--occlusion=on).
+//
+// All levels live in one uint buffer: level 0 at the viewport resolution, every
+// further level half the size (rounded up) of the previous one. A texel holds
+// the bits of the farthest depth it covers; depths in [0, 1] are non-negative
+// floats, whose bit patterns order like their values. The including shader
+// defines HIZ_PYRAMID_BINDING and HIZ_PARAMS_BINDING, and HIZ_PYRAMID_ACCESS
+// (empty) when it writes the pyramid.
+#ifndef POINTSPIRE_HIZ_GLSL
+#define POINTSPIRE_HIZ_GLSL
+
+#if !defined(HIZ_PYRAMID_BINDING) || !defined(HIZ_PARAMS_BINDING)
+#error "HIZ_PYRAMID_BINDING and HIZ_PARAMS_BINDING must be defined before including hiz.glsl"
+#endif
+
+#ifndef HIZ_PYRAMID_ACCESS
+#define HIZ_PYRAMID_ACCESS readonly
+#endif
+
+layout(std430, set = 0, binding = HIZ_PYRAMID_BINDING) HIZ_PYRAMID_ACCESS buffer HiZPyramid {
+    uint hizDepth[];
+};
+
+layout(set = 0, binding = HIZ_PARAMS_BINDING) uniform HiZParams {
+    uvec2 baseSize;
+    uint levelCount;
+    uint enabled;          // 0: no pyramid is bound, nothing is occluded
+    uvec4 levelOffsets[4]; // Offset of every level (up to 16) in hizDepth
+    uint quadSplats;       // 1: points are drawn as quads (--render=quads), 0: as single pixels
+} u_hiz;
+
+uint hizLevelOffset(uint level) {
+    return u_hiz.levelOffsets[level / 4u][level % 4u];
+}
+
+uvec2 hizLevelSize(uint level) {
+    return max((u_hiz.baseSize + (1u << level) - 1u) >> level, uvec2(1u));
+}
+
+// Reads the farthest depth bits of the Hi-Z texels the screen rectangle of the
+// box covers and the nearest depth of the box. The level is picked so that every
+// covered texel is read, at most 2x2 of them. False if the box reaches through
+// the near plane or no level is coarse enough, when nothing can be concluded.
+bool hizFootprint(mat4 viewProj, vec3 bmin, vec3 bmax, out float nearest, out uint farthest) {
+    nearest = 1.0;
+    farthest = 0u;
+
+    vec2 ndcMin = vec2(1.0e30);
+    vec2 ndcMax = vec2(-1.0e30);
+    for (uint i = 0u; i < 8u; ++i) {
+        vec3 corner = vec3((i & 1u) != 0u ? bmax.x : bmin.x,
+                           (i & 2u) != 0u ? bmax.y : bmin.y,
+                           (i & 4u) != 0u ? bmax.z : bmin.z);
+        vec4 clipPos = viewProj * vec4(corner, 1.0);
+
+        // Boxes reaching through the near plane are never occluded
+        if (clipPos.w <= 0.0 || clipPos.z < 0.0) return false;
+
+        vec3 ndc = clipPos.xyz / clipPos.w;
+        ndcMin = min(ndcMin, ndc.xy);
+        ndcMax = max(ndcMax, ndc.xy);
+        nearest = min(nearest, ndc.z);
+    }
+
+    uvec2 texMin = min(uvec2(clamp(ndcMin * 0.5 + 0.5, 0.0, 1.0) * vec2(u_hiz.baseSize)), u_hiz.baseSize - 1u);
+    uvec2 texMax = min(uvec2(clamp(ndcMax * 0.5 + 0.5, 0.0, 1.0) * vec2(u_hiz.baseSize)), u_hiz.baseSize - 1u);
+
+    // A span below 2^level base texels covers at most two texels of the level per axis.
+    // Without such a level in the pyramid, a partial footprint could hide visible parts.
+    uint span = max(texMax.x - texMin.x, texMax.y - texMin.y);
+    uint level = span == 0u ? 0u : uint(findMSB(span)) + 1u;
+    if (level >= u_hiz.levelCount) return false;
+
+    uvec2 t0 = texMin >> level;
+    uvec2 t1 = texMax >> level;
+    uvec2 size = hizLevelSize(level);
+    uint offset = hizLevelOffset(level);
+
+    for (uint y = t0.y; y <= t1.y; ++y) {
+        for (uint x = t0.x; x <= t1.x; ++x) {
+            farthest = max(farthest, hizDepth[offset + y * size.x + x]);
+        }
+    }
+    return true;
+}
+
+// True if the box lies entirely behind the farthest depth of the Hi-Z texels its
+// screen rectangle covers.
+bool hizOccluded(mat4 viewProj, vec3 bmin, vec3 bmax) {
+    if (u_hiz.enabled == 0u) return false;
+
+    float nearest;
+    uint farthest;
+    return hizFootprint(viewProj, bmin, bmax, nearest, farthest) && nearest > uintBitsToFloat(farthest);
+}
+
+// True if no pixel of the screen rectangle of the box is empty, for a pyramid
+// built from a point framebuffer, whose empty pixels hold HIZ_EMPTY (above every
+// depth, so the coarser levels keep it).
+#define HIZ_EMPTY 0xFFFFFFFFu
+
+bool hizCovered(mat4 viewProj, vec3 bmin, vec3 bmax) {
+    if (u_hiz.enabled == 0u) return false;
+
+    float nearest;
+    uint farthest;
+    return hizFootprint(viewProj, bmin, bmax, nearest, farthest) && farthest != HIZ_EMPTY;
+}
+
+#endif // POINTSPIRE_HIZ_GLSL
@@ -0,0 +1,117 @@
+// Shared Morton encoder and key helpers for the LPC build.
+//
+// Default: 30-bit keys (10 bits per axis) stored in a uint.
+// -DMORTON_64: 63-bit keys (21 bits per axis) stored as uvec2(low, high),
+// so no 64-bit integer support is required from the device.
+#ifndef POINTSPIRE_MORTON_GLSL
+#define POINTSPIRE_MORTON_GLSL
+
+#ifdef MORTON_64
+#define MortonKey uvec2
+#define MORTON_BITS_PER_AXIS 21
+#define MORTON_STORAGE_BITS 64
+#define MORTON_INVALID_KEY uvec2(0xFFFFFFFFu, 0xFFFFFFFFu)
+#else
+#define MortonKey uint
+#define MORTON_BITS_PER_AXIS 10
+#define MORTON_STORAGE_BITS 32
+#define MORTON_INVALID_KEY 0xFFFFFFFFu
+#endif
+
+#define MORTON_KEY_BITS (3 * MORTON_BITS_PER_AXIS)
+#define MORTON_AXIS_MAX float((1u << MORTON_BITS_PER_AXIS) - 1u)
+
+// Spreads the lower 10 bits of v so that there are two zero bits between each.
+uint expandBits(uint v) {
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+#ifdef MORTON_64
+// Spreads 21 bits to positions 0, 3, ..., 60. Bits 0-10 land in the low
+// word (bit 10 at position 30), bits 11-20 at positions 33-60.
+uvec2 expandBits21(uint v) {
+    uint lo = expandBits(v & 0x3FFu) | (((v >> 10) & 1u) << 30);
+    uint hi = expandBits((v >> 11) & 0x3FFu) << 1;
+    return uvec2(lo, hi);
+}
+
+uvec2 shiftLeft64(uvec2 v, uint n) {
+    return (n == 0) ? v : uvec2(v.x << n, (v.y << n) | (v.x >> (32 - n)));
+}
+#endif
+
+// Quantizes pos inside [min_b, min_b + 1 / scale] and interleaves x, y, z (x most significant).
+// Only correctly rounded operations, so CpuLPCBuilder::mortonKey matches it exactly.
+MortonKey morton3D(vec3 pos, vec3 min_b, vec3 scale) {
+    vec3 norm = clamp((pos - min_b) * scale, 0.0, 1.0);
+    uvec3 q = uvec3(norm * MORTON_AXIS_MAX);
+#ifdef MORTON_64
+    uvec2 xx = expandBits21(q.x);
+    uvec2 yy = expandBits21(q.y);
+    uvec2 zz = expandBits21(q.z);
+    return shiftLeft64(xx, 2) | shiftLeft64(yy, 1) | zz;
+#else
+    return (expandBits(q.x) << 2) | (expandBits(q.y) << 1) | expandBits(q.z);
+#endif
+}
+
+bool mortonEqual(MortonKey a, MortonKey b) {
+#ifdef MORTON_64
+    return all(equal(a, b));
+#else
+    return a == b;
+#endif
+}
+
+bool mortonLess(MortonKey a, MortonKey b) {
+#ifdef MORTON_64
+    return (a.y != b.y) ? (a.y < b.y) : (a.x < b.x);
+#else
+    return a < b;
+#endif
+}
+
+// Extracts the radix digit starting at bit `shift` (digits never straddle the two words).
+uint mortonDigit(MortonKey key, uint shift, uint mask) {
+#ifdef MORTON_64
+    return (shift >= 32) ? ((key.y >> (shift - 32)) & mask) : ((key.x >> shift) & mask);
+#else
+    return (key >> shift) & mask;
+#endif
+}
+
+// Number of leading bits two keys share, counted over the full storage width.
+// Returns MORTON_STORAGE_BITS for identical keys.
+int mortonCommonPrefix(MortonKey a, MortonKey b) {
+#ifdef MORTON_64
+    uvec2 diff = a ^ b;
+    if (diff.y != 0) return 31 - findMSB(diff.y);
+    if (diff.x != 0) return 32 + (31 - findMSB(diff.x));
+    return 64;
+#else
+    uint diff = a ^ b;
+    return (diff != 0) ? 31 - findMSB(diff) : 32;
+#endif
+}
+
+uint mortonLow(MortonKey key) {
+#ifdef MORTON_64
+    return key.x;
+#else
+    return key;
+#endif
+}
+
+uint mortonHigh(MortonKey key) {
+#ifdef MORTON_64
+    return key.y;
+#else
+    return 0;
+#endif
+}
+
+#endif // POINTSPIRE_MORTON_GLSL
@@ -0,0 +1,143 @@
+// Shared GPU point layout.
+//
+// Default: the full-precision Point (32 bytes, matches the C++ Point).
+// -DPOINT_COMPACT: 16-byte CompactPoint with 21-bit positions quantized to the
+// cloud bounds, RGBA8 color, unorm16 intensity and a half-float splat size.
+// -DPOINT_SOA: full precision split into three streams: positions (xyz +
+// splat size), unorm16 RGBA colors and float intensities.
+//
+// Buffers of points are declared with POINT_BUFFER (all attributes) or
+// POINT_POSITION_BUFFER (positions and splat sizes) and accessed through
+// loadPosition, loadSplatSize, loadPoint, storePoint and copyPoint, so a
+// shader compiles against every layout. The color and intensity bindings of
+// POINT_BUFFER are only used by the SoA layout. The including shader defines
+// POINT_QUANTIZATION_BINDING, the binding of the PointQuantization uniform
+// (only read by the compact layout, but always bound).
+#ifndef POINTSPIRE_POINT_GLSL
+#define POINTSPIRE_POINT_GLSL
+
+#ifndef POINT_QUANTIZATION_BINDING
+#error "POINT_QUANTIZATION_BINDING must be defined before including point.glsl"
+#endif
+
+// Smallest view-space half size a point is drawn with (bunny_primitive.vert)
+#define POINT_MIN_SPLAT_SIZE 0.025
+
+struct Point {
+    vec3 position;
+    float splatSize;
+    vec3 color;
+    float intensity;
+};
+
+layout(set = 0, binding = POINT_QUANTIZATION_BINDING) uniform PointQuantization {
+    vec3 origin;   // Minimum of the cloud bounds
+    vec3 step;     // Size of one quantization step per axis
+    vec3 invStep;  // 1 / step, 0 for flat axes
+} u_pointQuant;
+
+#if defined(POINT_SOA)
+
+uvec2 packColor(vec3 color) {
+    return uvec2(packUnorm2x16(color.rg), packUnorm2x16(vec2(color.b, 1.0)));
+}
+
+Point unpackStreams(vec4 position, uvec2 color, float intensity) {
+    return Point(position.xyz, position.w, vec3(unpackUnorm2x16(color.x), unpackUnorm2x16(color.y).x), intensity);
+}
+
+#define POINT_BUFFER(access, name, positionBinding, colorBinding, intensityBinding) \
+    layout(std430, set = 0, binding = positionBinding) access buffer name##Positions { vec4 name##_positions[]; }; \
+    layout(std430, set = 0, binding = colorBinding) access buffer name##Colors { uvec2 name##_colors[]; }; \
+    layout(std430, set = 0, binding = intensityBinding) access buffer name##Intensities { float name##_intensities[]; }
+
+#define POINT_POSITION_BUFFER(access, name, positionBinding) \
+    layout(std430, set = 0, binding = positionBinding) access buffer name##Positions { vec4 name##_positions[]; }
+
+#define loadPosition(name, i) (name##_positions[i].xyz)
+#define loadSplatSize(name, i) (name##_positions[i].w)
+#define loadPoint(name, i) unpackStreams(name##_positions[i], name##_colors[i], name##_intensities[i])
+#define storePoint(name, i, p) { \
+        uint storeIndex_ = (i); Point storePoint_ = (p); \
+        name##_positions[storeIndex_] = vec4(storePoint_.position, storePoint_.splatSize); \
+        name##_colors[storeIndex_] = packColor(storePoint_.color); \
+        name##_intensities[storeIndex_] = storePoint_.intensity; }
+#define copyPoint(dst, dstIndex, src, srcIndex) { \
+        uint copyDst_ = (dstIndex); uint copySrc_ = (srcIndex); \
+        dst##_positions[copyDst_] = src##_positions[copySrc_]; \
+        dst##_colors[copyDst_] = src##_colors[copySrc_]; \
+        dst##_intensities[copyDst_] = src##_intensities[copySrc_]; }
+
+#else
+
+#ifdef POINT_COMPACT
+
+#define POINT_QUANTIZATION_MAX 0x1FFFFFu
+
+struct PointData {
+    uvec2 position;      // x: bits 0-20, y: bits 21-41, z: bits 42-62
+    uint color;          // RGBA8
+    uint intensitySplat; // unorm16 intensity | half-float splat size << 16
+};
+
+uvec3 unpackQuantized(uvec2 packed) {
+    return uvec3(packed.x & POINT_QUANTIZATION_MAX,
+                 (packed.x >> 21) | ((packed.y & 0x3FFu) << 11),
+                 (packed.y >> 10) & POINT_QUANTIZATION_MAX);
+}
+
+vec3 decodePosition(PointData d) {
+    return u_pointQuant.origin + vec3(unpackQuantized(d.position)) * u_pointQuant.step;
+}
+
+float decodeSplatSize(PointData d) {
+    return unpackHalf2x16(d.intensitySplat >> 16).x;
+}
+
+Point unpackPoint(PointData d) {
+    Point p;
+    p.position = decodePosition(d);
+    p.splatSize = decodeSplatSize(d);
+    p.color = unpackUnorm4x8(d.color).rgb;
+    p.intensity = unpackUnorm2x16(d.intensitySplat & 0xFFFFu).x;
+    return p;
+}
+
+PointData packPoint(Point p) {
+    vec3 scaled = round((p.position - u_pointQuant.origin) * u_pointQuant.invStep);
+    uvec3 q = uvec3(clamp(scaled, vec3(0.0), vec3(float(POINT_QUANTIZATION_MAX))));
+
+    PointData d;
+    d.position = uvec2(q.x | (q.y << 21), (q.y >> 11) | (q.z << 10));
+    d.color = packUnorm4x8(vec4(p.color, 1.0));
+    d.intensitySplat = (packUnorm2x16(vec2(p.intensity, 0.0)) & 0xFFFFu) | (packHalf2x16(vec2(p.splatSize, 0.0)) << 16);
+    return d;
+}
+
+#else
+
+#define PointData Point
+
+vec3 decodePosition(PointData d) { return d.position; }
+float decodeSplatSize(PointData d) { return d.splatSize; }
+Point unpackPoint(PointData d) { return d; }
+PointData packPoint(Point p) { return p; }
+
+#endif
+
+// Interleaved layouts keep all attributes in one buffer
+#define POINT_BUFFER(access, name, positionBinding, colorBinding, intensityBinding) \
+    layout(std430, set = 0, binding = positionBinding) access buffer name##Points { PointData name[]; }
+
+#define POINT_POSITION_BUFFER(access, name, positionBinding) \
+    POINT_BUFFER(access, name, positionBinding, 0, 0)
+
+#define loadPosition(name, i) decodePosition(name[i])
+#define loadSplatSize(name, i) decodeSplatSize(name[i])
+#define loadPoint(name, i) unpackPoint(name[i])
+#define storePoint(name, i, p) name[i] = packPoint(p)
+#define copyPoint(dst, dstIndex, src, srcIndex) dst[dstIndex] = src[srcIndex]
+
+#endif
+
+#endif // POINTSPIRE_POINT_GLSL
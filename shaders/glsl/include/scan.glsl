@@ -0,0 +1,34 @@
+// Workgroup-wide prefix sum of the LPC build (radix sort and head flag scan).
+//
+// The including shader defines SCAN_WORKGROUP_SIZE, its local_size_x, which
+// must be a power of two.
+#ifndef POINTSPIRE_SCAN_GLSL
+#define POINTSPIRE_SCAN_GLSL
+
+#ifndef SCAN_WORKGROUP_SIZE
+#error "SCAN_WORKGROUP_SIZE must be defined before including scan.glsl"
+#endif
+
+shared uint s_scan[SCAN_WORKGROUP_SIZE];
+
+// Hillis-Steele inclusive scan over the workgroup, called by every invocation.
+uint workgroupInclusiveScan(uint value) {
+    uint lid = gl_LocalInvocationID.x;
+    barrier();
+    s_scan[lid] = value;
+    barrier();
+    for (uint offset = 1; offset < SCAN_WORKGROUP_SIZE; offset <<= 1) {
+        uint other = (lid >= offset) ? s_scan[lid - offset] : 0;
+        barrier();
+        s_scan[lid] += other;
+        barrier();
+    }
+    return s_scan[lid];
+}
+
+// Sum of the values of the last workgroupInclusiveScan(), valid until the next one.
+uint workgroupScanTotal() {
+    return s_scan[SCAN_WORKGROUP_SIZE - 1];
+}
+
+#endif // POINTSPIRE_SCAN_GLSL
@@ -0,0 +1,40 @@
+// Output of the frustum culling, read by the point draw pass.
+//
+// Default: visible points are copied into a point buffer in the layout of
+// include/point.glsl, and the vertex shader reads it by instance index.
+// -DCULL_INDICES: only the 32-bit index of every visible point is written.
+// The vertex shader fetches the point from the source buffer through it, or
+// from the LOD proxies when VISIBLE_PROXY_BIT is set.
+//
+// The culling shaders declare their output with VISIBLE_BUFFER and fill it
+// with emitPoint and emitProxy. The color and intensity bindings are only used
+// by the SoA point layout with the default output. Include after point.glsl.
+#ifndef POINTSPIRE_VISIBLE_GLSL
+#define POINTSPIRE_VISIBLE_GLSL
+
+#ifndef POINTSPIRE_POINT_GLSL
+#error "include/point.glsl must be included before visible.glsl"
+#endif
+
+// Marks indices into the LOD proxies rather than the source points (matches VISIBLE_PROXY_BIT in PointCloud.hpp)
+#define VISIBLE_PROXY_BIT 0x80000000u
+
+#ifdef CULL_INDICES
+
+#define VISIBLE_BUFFER(access, name, primaryBinding, colorBinding, intensityBinding) \
+    layout(std430, set = 0, binding = primaryBinding) access buffer name##Indices { uint name[]; }
+
+#define emitPoint(dst, dstIndex, src, srcIndex) dst[dstIndex] = (srcIndex)
+#define emitProxy(dst, dstIndex, proxies, node) dst[dstIndex] = (node) | VISIBLE_PROXY_BIT
+
+#else
+
+#define VISIBLE_BUFFER(access, name, primaryBinding, colorBinding, intensityBinding) \
+    POINT_BUFFER(access, name, primaryBinding, colorBinding, intensityBinding)
+
+#define emitPoint(dst, dstIndex, src, srcIndex) copyPoint(dst, dstIndex, src, srcIndex)
+#define emitProxy(dst, dstIndex, proxies, node) copyPoint(dst, dstIndex, proxies, node)
+
+#endif
+
+#endif // POINTSPIRE_VISIBLE_GLSL
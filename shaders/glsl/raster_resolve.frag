@@ -0,0 +1,25 @@
+#version 450
+
+// Writes the color of every covered pixel of the point framebuffer over the
+// skybox; pixels no point reached keep what is already there.
+
+layout(std430, set = 0, binding = 0) readonly buffer Framebuffer {
+    uvec2 pixels[]; // x: RGBA8 color, y: depth bits
+};
+
+layout(set = 0, binding = 1) uniform RasterParams {
+    uint width;
+    uint height;
+} params;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // The target may be larger than the framebuffer, e.g. after a swapchain resize
+    uvec2 pixel = uvec2(gl_FragCoord.xy);
+    if (pixel.x >= params.width || pixel.y >= params.height) discard;
+    uvec2 value = pixels[pixel.y * params.width + pixel.x];
+    if (value.y == 0xFFFFFFFFu) discard;
+
+    outColor = unpackUnorm4x8(value.x);
+}
@@ -1,73 +1,405 @@
 #include "BunnyLoader.hpp"
-#include "happly.h"
-#include "fstream"
-#include "sstream"
-#include "iostream"
-#include "filesystem"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
-std::vector<PositionVertex> loadBunny(const std::string& confFilePath, const std::string& plyDirectory) {
-    std::vector<PositionVertex> vertices;
-    std::ifstream confFile(confFilePath);
+namespace {
 
-    if (!confFile.is_open()) {
-        std::cerr << "Error: Could not open configuration file: " << confFilePath << std::endl;
-        return {};
+/// Read-only mapping of a whole file.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open " + path);
+
+        struct stat info{};
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat " + path);
+        }
+        m_size = static_cast<size_t>(info.st_size);
+        if (m_size > 0) {
+            void* mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Cannot map " + path);
+            }
+            m_data = static_cast<const char*>(mapping);
+            // The body is parsed front to back exactly once
+            madvise(mapping, m_size, MADV_SEQUENTIAL);
+        }
+        ::close(fd); // The mapping keeps the file alive
     }
 
-    std::string line;
-    while (std::getline(confFile, line)) {
-        std::stringstream ss(line);
-        std::string command;
-        ss >> command;
+    ~MappedFile() {
+        if (m_data) munmap(const_cast<char*>(m_data), m_size);
+    }
 
-        if (command == "bmesh") {
-            std::string filename;
-            float tx, ty, tz;
-            float qx, qy, qz, qw;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
 
-            ss >> filename >> tx >> ty >> tz >> qx >> qy >> qz >> qw;
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+};
 
-            fs::path fullPlyPath(plyDirectory + "/" + filename);
+enum class PlyFormat { ascii, binaryLittleEndian, binaryBigEndian };
 
-            if (!fs::exists(fullPlyPath)) {
-                std::cerr << "Error: PLY file not found: " << fullPlyPath << std::endl;
+enum class PlyScalar { int8, uint8, int16, uint16, int32, uint32, float32, float64 };
+
+size_t scalarSize(PlyScalar type) {
+    switch (type) {
+        case PlyScalar::int8: case PlyScalar::uint8: return 1;
+        case PlyScalar::int16: case PlyScalar::uint16: return 2;
+        case PlyScalar::int32: case PlyScalar::uint32: case PlyScalar::float32: return 4;
+        case PlyScalar::float64: return 8;
+    }
+    return 0;
+}
+
+PlyScalar parseScalar(std::string_view name) {
+    if (name == "char" || name == "int8") return PlyScalar::int8;
+    if (name == "uchar" || name == "uint8") return PlyScalar::uint8;
+    if (name == "short" || name == "int16") return PlyScalar::int16;
+    if (name == "ushort" || name == "uint16") return PlyScalar::uint16;
+    if (name == "int" || name == "int32") return PlyScalar::int32;
+    if (name == "uint" || name == "uint32") return PlyScalar::uint32;
+    if (name == "float" || name == "float32") return PlyScalar::float32;
+    if (name == "double" || name == "float64") return PlyScalar::float64;
+    throw std::runtime_error("Unknown PLY property type: " + std::string(name));
+}
+
+/// Where the vertex positions are in a PLY body.
+struct PlyLayout {
+    PlyFormat format = PlyFormat::ascii;
+    size_t bodyOffset = 0;       ///< First byte after end_header.
+    size_t vertexCount = 0;
+    size_t skippedRecords = 0;   ///< ASCII: lines of the elements before the vertices.
+    size_t skippedBytes = 0;     ///< Binary: bytes of the elements before the vertices.
+    size_t stride = 0;           ///< Binary: bytes per vertex.
+    size_t offsets[3] = {};      ///< Binary: byte offset of x, y, z in a vertex. ASCII: their token index.
+    PlyScalar types[3] = {PlyScalar::float32, PlyScalar::float32, PlyScalar::float32};
+};
+
+/**
+ * @brief Parses the header of a mapped PLY file.
+ *
+ * The x, y and z properties must be scalars with no list property before
+ * them, and in binary files only fixed-size elements may precede the vertices.
+ */
+PlyLayout parsePlyHeader(const char* data, size_t size) {
+    constexpr std::string_view endHeader = "end_header";
+    std::string_view file(data, size);
+    size_t end = file.find(endHeader);
+    if (file.substr(0, 3) != "ply" || end == std::string_view::npos) throw std::runtime_error("Not a PLY file");
+    size_t bodyOffset = file.find('\n', end);
+    if (bodyOffset == std::string_view::npos) throw std::runtime_error("Truncated PLY header");
+
+    PlyLayout layout;
+    layout.bodyOffset = bodyOffset + 1;
+
+    bool inVertex = false;
+    bool vertexSeen = false;
+    bool vertexHasList = false;
+    bool precedingHasList = false;
+    size_t precedingStride = 0;
+    size_t elementCount = 0;
+    size_t propertyIndex = 0;
+    bool found[3] = {};
+
+    std::istringstream header(std::string(file.substr(0, end)));
+    std::string line;
+    while (std::getline(header, line)) {
+        std::istringstream ss(line);
+        std::string keyword;
+        ss >> keyword;
+        if (keyword == "format") {
+            std::string format;
+            ss >> format;
+            if (format == "ascii") layout.format = PlyFormat::ascii;
+            else if (format == "binary_little_endian") layout.format = PlyFormat::binaryLittleEndian;
+            else if (format == "binary_big_endian") layout.format = PlyFormat::binaryBigEndian;
+            else throw std::runtime_error("Unknown PLY format: " + format);
+        } else if (keyword == "element") {
+            // Close the previous element before the vertices
+            if (!vertexSeen && !inVertex && elementCount > 0) {
+                layout.skippedRecords += elementCount;
+                layout.skippedBytes += elementCount * precedingStride;
+            }
+            std::string name;
+            ss >> name >> elementCount;
+            inVertex = name == "vertex";
+            if (inVertex) {
+                vertexSeen = true;
+                layout.vertexCount = elementCount;
+            } else if (!vertexSeen) {
+                precedingStride = 0;
+            }
+            propertyIndex = 0;
+        } else if (keyword == "property") {
+            std::string type;
+            ss >> type;
+            if (type == "list") {
+                if (inVertex) vertexHasList = true;
+                else if (!vertexSeen) precedingHasList = true;
+                ++propertyIndex;
                 continue;
             }
+            std::string name;
+            ss >> name;
+            PlyScalar scalar = parseScalar(type);
+            if (inVertex) {
+                int axis = name == "x" ? 0 : name == "y" ? 1 : name == "z" ? 2 : -1;
+                if (axis >= 0) {
+                    if (vertexHasList) throw std::runtime_error("PLY vertex lists before the position are not supported");
+                    found[axis] = true;
+                    layout.types[axis] = scalar;
+                    layout.offsets[axis] = layout.format == PlyFormat::ascii ? propertyIndex : layout.stride;
+                }
+                layout.stride += scalarSize(scalar);
+            } else if (!vertexSeen) {
+                precedingStride += scalarSize(scalar);
+            }
+            ++propertyIndex;
+        }
+    }
 
-            try {
-                happly::PLYData plyIn(fullPlyPath.string());
+    if (!vertexSeen || !found[0] || !found[1] || !found[2]) throw std::runtime_error("PLY file has no vertex positions");
+    if (layout.format != PlyFormat::ascii) {
+        if (precedingHasList) throw std::runtime_error("Binary PLY lists before the vertices are not supported");
+        if (vertexHasList) throw std::runtime_error("Binary PLY vertex lists are not supported");
+        size_t bodyEnd = layout.bodyOffset + layout.skippedBytes + layout.vertexCount * layout.stride;
+        if (bodyEnd > size) throw std::runtime_error("Truncated PLY body");
+    }
+    return layout;
+}
 
-                std::vector<std::array<double, 3>> rawPositions = plyIn.getVertexPositions();
+template <typename T>
+T loadScalar(const char* src, bool swap) {
+    T value;
+    if (swap) {
+        char bytes[sizeof(T)];
+        std::reverse_copy(src, src + sizeof(T), bytes);
+        std::memcpy(&value, bytes, sizeof(T));
+    } else {
+        std::memcpy(&value, src, sizeof(T));
+    }
+    return value;
+}
 
-                glm::vec3 translation(tx, ty, tz);
+float readScalar(const char* src, PlyScalar type, bool swap) {
+    switch (type) {
+        case PlyScalar::int8: return static_cast<float>(loadScalar<int8_t>(src, swap));
+        case PlyScalar::uint8: return static_cast<float>(loadScalar<uint8_t>(src, swap));
+        case PlyScalar::int16: return static_cast<float>(loadScalar<int16_t>(src, swap));
+        case PlyScalar::uint16: return static_cast<float>(loadScalar<uint16_t>(src, swap));
+        case PlyScalar::int32: return static_cast<float>(loadScalar<int32_t>(src, swap));
+        case PlyScalar::uint32: return static_cast<float>(loadScalar<uint32_t>(src, swap));
+        case PlyScalar::float32: return loadScalar<float>(src, swap);
+        case PlyScalar::float64: return static_cast<float>(loadScalar<double>(src, swap));
+    }
+    return 0.0f;
+}
 
-                glm::quat rotation(qw, qx, qy, qz);
+/**
+ * @brief Rotates and translates one batch of raw positions into the output.
+ *
+ * The positions come in as separate x, y and z arrays so the loop maps onto
+ * vector registers; the rotation is expanded into a matrix once per batch.
+ */
+void transformBatch(const float* xs, const float* ys, const float* zs, size_t count,
+                    const glm::mat3& rotation, const glm::vec3& translation, glm::vec3* out) {
+    for (size_t k = 0; k < count; ++k) {
+        out[k] = glm::vec3(rotation[0][0] * xs[k] + rotation[1][0] * ys[k] + rotation[2][0] * zs[k] + translation.x,
+                           rotation[0][1] * xs[k] + rotation[1][1] * ys[k] + rotation[2][1] * zs[k] + translation.y,
+                           rotation[0][2] * xs[k] + rotation[1][2] * ys[k] + rotation[2][2] * zs[k] + translation.z);
+    }
+}
 
-                size_t currentSize = vertices.size();
+const char* skipLine(const char* p, const char* end) {
+    p = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+    return p ? p + 1 : end;
+}
 
-                vertices.reserve(currentSize + rawPositions.size());
+const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    return p;
+}
 
-                for (const auto& pos : rawPositions) {
-                    glm::vec3 localPos(
-                        static_cast<float>(pos[0]),
-                        static_cast<float>(pos[1]),
-                        static_cast<float>(pos[2])
-                    );
+/// Parses the ASCII vertex lines of a PLY body, transforming them batch by batch into out.
+void parseAsciiVertices(const char* p, const char* end, const PlyLayout& layout, const BunnyScan& scan, glm::vec3* out) {
+    for (size_t r = 0; r < layout.skippedRecords; ++r) p = skipLine(p, end);
 
-                    glm::vec3 worldPos = rotation * localPos + translation;
+    const glm::mat3 rotation = glm::mat3_cast(scan.rotation);
+    const size_t lastToken = std::max({layout.offsets[0], layout.offsets[1], layout.offsets[2]});
+    float batch[3][PLY_TRANSFORM_BATCH];
 
-                    vertices.push_back({worldPos});
+    for (size_t first = 0; first < layout.vertexCount; first += PLY_TRANSFORM_BATCH) {
+        size_t count = std::min(PLY_TRANSFORM_BATCH, layout.vertexCount - first);
+        for (size_t k = 0; k < count; ++k) {
+            for (size_t token = 0; token <= lastToken; ++token) {
+                p = skipBlanks(p, end);
+                int axis = token == layout.offsets[0] ? 0 : token == layout.offsets[1] ? 1 : token == layout.offsets[2] ? 2 : -1;
+                if (axis >= 0) {
+                    auto [next, error] = std::from_chars(p, end, batch[axis][k]);
+                    if (error != std::errc()) throw std::runtime_error("Malformed ASCII PLY vertex " + std::to_string(first + k));
+                    p = next;
+                } else {
+                    while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') ++p;
                 }
+            }
+            p = skipLine(p, end);
+        }
+        transformBatch(batch[0], batch[1], batch[2], count, rotation, scan.translation, out + first);
+    }
+}
+
+/// Reads the binary vertices of a PLY body in place from the mapping, transforming them batch by batch into out.
+void parseBinaryVertices(const char* body, const PlyLayout& layout, const BunnyScan& scan, glm::vec3* out) {
+    const char* vertices = body + layout.skippedBytes;
+    const bool swap = (layout.format == PlyFormat::binaryBigEndian) != (std::endian::native == std::endian::big);
+    const bool packedFloats = !swap && layout.types[0] == PlyScalar::float32 && layout.types[1] == PlyScalar::float32 &&
+                              layout.types[2] == PlyScalar::float32;
+
+    const glm::mat3 rotation = glm::mat3_cast(scan.rotation);
+    float batch[3][PLY_TRANSFORM_BATCH];
+
+    for (size_t first = 0; first < layout.vertexCount; first += PLY_TRANSFORM_BATCH) {
+        size_t count = std::min(PLY_TRANSFORM_BATCH, layout.vertexCount - first);
+        const char* record = vertices + first * layout.stride;
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const char* src = record + layout.offsets[axis];
+            if (packedFloats) {
+                // The common case: native float properties, no conversion
+                for (size_t k = 0; k < count; ++k) std::memcpy(&batch[axis][k], src + k * layout.stride, sizeof(float));
+            } else {
+                for (size_t k = 0; k < count; ++k) batch[axis][k] = readScalar(src + k * layout.stride, layout.types[axis], swap);
+            }
+        }
+        transformBatch(batch[0], batch[1], batch[2], count, rotation, scan.translation, out + first);
+    }
+}
+
+} // namespace
+
+bool isBunnyConf(const std::string& path) {
+    return fs::path(path).extension() == ".conf";
+}
+
+std::vector<BunnyScan> parseBunnyConf(const std::string& confFilePath) {
+    std::ifstream confFile(confFilePath);
+    if (!confFile.is_open()) {
+        throw std::runtime_error("Could not open configuration file: " + confFilePath);
+    }
+
+    std::vector<BunnyScan> scans;
+    std::string line;
+    while (std::getline(confFile, line)) {
+        std::stringstream ss(line);
+        std::string command;
+        ss >> command;
+
+        if (command == "bmesh") {
+            BunnyScan scan;
+            float tx, ty, tz;
+            float qx, qy, qz, qw;
+            ss >> scan.filename >> tx >> ty >> tz >> qx >> qy >> qz >> qw;
+            scan.translation = glm::vec3(tx, ty, tz);
+            scan.rotation = glm::quat(qw, qx, qy, qz);
+            scans.push_back(scan);
+        }
+    }
+    return scans;
+}
+
+std::vector<glm::vec3> loadBunny(const std::string& confFilePath, const std::string& plyDirectory) {
+    const auto loadStart = std::chrono::steady_clock::now();
+    const std::vector<BunnyScan> scans = parseBunnyConf(confFilePath);
+    const size_t scanCount = scans.size();
 
-                std::cout << "Loaded " << filename << ": " << rawPositions.size() << " vertices.\n";
-            } catch (std::exception& e) {
-                std::cerr << "Error parsing " << filename << ": " << e.what() << std::endl;
+    // One task per scan; the caller takes part, so a single scan runs inline
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    ThreadPool pool(static_cast<unsigned>(std::clamp<size_t>(scanCount, 1, hardware)));
+
+    // Pass 1: Map every file and read its header, which sizes the output
+    std::vector<std::unique_ptr<MappedFile>> files(scanCount);
+    std::vector<PlyLayout> layouts(scanCount);
+    std::vector<std::string> errors(scanCount);
+    pool.parallelFor(scanCount, 1, [&](unsigned, size_t begin, size_t end) {
+        for (size_t s = begin; s < end; ++s) {
+            try {
+                files[s] = std::make_unique<MappedFile>((fs::path(plyDirectory) / scans[s].filename).string());
+                layouts[s] = parsePlyHeader(files[s]->data(), files[s]->size());
+            } catch (const std::exception& e) {
+                files[s].reset();
+                errors[s] = e.what();
             }
         }
+    });
+
+    std::vector<size_t> offsets(scanCount + 1, 0);
+    size_t mappedBytes = 0;
+    for (size_t s = 0; s < scanCount; ++s) {
+        offsets[s + 1] = offsets[s] + (files[s] ? layouts[s].vertexCount : 0);
+        if (files[s]) mappedBytes += files[s]->size();
+    }
+
+    // Pass 2: Parse every body straight into its range of the presized output
+    std::vector<glm::vec3> positions(offsets[scanCount]);
+    pool.parallelFor(scanCount, 1, [&](unsigned, size_t begin, size_t end) {
+        for (size_t s = begin; s < end; ++s) {
+            if (!files[s]) continue;
+            try {
+                const char* body = files[s]->data() + layouts[s].bodyOffset;
+                if (layouts[s].format == PlyFormat::ascii) {
+                    parseAsciiVertices(body, files[s]->data() + files[s]->size(), layouts[s], scans[s], positions.data() + offsets[s]);
+                } else {
+                    parseBinaryVertices(body, layouts[s], scans[s], positions.data() + offsets[s]);
+                }
+            } catch (const std::exception& e) {
+                errors[s] = e.what();
+            }
+            files[s].reset();
+        }
+    });
+
+    // Drop the ranges of the scans that failed half way
+    size_t written = 0;
+    for (size_t s = 0; s < scanCount; ++s) {
+        if (!errors[s].empty()) {
+            std::cerr << "Error loading " << scans[s].filename << ": " << errors[s] << std::endl;
+            continue;
+        }
+        std::copy(positions.begin() + offsets[s], positions.begin() + offsets[s + 1], positions.begin() + written);
+        written += offsets[s + 1] - offsets[s];
     }
+    positions.resize(written);
 
-    std::cout << "Total Bunny vertices: " << vertices.size() << std::endl;
-    return vertices;
-}
\ No newline at end of file
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - loadStart).count();
+    std::cout << "Loaded " << positions.size() << " vertices from " << scanCount << " scans in " << seconds << " s ("
+              << static_cast<double>(mappedBytes) / std::max(seconds, 1e-6f) / 1e6 << " MB/s, "
+              << pool.size() << " threads)" << std::endl;
+    return positions;
+}
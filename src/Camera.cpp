@@ -1,20 +1,23 @@
 #include "Camera.hpp"
 #include "tga/tga_math.hpp"
+#include <cstring>
 
-Camera::Camera(tga::Interface& _tgai) : tgai(_tgai) {
+Camera::Camera(tga::Interface& _tgai, uint32_t frameCount) : tgai(_tgai) {
     tga::BufferInfo uboInfo{tga::BufferUsage::uniform, sizeof(CameraData)};
-    uniformBuffer = tgai.createBuffer(uboInfo);
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        uniformBuffers.push_back(tgai.createBuffer(uboInfo));
+    }
 }
 
 Camera::~Camera() {
-    if (uniformBuffer) {
+    for (tga::Buffer uniformBuffer : uniformBuffers) {
         tgai.free(uniformBuffer);
     }
 }
 
-tga::Buffer Camera::getUbo() const { return uniformBuffer; }
+tga::Buffer Camera::getUbo(uint32_t frame) const { return uniformBuffers[frame]; }
 
-void Camera::update(tga::CommandRecorder& recorder, tga::Window& window, float dt) {
+void Camera::update(tga::CommandRecorder& recorder, tga::Window& window, float dt, uint32_t frame) {
     // 1. Rotation (Arrows)
     float rotStep = rotateSpeed * dt;
     if (tgai.keyDown(window, tga::Key::Left)) yaw -= rotStep;
@@ -50,13 +53,30 @@ void Camera::update(tga::CommandRecorder& recorder, tga::Window& window, float d
 
     // 4. Update UBO
     auto [width, height] = tgai.screenResolution();
-    float aspect = static_cast<float>(width) / static_cast<float>(height);
+    upload(recorder, static_cast<float>(width) / static_cast<float>(height), frame);
+}
+
+void Camera::lookAt(tga::CommandRecorder& recorder, const glm::vec3& position, const glm::vec3& target, float aspect,
+                    uint32_t frame) {
+    pos = position;
+    front = glm::normalize(target - position);
+    right = glm::normalize(glm::cross(front, worldUp));
+    up = glm::normalize(glm::cross(right, front));
+    pitch = glm::degrees(asin(front.y));
+    yaw = glm::degrees(atan2(front.z, front.x));
+
+    upload(recorder, aspect, frame);
+}
 
-    cameraData.model = glm::mat4(1.0f);
-    cameraData.view = glm::lookAt(pos, pos + front, worldUp);
-    cameraData.proj = glm::perspective_vk(glm::radians(fov), aspect, 0.1f, 1000.0f);
+void Camera::upload(tga::CommandRecorder& recorder, float aspect, uint32_t frame) {
+    CameraData data;
+    data.model = glm::mat4(1.0f);
+    data.view = glm::lookAt(pos, pos + front, worldUp);
+    data.proj = glm::perspective_vk(glm::radians(fov), aspect, 0.1f, 1000.0f);
+    if (revision == 0 || std::memcmp(&data, &cameraData, sizeof(CameraData)) != 0) ++revision;
+    cameraData = data;
 
     // std::cout << "Cam pos is: " << pos.x << " " << pos.y << " " << pos.z << std::endl;
     
-    recorder.inlineBufferUpdate(uniformBuffer, &cameraData, sizeof(CameraData));
+    recorder.inlineBufferUpdate(uniformBuffers[frame], &cameraData, sizeof(CameraData));
 }
\ No newline at end of file
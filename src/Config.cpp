@@ -0,0 +1,240 @@
+#include "Config.hpp"
+#include "PointCache.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+SortAlgorithm parseSortAlgorithm(std::string_view value) {
+    if (value == "radix") return SortAlgorithm::radix;
+    if (value == "bitonic") return SortAlgorithm::bitonic;
+    throw std::invalid_argument("Invalid value for --sort: " + std::string(value) + " (expected radix|bitonic)");
+}
+
+uint32_t parseMortonBits(std::string_view value) {
+    if (value == "30") return 30;
+    if (value == "63") return 63;
+    throw std::invalid_argument("Invalid value for --morton-bits: " + std::string(value) + " (expected 30|63)");
+}
+
+CullingMode parseCullingMode(std::string_view value) {
+    if (value == "tree") return CullingMode::tree;
+    if (value == "points") return CullingMode::points;
+    throw std::invalid_argument("Invalid value for --cull: " + std::string(value) + " (expected tree|points)");
+}
+
+CullOutput parseCullOutput(std::string_view value) {
+    if (value == "points") return CullOutput::points;
+    if (value == "indices") return CullOutput::indices;
+    throw std::invalid_argument("Invalid value for --cull-output: " + std::string(value) + " (expected points|indices)");
+}
+
+RenderMode parseRenderMode(std::string_view value) {
+    if (value == "quads") return RenderMode::quads;
+    if (value == "compute") return RenderMode::compute;
+    throw std::invalid_argument("Invalid value for --render: " + std::string(value) + " (expected quads|compute)");
+}
+
+PointFormat parsePointFormat(std::string_view value) {
+    if (value == "full") return PointFormat::full;
+    if (value == "compact") return PointFormat::compact;
+    if (value == "soa") return PointFormat::soa;
+    throw std::invalid_argument("Invalid value for --point-format: " + std::string(value) + " (expected full|compact|soa)");
+}
+
+uint32_t parseFramesInFlight(std::string_view value) {
+    size_t parsed = 0;
+    unsigned long frames = 0;
+    try {
+        frames = std::stoul(std::string(value), &parsed);
+    } catch (const std::exception&) {
+        parsed = 0;
+    }
+    if (value.empty() || parsed != value.size() || frames < 1 || frames > MAX_FRAMES_IN_FLIGHT) {
+        throw std::invalid_argument("Invalid value for --frames-in-flight: " + std::string(value) +
+                                    " (expected 1.." + std::to_string(MAX_FRAMES_IN_FLIGHT) + ")");
+    }
+    return static_cast<uint32_t>(frames);
+}
+
+float parseLODThreshold(std::string_view value) {
+    std::string str(value);
+    size_t parsed = 0;
+    float pixels = -1.0f;
+    try {
+        pixels = std::stof(str, &parsed);
+    } catch (const std::exception&) {
+        parsed = 0;
+    }
+    if (str.empty() || parsed != str.size() || !(pixels >= 0.0f)) {
+        throw std::invalid_argument("Invalid value for --lod: " + str + " (expected a pixel size >= 0)");
+    }
+    return pixels;
+}
+
+LoadMode parseLoadMode(std::string_view value) {
+    if (value == "memory") return LoadMode::memory;
+    if (value == "stream") return LoadMode::stream;
+    throw std::invalid_argument("Invalid value for --load: " + std::string(value) + " (expected memory|stream)");
+}
+
+BuildBackend parseBuildBackend(std::string_view value) {
+    if (value == "gpu") return BuildBackend::gpu;
+    if (value == "cpu") return BuildBackend::cpu;
+    if (value == "validate") return BuildBackend::validate;
+    throw std::invalid_argument("Invalid value for --build: " + std::string(value) + " (expected gpu|cpu|validate)");
+}
+
+CacheMode parseCacheMode(std::string_view value) {
+    if (value == "on") return CacheMode::on;
+    if (value == "off") return CacheMode::off;
+    if (value == "rebuild") return CacheMode::rebuild;
+    throw std::invalid_argument("Invalid value for --cache: " + std::string(value) + " (expected on|off|rebuild)");
+}
+
+uint32_t parseTileBudget(std::string_view value) {
+    size_t parsed = 0;
+    unsigned long megabytes = 0;
+    try {
+        megabytes = std::stoul(std::string(value), &parsed);
+    } catch (const std::exception&) {
+        parsed = 0;
+    }
+    if (value.empty() || parsed != value.size() || megabytes < 1 || megabytes > MAX_TILE_BUDGET_MB) {
+        throw std::invalid_argument("Invalid value for --tile-budget: " + std::string(value) +
+                                    " (expected 1.." + std::to_string(MAX_TILE_BUDGET_MB) + " MiB)");
+    }
+    return static_cast<uint32_t>(megabytes);
+}
+
+uint32_t parseReprojectFrames(std::string_view value) {
+    size_t parsed = 0;
+    unsigned long frames = 0;
+    try {
+        frames = std::stoul(std::string(value), &parsed);
+    } catch (const std::exception&) {
+        parsed = 0;
+    }
+    if (value.empty() || parsed != value.size() || frames > MAX_REPROJECT_FRAMES) {
+        throw std::invalid_argument("Invalid value for --reproject: " + std::string(value) +
+                                    " (expected 0.." + std::to_string(MAX_REPROJECT_FRAMES) + " frames)");
+    }
+    return static_cast<uint32_t>(frames);
+}
+
+bool parseSwitch(std::string_view name, std::string_view value) {
+    if (value == "on") return true;
+    if (value == "off") return false;
+    throw std::invalid_argument("Invalid value for " + std::string(name) + ": " + std::string(value) + " (expected on|off)");
+}
+
+std::string parsePath(std::string_view name, std::string_view value) {
+    if (value.empty()) throw std::invalid_argument("Missing path for " + std::string(name));
+    return std::string(value);
+}
+
+std::vector<std::string> parsePathList(std::string_view name, std::string_view value) {
+    std::vector<std::string> paths;
+    size_t start = 0;
+    while (true) {
+        size_t comma = value.find(',', start);
+        paths.push_back(parsePath(name, value.substr(start, comma == std::string_view::npos ? comma : comma - start)));
+        if (comma == std::string_view::npos) return paths;
+        start = comma + 1;
+    }
+}
+
+} // namespace
+
+Config parseCommandLine(int argc, char** argv) {
+    Config config;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg(argv[i]);
+
+        // Split "--name=value" into its two halves
+        size_t eq = arg.find('=');
+        std::string_view name = arg.substr(0, eq);
+        std::string_view value = (eq == std::string_view::npos) ? std::string_view{} : arg.substr(eq + 1);
+
+        if (name == "--sort") {
+            config.sortAlgorithm = parseSortAlgorithm(value);
+        } else if (name == "--morton-bits") {
+            config.mortonBits = parseMortonBits(value);
+        } else if (name == "--cull") {
+            config.cullingMode = parseCullingMode(value);
+        } else if (name == "--cull-output") {
+            config.cullOutput = parseCullOutput(value);
+        } else if (name == "--render") {
+            config.renderMode = parseRenderMode(value);
+        } else if (name == "--occlusion") {
+            config.occlusionCulling = parseSwitch(name, value);
+        } else if (name == "--temporal-reuse") {
+            config.temporalReuse = parseSwitch(name, value);
+        } else if (name == "--reproject") {
+            config.reprojectFrames = parseReprojectFrames(value);
+        } else if (name == "--frames-in-flight") {
+            config.framesInFlight = parseFramesInFlight(value);
+        } else if (name == "--point-format") {
+            config.pointFormat = parsePointFormat(value);
+        } else if (name == "--lod") {
+            config.lodPixelThreshold = parseLODThreshold(value);
+        } else if (name == "--load") {
+            config.loadMode = parseLoadMode(value);
+        } else if (name == "--build") {
+            config.buildBackend = parseBuildBackend(value);
+        } else if (name == "--cache") {
+            config.cacheMode = parseCacheMode(value);
+        } else if (name == "--input") {
+            config.inputPaths = parsePathList(name, value);
+        } else if (name == "--tiles") {
+            config.tilesPath = parsePath(name, value);
+        } else if (name == "--tile-budget") {
+            config.tileBudgetMB = parseTileBudget(value);
+        } else if (name == "--cache-file") {
+            config.cachePath = parsePath(name, value);
+        } else if (name == "--profile") {
+            config.profilePath = parsePath(name, value);
+        } else {
+            throw std::invalid_argument("Unknown option: " + std::string(arg));
+        }
+    }
+
+    // The LOD cut is part of the tree traversal
+    if (config.lodPixelThreshold > 0.0f && config.cullingMode != CullingMode::tree) {
+        throw std::invalid_argument("--lod requires --cull=tree");
+    }
+
+    // The Hi-Z test is part of the tree traversal
+    if (config.occlusionCulling && config.cullingMode != CullingMode::tree) {
+        throw std::invalid_argument("--occlusion=on requires --cull=tree");
+    }
+
+    // The reprojection moves the compute framebuffer of the previous frame in flight into the
+    // current one and culls the tree against what it leaves uncovered
+    if (config.reprojectFrames > 0 &&
+        (config.renderMode != RenderMode::compute || config.cullingMode != CullingMode::tree || config.framesInFlight < 2)) {
+        throw std::invalid_argument("--reproject requires --render=compute, --cull=tree and --frames-in-flight>=2");
+    }
+
+    // Tiles are drawn as points straight from their GPU arena, without the culling outputs
+    // the compute rasterizer and the index fetch read
+    if (!config.tilesPath.empty() && (config.renderMode != RenderMode::quads || config.cullOutput != CullOutput::points)) {
+        throw std::invalid_argument("--tiles requires --render=quads and --cull-output=points");
+    }
+
+    // A cache given as the input is restored as is, it has no sources to rebuild or merge from
+    if (std::any_of(config.inputPaths.begin(), config.inputPaths.end(), isPointCachePath) &&
+        (config.inputPaths.size() != 1 || config.cacheMode != CacheMode::on || !config.cachePath.empty())) {
+        throw std::invalid_argument("--input=<file>.pspire must be the only input and requires --cache=on without --cache-file");
+    }
+
+    // The CPU build works on the points held in host memory
+    if (config.buildBackend != BuildBackend::gpu && config.loadMode != LoadMode::memory) {
+        throw std::invalid_argument("--build=cpu|validate requires --load=memory");
+    }
+
+    return config;
+}
@@ -0,0 +1,454 @@
+#include "CpuLPCBuilder.hpp"
+#include "PointCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+/// Items per chunk of the parallel loops, large enough to amortize the scheduling.
+constexpr size_t CPU_BUILD_GRAIN = 1 << 16;
+
+constexpr uint32_t INVALID_NODE = 0xFFFFFFFFu;
+
+/// Spreads the lower 21 bits of v so that there are two zero bits between each (bit k to bit 3k).
+uint64_t expandBits(uint64_t v) {
+    v &= 0x1FFFFFull;
+    v = (v | (v << 32)) & 0x1F00000000FFFFull;
+    v = (v | (v << 16)) & 0x1F0000FF0000FFull;
+    v = (v | (v << 8)) & 0x100F00F00F00F00Full;
+    v = (v | (v << 4)) & 0x10C30C30C30C30C3ull;
+    v = (v | (v << 2)) & 0x1249249249249249ull;
+    return v;
+}
+
+/// Splits [0, count) into about one block per worker for the passes that need a fixed partition.
+size_t blockSizeFor(size_t count, unsigned workers) {
+    return std::max(CPU_BUILD_GRAIN, (count + workers - 1) / workers);
+}
+
+float seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+CpuLPCBuilder::CpuLPCBuilder(const PointCloud& pointCloud, unsigned threadCount)
+    : m_pointCloud(pointCloud), m_attributes(pointCloud.getAttributes()),
+      m_mortonBits(pointCloud.getMortonKeyBits()), m_pool(threadCount) {
+    if (m_attributes.size() != pointCloud.getTotalPointCount()) {
+        throw std::runtime_error("The CPU LPC build needs the points in host memory (--load=memory)");
+    }
+}
+
+uint64_t CpuLPCBuilder::mortonKey(const glm::vec3& position, const glm::vec3& boundsMin,
+                                  const glm::vec3& scale, uint32_t bitsPerAxis) {
+    // Same operations as morton3D in include/morton.glsl
+    const float axisMax = static_cast<float>((1u << bitsPerAxis) - 1u);
+    glm::vec3 norm = glm::clamp((position - boundsMin) * scale, 0.0f, 1.0f);
+    uint64_t x = static_cast<uint32_t>(norm.x * axisMax);
+    uint64_t y = static_cast<uint32_t>(norm.y * axisMax);
+    uint64_t z = static_cast<uint32_t>(norm.z * axisMax);
+    return (expandBits(x) << 2) | (expandBits(y) << 1) | expandBits(z);
+}
+
+LPCHierarchy CpuLPCBuilder::build(std::vector<LPCStageTiming>* timings) {
+    std::cout << "--- Building Layered Point Cloud on the CPU (" << m_mortonBits << "-bit Morton keys, "
+              << m_pool.size() << " threads) ---" << std::endl;
+    const auto buildStart = std::chrono::steady_clock::now();
+    const size_t numPoints = m_attributes.size();
+    LPCHierarchy lpc;
+    if (numPoints == 0) return lpc;
+
+    auto stageStart = buildStart;
+    auto endStage = [&](const char* stage) {
+        if (!timings) return;
+        auto now = std::chrono::steady_clock::now();
+        timings->push_back({stage, std::chrono::duration<double, std::milli>(now - stageStart).count()});
+        stageStart = now;
+    };
+
+    // 1. Morton keys of the positions the shaders would load
+    std::vector<glm::vec3> positions = loadPositions();
+    const AABB& bounds = m_pointCloud.getBounds();
+    const glm::vec3 scale = computeMortonScale(bounds);
+    const uint32_t bitsPerAxis = m_mortonBits / 3;
+    std::vector<uint64_t> keys(numPoints);
+    lpc.order.resize(numPoints);
+    m_pool.parallelFor(numPoints, CPU_BUILD_GRAIN, [&](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            keys[i] = mortonKey(positions[i], bounds.min, scale, bitsPerAxis);
+            lpc.order[i] = static_cast<uint32_t>(i);
+        }
+    });
+    endStage("morton");
+
+    // 2. Sort
+    radixSort(keys, lpc.order);
+    endStage("sort");
+
+    // 3. Reorder
+    lpc.sortedPoints.resize(numPoints);
+    std::vector<glm::vec3> sortedPositions(numPoints);
+    m_pool.parallelFor(numPoints, CPU_BUILD_GRAIN, [&](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            uint32_t src = lpc.order[i];
+            lpc.sortedPoints.positions[i] = m_attributes.positions[src];
+            lpc.sortedPoints.colors[i] = m_attributes.colors[src];
+            lpc.sortedPoints.intensities[i] = m_attributes.intensities[src];
+            sortedPositions[i] = positions[src];
+        }
+    });
+    positions = {};
+    endStage("reorder");
+
+    // 4./5. Unique voxels
+    compactVoxels(keys, lpc);
+    keys = {};
+    endStage("compact");
+
+    // 6./7. Tree
+    buildTree(lpc);
+    endStage("build_tree");
+
+    // 8./9. Refit
+    refit(sortedPositions, lpc);
+    endStage("refit");
+
+    // 10. Culling cut
+    findCut(lpc);
+    endStage("cull_cut");
+
+    std::cout << "Built " << lpc.getUniqueCount() << " voxels, " << lpc.nodes.size() << " nodes, "
+              << lpc.cutNodes.size() << " culling subtrees in " << seconds(buildStart) << " s" << std::endl;
+    return lpc;
+}
+
+std::vector<glm::vec3> CpuLPCBuilder::loadPositions() {
+    std::vector<glm::vec3> positions(m_attributes.size());
+    m_pool.parallelFor(positions.size(), CPU_BUILD_GRAIN, [&](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) positions[i] = m_pointCloud.getStoredPosition(m_attributes.positions[i]);
+    });
+    return positions;
+}
+
+void CpuLPCBuilder::radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values) {
+    const size_t count = keys.size();
+    const size_t blockSize = blockSizeFor(count, m_pool.size());
+    const size_t blockCount = (count + blockSize - 1) / blockSize;
+
+    std::vector<uint64_t> altKeys(count);
+    std::vector<uint32_t> altValues(count);
+    std::vector<std::array<size_t, RADIX_SORT_BINS>> offsets(blockCount);
+
+    for (uint32_t pass = 0; pass < m_pointCloud.getRadixPassCount(); ++pass) {
+        const uint32_t shift = pass * RADIX_SORT_BITS;
+
+        // Per-block digit histograms
+        m_pool.parallelFor(count, blockSize, [&](unsigned, size_t begin, size_t end) {
+            std::array<size_t, RADIX_SORT_BINS>& histogram = offsets[begin / blockSize];
+            histogram.fill(0);
+            for (size_t i = begin; i < end; ++i) ++histogram[(keys[i] >> shift) & (RADIX_SORT_BINS - 1)];
+        });
+
+        // Digit-major exclusive scan: every block scatters behind the earlier blocks of the same digit
+        size_t sum = 0;
+        for (uint32_t digit = 0; digit < RADIX_SORT_BINS; ++digit) {
+            for (std::array<size_t, RADIX_SORT_BINS>& histogram : offsets) {
+                size_t digitCount = histogram[digit];
+                histogram[digit] = sum;
+                sum += digitCount;
+            }
+        }
+
+        // Stable scatter, each block in order
+        m_pool.parallelFor(count, blockSize, [&](unsigned, size_t begin, size_t end) {
+            std::array<size_t, RADIX_SORT_BINS>& offset = offsets[begin / blockSize];
+            for (size_t i = begin; i < end; ++i) {
+                size_t dst = offset[(keys[i] >> shift) & (RADIX_SORT_BINS - 1)]++;
+                altKeys[dst] = keys[i];
+                altValues[dst] = values[i];
+            }
+        });
+
+        keys.swap(altKeys);
+        values.swap(altValues);
+    }
+}
+
+void CpuLPCBuilder::compactVoxels(const std::vector<uint64_t>& sortedKeys, LPCHierarchy& lpc) {
+    const size_t count = sortedKeys.size();
+    const size_t blockSize = blockSizeFor(count, m_pool.size());
+    const size_t blockCount = (count + blockSize - 1) / blockSize;
+    auto isHead = [&](size_t i) { return i == 0 || sortedKeys[i] != sortedKeys[i - 1]; };
+
+    // Heads per block, then an exclusive scan over the blocks
+    std::vector<size_t> blockOffsets(blockCount + 1, 0);
+    m_pool.parallelFor(count, blockSize, [&](unsigned, size_t begin, size_t end) {
+        size_t heads = 0;
+        for (size_t i = begin; i < end; ++i) heads += isHead(i);
+        blockOffsets[begin / blockSize + 1] = heads;
+    });
+    for (size_t block = 0; block < blockCount; ++block) blockOffsets[block + 1] += blockOffsets[block];
+
+    // Scatter the heads to their scanned slots
+    const size_t numUnique = blockOffsets[blockCount];
+    lpc.uniqueCodes.resize(numUnique);
+    lpc.voxelStarts.resize(numUnique);
+    m_pool.parallelFor(count, blockSize, [&](unsigned, size_t begin, size_t end) {
+        size_t slot = blockOffsets[begin / blockSize];
+        for (size_t i = begin; i < end; ++i) {
+            if (!isHead(i)) continue;
+            lpc.uniqueCodes[slot] = sortedKeys[i];
+            lpc.voxelStarts[slot] = static_cast<uint32_t>(i);
+            ++slot;
+        }
+    });
+}
+
+void CpuLPCBuilder::buildTree(LPCHierarchy& lpc) {
+    const int numUnique = static_cast<int>(lpc.getUniqueCount());
+    const uint32_t numPoints = static_cast<uint32_t>(m_attributes.size());
+    const int storageBits = m_mortonBits > 32 ? 64 : 32;
+    const std::vector<uint64_t>& codes = lpc.uniqueCodes;
+    lpc.nodes.resize(2 * static_cast<size_t>(numUnique) - 1);
+
+    // 6. Leaves, behind the numUnique - 1 internal nodes
+    const uint32_t leafOffset = static_cast<uint32_t>(numUnique - 1);
+    m_pool.parallelFor(numUnique, CPU_BUILD_GRAIN, [&](unsigned, size_t begin, size_t end) {
+        for (size_t idx = begin; idx < end; ++idx) {
+            uint32_t start = lpc.voxelStarts[idx];
+            uint32_t next = idx + 1 < lpc.voxelStarts.size() ? lpc.voxelStarts[idx + 1] : numPoints;
+            lpc.nodes[leafOffset + idx] = Node{
+                INVALID_NODE, INVALID_NODE, INVALID_NODE, 1,
+                static_cast<uint32_t>(codes[idx]), static_cast<uint32_t>(codes[idx] >> 32),
+                static_cast<uint32_t>(storageBits), start, next - start
+            };
+        }
+    });
+
+    // Common prefix length of two keys over the storage width, -1 outside the array (7_build_internal.comp)
+    auto delta = [&](int i, int j) {
+        if (j < 0 || j >= numUnique) return -1;
+        uint64_t diff = codes[i] ^ codes[j];
+        if (diff == 0) return storageBits + std::countl_zero(static_cast<uint32_t>(i ^ j));
+        return storageBits == 64 ? std::countl_zero(diff) : std::countl_zero(static_cast<uint32_t>(diff));
+    };
+
+    // 7. Internal nodes (Karras 2012), each one independent of the others
+    m_pool.parallelFor(leafOffset, CPU_BUILD_GRAIN, [&](unsigned, size_t begin, size_t end) {
+        for (int i = static_cast<int>(begin); i < static_cast<int>(end); ++i) {
+            // Direction and extent of the key range covered by node i
+            int d = delta(i, i + 1) > delta(i, i - 1) ? 1 : -1;
+            int minDelta = delta(i, i - d);
+            int lMax = 2;
+            while (delta(i, i + lMax * d) > minDelta) lMax *= 2;
+
+            int l = 0;
+            for (int t = lMax / 2; t >= 1; t /= 2) {
+                if (delta(i, i + (l + t) * d) > minDelta) l += t;
+            }
+            int j = i + l * d;
+            int nodeDelta = delta(i, j);
+
+            // Split position
+            int s = 0;
+            int t = l;
+            do {
+                t = (t + 1) / 2;
+                if (delta(i, i + (s + t) * d) > nodeDelta) s += t;
+            } while (t > 1);
+            int gamma = i + s * d + std::min(d, 0);
+
+            Node& node = lpc.nodes[i];
+            node.isLeaf = 0;
+            node.mortonCode = static_cast<uint32_t>(codes[gamma]);
+            node.mortonCodeHigh = static_cast<uint32_t>(codes[gamma] >> 32);
+            node.prefixLen = static_cast<uint32_t>(nodeDelta);
+            node.pointStart = 0;
+            node.pointCount = 0;
+            node.left = std::min(i, j) == gamma ? leafOffset + gamma : gamma;
+            node.right = std::max(i, j) == gamma + 1 ? leafOffset + gamma + 1 : gamma + 1;
+
+            // Every node has exactly one parent, so no two iterations write the same field
+            lpc.nodes[node.left].parent = static_cast<uint32_t>(i);
+            lpc.nodes[node.right].parent = static_cast<uint32_t>(i);
+            if (i == 0) node.parent = INVALID_NODE;
+        }
+    });
+}
+
+void CpuLPCBuilder::refit(const std::vector<glm::vec3>& sortedPositions, LPCHierarchy& lpc) {
+    const size_t numUnique = lpc.getUniqueCount();
+    const size_t leafOffset = numUnique - 1;
+    lpc.nodeBounds.resize(lpc.nodes.size());
+    lpc.proxies.resize(lpc.nodes.size());
+    lpc.proxySplatSizes.resize(lpc.nodes.size());
+    std::vector<std::atomic<uint32_t>> visits(leafOffset);
+    for (std::atomic<uint32_t>& visit : visits) visit.store(0, std::memory_order_relaxed);
+
+    auto storeProxy = [&](size_t node, const glm::vec3& position, const glm::vec3& color, float intensity) {
+        glm::vec3 extent = lpc.nodeBounds[node].max - lpc.nodeBounds[node].min;
+        lpc.proxies.positions[node] = position;
+        lpc.proxies.colors[node] = color;
+        lpc.proxies.intensities[node] = intensity;
+        lpc.proxySplatSizes[node] = 0.5f * std::max(extent.x, std::max(extent.y, extent.z));
+    };
+
+    // Each leaf is refitted from its points, then walks up; the second child
+    // to arrive at a node merges both (8_refit_leaves / 9_refit_internal.comp)
+    m_pool.parallelFor(numUnique, CPU_BUILD_GRAIN, [&](unsigned, size_t begin, size_t end) {
+        for (size_t idx = begin; idx < end; ++idx) {
+            const size_t leaf = leafOffset + idx;
+            const uint32_t start = lpc.nodes[leaf].pointStart;
+            const uint32_t stop = start + lpc.nodes[leaf].pointCount;
+
+            AABB box{sortedPositions[start], sortedPositions[start]};
+            glm::vec3 positionSum(0.0f);
+            glm::vec3 colorSum(0.0f);
+            float intensitySum = 0.0f;
+            for (uint32_t i = start; i < stop; ++i) {
+                box.min = glm::min(box.min, sortedPositions[i]);
+                box.max = glm::max(box.max, sortedPositions[i]);
+                positionSum += sortedPositions[i];
+                colorSum += lpc.sortedPoints.colors[i];
+                intensitySum += lpc.sortedPoints.intensities[i];
+            }
+            lpc.nodeBounds[leaf] = box;
+            float invCount = 1.0f / static_cast<float>(stop - start);
+            storeProxy(leaf, positionSum * invCount, colorSum * invCount, intensitySum * invCount);
+
+            for (uint32_t current = lpc.nodes[leaf].parent; current != INVALID_NODE; current = lpc.nodes[current].parent) {
+                // acq_rel publishes this subtree to, and acquires the sibling subtree from, the other child
+                if (visits[current].fetch_add(1, std::memory_order_acq_rel) == 0) break;
+
+                Node& node = lpc.nodes[current];
+                const Node& left = lpc.nodes[node.left];
+                const Node& right = lpc.nodes[node.right];
+                lpc.nodeBounds[current] = {glm::min(lpc.nodeBounds[node.left].min, lpc.nodeBounds[node.right].min),
+                                           glm::max(lpc.nodeBounds[node.left].max, lpc.nodeBounds[node.right].max)};
+                node.pointStart = left.pointStart;
+                node.pointCount = left.pointCount + right.pointCount;
+
+                float wLeft = static_cast<float>(left.pointCount) / static_cast<float>(node.pointCount);
+                float wRight = 1.0f - wLeft;
+                storeProxy(current,
+                           lpc.proxies.positions[node.left] * wLeft + lpc.proxies.positions[node.right] * wRight,
+                           lpc.proxies.colors[node.left] * wLeft + lpc.proxies.colors[node.right] * wRight,
+                           lpc.proxies.intensities[node.left] * wLeft + lpc.proxies.intensities[node.right] * wRight);
+            }
+        }
+    });
+}
+
+void CpuLPCBuilder::findCut(LPCHierarchy& lpc) {
+    // CUT_LEVELS and CUT_PREFIX of 10_cull_cut.comp
+    constexpr uint32_t cutLevels = 5;
+    const uint32_t storageBits = m_mortonBits > 32 ? 64 : 32;
+    const uint32_t cutPrefix = storageBits - m_mortonBits + 3 * cutLevels;
+
+    const size_t count = lpc.nodes.size();
+    const size_t blockSize = blockSizeFor(count, m_pool.size());
+    std::vector<std::vector<uint32_t>> blockCuts((count + blockSize - 1) / blockSize);
+    m_pool.parallelFor(count, blockSize, [&](unsigned, size_t begin, size_t end) {
+        std::vector<uint32_t>& cut = blockCuts[begin / blockSize];
+        for (size_t idx = begin; idx < end; ++idx) {
+            uint32_t parent = lpc.nodes[idx].parent;
+            bool reachesCut = lpc.nodes[idx].prefixLen >= cutPrefix;
+            bool parentAbove = parent == INVALID_NODE || lpc.nodes[parent].prefixLen < cutPrefix;
+            if (reachesCut && parentAbove) cut.push_back(static_cast<uint32_t>(idx));
+        }
+    });
+
+    // Blocks are concatenated in order, so the cut is ascending (the GPU appends in any order)
+    for (const std::vector<uint32_t>& cut : blockCuts) lpc.cutNodes.insert(lpc.cutNodes.end(), cut.begin(), cut.end());
+}
+
+std::vector<uint8_t> LPCHierarchy::packUniqueCodes(size_t keySize) const {
+    // uvec2(low, high) is the little-endian uint64, uint keys are its low word
+    std::vector<uint8_t> packed(uniqueCodes.size() * keySize);
+    for (size_t i = 0; i < uniqueCodes.size(); ++i) std::memcpy(packed.data() + i * keySize, &uniqueCodes[i], keySize);
+    return packed;
+}
+
+bool validateLPC(const PointCloud& pointCloud, const LPCHierarchy& reference, bool comparePoints) {
+    std::cout << "--- Validating the GPU build against the CPU build ---" << std::endl;
+    bool valid = true;
+
+    // Reports the first differing element of a section
+    auto compare = [&](const char* name, const std::vector<uint8_t>& gpu, const uint8_t* cpu, size_t cpuSize, size_t elementSize) {
+        size_t count = std::min(gpu.size(), cpuSize) / elementSize;
+        size_t mismatches = 0;
+        size_t first = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (std::memcmp(gpu.data() + i * elementSize, cpu + i * elementSize, elementSize) == 0) continue;
+            if (mismatches++ == 0) first = i;
+        }
+        if (gpu.size() != cpuSize) {
+            std::cout << "  " << name << ": " << gpu.size() / elementSize << " elements on the GPU, "
+                      << cpuSize / elementSize << " on the CPU" << std::endl;
+            valid = false;
+        } else if (mismatches > 0) {
+            std::cout << "  " << name << ": " << mismatches << " of " << count << " differ, first at " << first << std::endl;
+            valid = false;
+        } else {
+            std::cout << "  " << name << ": " << count << " identical" << std::endl;
+        }
+    };
+    auto compareSection = [&](CacheSection section, const char* name, const auto& cpu) {
+        using Element = std::remove_cvref_t<decltype(*cpu.data())>;
+        compare(name, pointCloud.downloadSection(section), reinterpret_cast<const uint8_t*>(cpu.data()),
+                cpu.size() * sizeof(Element), sizeof(Element));
+    };
+
+    if (pointCloud.getUniqueCount() != reference.getUniqueCount()) {
+        std::cout << "  numUnique: " << pointCloud.getUniqueCount() << " on the GPU, "
+                  << reference.getUniqueCount() << " on the CPU" << std::endl;
+        valid = false;
+    }
+
+    const size_t keySize = pointCloud.getMortonKeySize();
+    std::vector<uint8_t> codes = reference.packUniqueCodes(keySize);
+    compare("unique codes", pointCloud.downloadSection(CacheSection::uniqueCodes), codes.data(), codes.size(), keySize);
+    compareSection(CacheSection::voxelStarts, "voxel starts", reference.voxelStarts);
+    compareSection(CacheSection::nodes, "nodes", reference.nodes);
+    compareSection(CacheSection::nodeBounds, "node bounds", reference.nodeBounds);
+
+    // The GPU appends the cut in any order
+    std::vector<uint8_t> cutData = pointCloud.downloadSection(CacheSection::cullCut);
+    std::vector<uint32_t> cut(cutData.size() / sizeof(uint32_t));
+    std::memcpy(cut.data(), cutData.data(), cut.size() * sizeof(uint32_t));
+    if (!cut.empty()) cut.erase(cut.begin());
+    std::sort(cut.begin(), cut.end());
+    if (cut == reference.cutNodes) {
+        std::cout << "  culling cut: " << cut.size() << " identical" << std::endl;
+    } else {
+        std::cout << "  culling cut: " << cut.size() << " subtrees on the GPU, "
+                  << reference.cutNodes.size() << " on the CPU, sets differ" << std::endl;
+        valid = false;
+    }
+
+    if (comparePoints) {
+        const std::array<size_t, 3> strides = pointCloud.getStreamStrides();
+        std::array<std::vector<uint8_t>, 3> streams;
+        for (size_t s = 0; s < streams.size(); ++s) streams[s].resize(reference.sortedPoints.size() * strides[s]);
+        pointCloud.encodePoints(reference.sortedPoints, 0, reference.sortedPoints.size(),
+                                {streams[0].data(), streams[1].data(), streams[2].data()});
+
+        const std::array<CacheSection, 3> sections{CacheSection::points, CacheSection::colors, CacheSection::intensities};
+        for (size_t s = 0; s < streams.size(); ++s) {
+            if (strides[s] == 0) continue;
+            compare("sorted points", pointCloud.downloadSection(sections[s]), streams[s].data(), streams[s].size(), strides[s]);
+        }
+    }
+
+    std::cout << (valid ? "GPU build matches the CPU reference" : "GPU build DIFFERS from the CPU reference") << std::endl;
+    return valid;
+}
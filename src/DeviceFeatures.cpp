@@ -0,0 +1,89 @@
+#include "DeviceFeatures.hpp"
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+DeviceFeatures g_deviceFeatures;
+
+} // namespace
+
+const DeviceFeatures& getDeviceFeatures() {
+    return g_deviceFeatures;
+}
+
+// The vkCreateDevice of the Vulkan loader, reached through the linker (--wrap=vkCreateDevice)
+extern "C" VkResult __real_vkCreateDevice(VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo* createInfo,
+                                          const VkAllocationCallbacks* allocator, VkDevice* device);
+
+// Every vkCreateDevice call, including TGA's, lands here. The request is passed on
+// unchanged except for the 64-bit buffer atomics, added when the device supports them.
+extern "C" VkResult __wrap_vkCreateDevice(VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo* createInfo,
+                                          const VkAllocationCallbacks* allocator, VkDevice* device) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    VkPhysicalDeviceShaderAtomicInt64Features supportedAtomics{};
+    supportedAtomics.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_ATOMIC_INT64_FEATURES;
+    VkPhysicalDeviceFeatures2 supported{};
+    supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported.pNext = &supportedAtomics;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supported);
+
+    g_deviceFeatures = {};
+    g_deviceFeatures.intercepted = true;
+    g_deviceFeatures.deviceName = properties.deviceName;
+    if (!supported.features.shaderInt64 || !supportedAtomics.shaderBufferInt64Atomics) {
+        return __real_vkCreateDevice(physicalDevice, createInfo, allocator, device);
+    }
+
+    // Feature structs already in the chain must not appear twice, so those are extended
+    // in place; they are TGA's temporaries and only live for this call
+    VkDeviceCreateInfo info = *createInfo;
+    bool chainedFeatures = false;
+    bool chainedAtomics = false;
+    for (auto* s = static_cast<VkBaseOutStructure*>(const_cast<void*>(info.pNext)); s; s = s->pNext) {
+        if (s->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2) {
+            reinterpret_cast<VkPhysicalDeviceFeatures2*>(s)->features.shaderInt64 = VK_TRUE;
+            chainedFeatures = true;
+        } else if (s->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES) {
+            reinterpret_cast<VkPhysicalDeviceVulkan12Features*>(s)->shaderBufferInt64Atomics = VK_TRUE;
+            chainedAtomics = true;
+        } else if (s->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_ATOMIC_INT64_FEATURES) {
+            reinterpret_cast<VkPhysicalDeviceShaderAtomicInt64Features*>(s)->shaderBufferInt64Atomics = VK_TRUE;
+            chainedAtomics = true;
+        }
+    }
+
+    VkPhysicalDeviceFeatures features = createInfo->pEnabledFeatures ? *createInfo->pEnabledFeatures : VkPhysicalDeviceFeatures{};
+    if (!chainedFeatures) {
+        features.shaderInt64 = VK_TRUE;
+        info.pEnabledFeatures = &features;
+    }
+
+    VkPhysicalDeviceShaderAtomicInt64Features atomics{};
+    if (!chainedAtomics) {
+        atomics.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_ATOMIC_INT64_FEATURES;
+        atomics.pNext = const_cast<void*>(info.pNext);
+        atomics.shaderBufferInt64Atomics = VK_TRUE;
+        info.pNext = &atomics;
+    }
+
+    // Core since Vulkan 1.2, but the extension keeps older devices and instances covered
+    std::vector<const char*> extensions(info.ppEnabledExtensionNames, info.ppEnabledExtensionNames + info.enabledExtensionCount);
+    if (std::none_of(extensions.begin(), extensions.end(), [](const char* name) {
+            return std::strcmp(name, VK_KHR_SHADER_ATOMIC_INT64_EXTENSION_NAME) == 0;
+        })) {
+        extensions.push_back(VK_KHR_SHADER_ATOMIC_INT64_EXTENSION_NAME);
+        info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        info.ppEnabledExtensionNames = extensions.data();
+    }
+
+    // Should the additions be refused after all, TGA still gets the device it asked for
+    VkResult result = __real_vkCreateDevice(physicalDevice, &info, allocator, device);
+    g_deviceFeatures.bufferInt64Atomics = result == VK_SUCCESS;
+    if (result != VK_SUCCESS) result = __real_vkCreateDevice(physicalDevice, createInfo, allocator, device);
+    return result;
+}
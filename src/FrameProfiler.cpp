@@ -0,0 +1,104 @@
+#include "FrameProfiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+/// Escapes the characters JSON strings may not hold verbatim.
+std::string escapeJson(std::string_view text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+} // namespace
+
+FrameProfiler::FrameProfiler(const std::string& tracePath, size_t historySize)
+    : m_origin(Clock::now()), m_historySize(std::max<size_t>(historySize, 1)), m_trace(tracePath) {
+    if (!m_trace) throw std::runtime_error("Cannot create the trace file " + tracePath);
+    m_trace << std::fixed << std::setprecision(3);
+    m_trace << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+}
+
+FrameProfiler::~FrameProfiler() {
+    m_trace << "\n]}\n";
+}
+
+void FrameProfiler::addSample(std::string_view pass, Clock::time_point begin, Clock::time_point end) {
+    double milliseconds = std::chrono::duration<double, std::milli>(end - begin).count();
+
+    auto history = std::find_if(m_passes.begin(), m_passes.end(), [&](const PassHistory& h) { return h.name == pass; });
+    if (history == m_passes.end()) {
+        m_passes.push_back({std::string(pass), {}, 0});
+        history = std::prev(m_passes.end());
+    }
+    if (history->samples.size() < m_historySize) {
+        history->samples.push_back(milliseconds);
+    } else {
+        history->samples[history->next] = milliseconds;
+        history->next = (history->next + 1) % m_historySize;
+    }
+
+    writeEvent(pass, "frame", begin, milliseconds);
+}
+
+void FrameProfiler::addTraceEvent(std::string_view name, std::string_view category, Clock::time_point begin, double milliseconds) {
+    writeEvent(name, category, begin, milliseconds);
+}
+
+void FrameProfiler::writeEvent(std::string_view name, std::string_view category, Clock::time_point begin, double milliseconds) {
+    // Complete events ("X") with timestamps in microseconds since the profiler started
+    double start = std::chrono::duration<double, std::micro>(begin - m_origin).count();
+    m_trace << (m_firstEvent ? "\n" : ",\n")
+            << "{\"name\": \"" << escapeJson(name) << "\", \"cat\": \"" << escapeJson(category)
+            << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": " << start
+            << ", \"dur\": " << milliseconds * 1000.0 << "}";
+    m_firstEvent = false;
+}
+
+std::vector<FrameProfiler::PassStats> FrameProfiler::getStats() const {
+    std::vector<PassStats> stats;
+    for (const PassHistory& history : m_passes) {
+        if (history.samples.empty()) continue;
+        std::vector<double> sorted = history.samples;
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&](double p) {
+            size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+            return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+        };
+
+        double sum = 0.0;
+        for (double sample : sorted) sum += sample;
+        stats.push_back({history.name, sum / sorted.size(), percentile(0.5), percentile(0.95), sorted.back()});
+    }
+    return stats;
+}
+
+std::string FrameProfiler::getSummary() const {
+    std::ostringstream summary;
+    summary << std::fixed << std::setprecision(2);
+    bool first = true;
+    for (const PassStats& pass : getStats()) {
+        summary << (first ? "" : ", ") << pass.name << ' ' << pass.p50 << '/' << pass.p95 << " ms";
+        first = false;
+    }
+    return summary.str();
+}
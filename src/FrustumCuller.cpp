@@ -0,0 +1,286 @@
+#include "FrustumCuller.hpp"
+#include "GpuUtils.hpp"
+#include "tga/tga_utils.hpp"
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+FrustumCuller::FrustumCuller(tga::Interface& tgai, PointCloud& pointCloud, const Config& config,
+                             const std::vector<tga::Buffer>& cameraUbos, uint32_t viewportWidth, uint32_t viewportHeight,
+                             const std::vector<tga::Buffer>& framebuffers)
+    : m_tgai(tgai), m_pointCloud(pointCloud), m_mode(config.cullingMode) {
+    if (cameraUbos.size() != pointCloud.getFramesInFlight()) {
+        throw std::invalid_argument("FrustumCuller needs one camera buffer per frame in flight");
+    }
+    if (m_mode == CullingMode::tree) {
+        createTreeCullingPasses(cameraUbos, viewportWidth, viewportHeight, config, framebuffers);
+    } else {
+        createPointCullingPass(cameraUbos);
+    }
+}
+
+FrustumCuller::~FrustumCuller() {
+    for (tga::StagingBuffer staging : m_treeCull.statsStaging) m_tgai.free(staging);
+    if (m_treeCull.lodParamsBuffer) m_tgai.free(m_treeCull.lodParamsBuffer);
+    if (m_treeCull.noOcclusionBuffer) m_tgai.free(m_treeCull.noOcclusionBuffer);
+    m_treeCull.hiZ.reset();
+    for (tga::InputSet set : m_treeCull.pointsSets) m_tgai.free(set);
+    for (tga::InputSet set : m_treeCull.argsSets) m_tgai.free(set);
+    for (tga::InputSet set : m_treeCull.reprojectSets) m_tgai.free(set);
+    for (tga::InputSet set : m_treeCull.retestSets) m_tgai.free(set);
+    for (tga::InputSet set : m_treeCull.nodesSets) m_tgai.free(set);
+    if (m_treeCull.pointsPass) m_tgai.free(m_treeCull.pointsPass);
+    if (m_treeCull.argsPass) m_tgai.free(m_treeCull.argsPass);
+    if (m_treeCull.nodesPass) m_tgai.free(m_treeCull.nodesPass);
+    for (tga::InputSet set : m_pointCull.inputSets) m_tgai.free(set);
+    if (m_pointCull.pass) m_tgai.free(m_pointCull.pass);
+}
+
+void FrustumCuller::record(tga::CommandRecorder& recorder, uint32_t frame) {
+    // The pyramid is built from the previous draw, before the resets below can touch it
+    if (m_treeCull.occlusion) m_treeCull.hiZ->record(recorder, frame, HiZSource::previousFrame);
+
+    // Reset the instance count in the indirect buffer to 0.
+    // The compute shaders atomically increment it for every visible point.
+    uint32_t resetCount = 0;
+    recorder.inlineBufferUpdate(m_pointCloud.getIndirectBuffer(frame), &resetCount, sizeof(uint32_t), offsetof(tga::DrawIndirectCommand, instanceCount));
+
+    if (m_mode == CullingMode::tree) {
+        recordTreeCulling(recorder, frame, false);
+    } else {
+        recordPointCulling(recorder, frame);
+    }
+}
+
+void FrustumCuller::recordReprojected(tga::CommandRecorder& recorder, uint32_t frame) {
+    if (!canReproject()) throw std::logic_error("FrustumCuller was created without framebuffers to reproject");
+
+    // The pyramid marks the gaps the reprojection left in the framebuffer
+    m_treeCull.hiZ->record(recorder, frame, HiZSource::framebuffer);
+
+    uint32_t resetCount = 0;
+    recorder.inlineBufferUpdate(m_pointCloud.getIndirectBuffer(frame), &resetCount, sizeof(uint32_t), offsetof(tga::DrawIndirectCommand, instanceCount));
+    recordTreeCulling(recorder, frame, true);
+}
+
+CullStats FrustumCuller::getStats(uint32_t frame) const {
+    CullStats stats{0, m_pointCloud.getTotalPointCount(), 0, 0, 0};
+    if (m_mode == CullingMode::tree) {
+        std::memcpy(&stats, m_tgai.getMapping(m_treeCull.statsStaging[frame]), sizeof(CullStats));
+    }
+    return stats;
+}
+
+void FrustumCuller::recordPointCulling(tga::CommandRecorder& recorder, uint32_t frame) {
+    // Barrier: Ensure the buffer update finishes before the Compute Shader reads/writes it.
+    recorder.barrier(tga::PipelineStage::Transfer, tga::PipelineStage::ComputeShader);
+
+    recorder.setComputePass(m_pointCull.pass).bindInputSet(m_pointCull.inputSets[frame]);
+
+    // Dispatch Compute Shader
+    // Use helper to handle large point counts that exceed hardware limit (65535) on X-axis.
+    auto [groupSizeX, groupSizeY] = getDispatchDimensions(m_pointCloud.getTotalPointCount());
+    recorder.dispatch(groupSizeX, groupSizeY, 1);
+}
+
+void FrustumCuller::recordTreeCulling(tga::CommandRecorder& recorder, uint32_t frame, bool reprojected) {
+    // Reset the work list length, the counters and the retest list
+    CullWorkListHeader emptyList{};
+    CullStats emptyStats{};
+    uint32_t emptyRetest = 0;
+    recorder.inlineBufferUpdate(m_pointCloud.getCullWorkListBuffer(frame), &emptyList, sizeof(emptyList));
+    recorder.inlineBufferUpdate(m_pointCloud.getCullStatsBuffer(frame), &emptyStats, sizeof(emptyStats));
+    if (m_treeCull.occlusion) recorder.inlineBufferUpdate(m_treeCull.hiZ->getRetestList(frame), &emptyRetest, sizeof(emptyRetest));
+    recorder.barrier(tga::PipelineStage::Transfer, tga::PipelineStage::ComputeShader);
+
+    const std::vector<tga::InputSet>& nodesSets = reprojected ? m_treeCull.reprojectSets : m_treeCull.nodesSets;
+    recordTreePass(recorder, frame, nodesSets[frame], m_pointCloud.getCullCutCount());
+
+    // 4. Re-test the nodes the first pass found occluded, against the pyramid of what it emitted.
+    // Reprojected frames skip covered nodes instead, without deferring any.
+    if (m_treeCull.occlusion && !reprojected) {
+        m_treeCull.hiZ->record(recorder, frame, HiZSource::currentFrame);
+        recorder.inlineBufferUpdate(m_pointCloud.getCullWorkListBuffer(frame), &emptyList, sizeof(emptyList));
+        recorder.barrier(tga::PipelineStage::Transfer, tga::PipelineStage::ComputeShader);
+        recordTreePass(recorder, frame, m_treeCull.retestSets[frame], HIZ_RETEST_CAPACITY);
+    }
+
+    // Read the counters back (available once the frame has completed)
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::Transfer);
+    recorder.bufferDownload(m_pointCloud.getCullStatsBuffer(frame), m_treeCull.statsStaging[frame], sizeof(CullStats));
+}
+
+void FrustumCuller::recordTreePass(tga::CommandRecorder& recorder, uint32_t frame, tga::InputSet nodesSet,
+                                   uint32_t rootCount) {
+    // 1. Walk the hierarchy, one thread per culling subtree
+    auto [nodeGroupsX, nodeGroupsY] = getDispatchDimensions(rootCount);
+    recorder.setComputePass(m_treeCull.nodesPass).bindInputSet(nodesSet);
+    recorder.dispatch(nodeGroupsX, nodeGroupsY, 1);
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+
+    // 2. Size the point pass from the number of emitted ranges
+    recorder.setComputePass(m_treeCull.argsPass).bindInputSet(m_treeCull.argsSets[frame]);
+    recorder.dispatch(1, 1, 1);
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::DrawIndirect);
+
+    // 3. Copy the emitted ranges, testing points only where a leaf straddles the frustum
+    recorder.setComputePass(m_treeCull.pointsPass).bindInputSet(m_treeCull.pointsSets[frame]);
+    recorder.dispatchIndirect(m_pointCloud.getCullDispatchBuffer(frame));
+}
+
+void FrustumCuller::createPointCullingPass(const std::vector<tga::Buffer>& cameraUbos) {
+    PointCloud& pointCloud = m_pointCloud;
+    const bool copyPoints = pointCloud.getCullOutput() == CullOutput::points;
+    tga::Shader cullingShader = tga::loadShader(shaderPath(pointCloud, "cull", SHADER_POINT_FORMAT | SHADER_CULL_OUTPUT), tga::ShaderType::compute, m_tgai);
+
+    // Layout matches shader bindings:
+    // 0: Camera UBO (MVP matrices)
+    // 1: Source SSBO (All points)
+    // 2: Destination SSBO (Visible points, or their indices with --cull-output=indices)
+    // 3: Indirect Buffer (Draw command)
+    // 4: Cull Info UBO (Total point count)
+    // 5: Point Quantization UBO
+    // 6-9: Source and Destination color/intensity streams (SoA only, no destination streams for indices)
+    for (uint32_t frame = 0; frame < pointCloud.getFramesInFlight(); ++frame) {
+        std::vector<tga::BindingLayout> cullBindingLayouts{
+            {tga::BindingType::uniformBuffer},
+            {tga::BindingType::storageBuffer},
+            {tga::BindingType::storageBuffer},
+            {tga::BindingType::storageBuffer},
+            {tga::BindingType::uniformBuffer},
+            {tga::BindingType::uniformBuffer}
+        };
+        std::vector<tga::Binding> cullBindings{
+            {cameraUbos[frame], 0, 0},
+            {pointCloud.getSourceBuffer(), 1, 0},
+            {pointCloud.getCullOutputBuffer(frame), 2, 0},
+            {pointCloud.getIndirectBuffer(frame), 3, 0},
+            {pointCloud.getCullInfoUBO(), 4, 0},
+            {pointCloud.getQuantizationBuffer(), 5, 0}
+        };
+        appendPointStreams(pointCloud, cullBindingLayouts, cullBindings, {pointCloud.getSourcePoints()});
+        if (copyPoints) appendPointStreams(pointCloud, cullBindingLayouts, cullBindings, {pointCloud.getVisiblePoints(frame)});
+
+        // The layout is the same for every frame, only the bound buffers differ
+        if (!m_pointCull.pass) m_pointCull.pass = m_tgai.createComputePass({cullingShader, tga::InputLayout{cullBindingLayouts}});
+        m_pointCull.inputSets.push_back(m_tgai.createInputSet({m_pointCull.pass, cullBindings, 0}));
+    }
+    m_tgai.free(cullingShader);
+}
+
+void FrustumCuller::createTreeCullingPasses(const std::vector<tga::Buffer>& cameraUbos, uint32_t viewportWidth, uint32_t viewportHeight,
+                                            const Config& config, const std::vector<tga::Buffer>& framebuffers) {
+    PointCloud& pointCloud = m_pointCloud;
+    tga::Interface& tgai = m_tgai;
+    const bool copyPoints = pointCloud.getCullOutput() == CullOutput::points;
+
+    // Screen-space-error threshold of the LOD traversal (constant for the session)
+    LODParams lodParams{config.lodPixelThreshold, static_cast<float>(viewportHeight), {0.0f, 0.0f}};
+    m_treeCull.lodParamsBuffer = tgai.createBuffer({
+        tga::BufferUsage::uniform,
+        sizeof(LODParams),
+        tgai.createStagingBuffer({sizeof(LODParams), tga::memoryAccess(lodParams)})
+    });
+
+    // Occlusion culling and reprojection share the pyramids; without occlusion culling, zeroed
+    // parameters disable the Hi-Z test and the retest list of the regular frames
+    m_treeCull.occlusion = config.occlusionCulling;
+    if (m_treeCull.occlusion || !framebuffers.empty()) {
+        m_treeCull.hiZ = std::make_unique<HiZBuffer>(tgai, pointCloud, cameraUbos, viewportWidth, viewportHeight,
+                                                     config.renderMode, framebuffers);
+    }
+    if (!m_treeCull.occlusion) {
+        HiZParams noOcclusion{};
+        m_treeCull.noOcclusionBuffer = tgai.createBuffer({
+            tga::BufferUsage::uniform | tga::BufferUsage::storage,
+            sizeof(HiZParams),
+            tgai.createStagingBuffer({sizeof(HiZParams), tga::memoryAccess(noOcclusion)})
+        });
+    }
+
+    tga::Shader nodesShader = tga::loadShader(shaderPath(pointCloud, "cull_nodes", SHADER_POINT_FORMAT | SHADER_CULL_OUTPUT), tga::ShaderType::compute, tgai);
+    tga::Shader argsShader = tga::loadShader("shaders/cull_args_comp.spv", tga::ShaderType::compute, tgai);
+    tga::Shader pointsShader = tga::loadShader(shaderPath(pointCloud, "cull_points", SHADER_POINT_FORMAT | SHADER_CULL_OUTPUT), tga::ShaderType::compute, tgai);
+
+    // The layouts are the same for every frame, only the bound buffers differ
+    for (uint32_t frame = 0; frame < pointCloud.getFramesInFlight(); ++frame) {
+        // 1. Node traversal
+        // 0: Camera UBO, 1: Nodes, 2: Node bounds, 3: Cut, 4: Work list, 5: Stats,
+        // 6: LOD params, 7: Node proxies, 8: Visible, 9: Indirect draw, 10: Point quantization,
+        // 11: Hi-Z pyramid, 12: Hi-Z params, 13: Retest list, 14: Occlusion pass params,
+        // 15-18: Proxy and visible color/intensity streams (SoA only, no visible streams for indices)
+        std::vector<tga::BindingLayout> l_nodes{
+            {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer},
+            {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer},
+            {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer},
+            {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer},
+            {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}
+        };
+        std::vector<tga::Binding> b_nodes{
+            {cameraUbos[frame], 0}, {pointCloud.getNodesBuffer(), 1}, {pointCloud.getNodeBoundsBuffer(), 2},
+            {pointCloud.getCullCutBuffer(), 3}, {pointCloud.getCullWorkListBuffer(frame), 4}, {pointCloud.getCullStatsBuffer(frame), 5},
+            {m_treeCull.lodParamsBuffer, 6}, {pointCloud.getNodeProxyBuffer(), 7}, {pointCloud.getCullOutputBuffer(frame), 8},
+            {pointCloud.getIndirectBuffer(frame), 9}, {pointCloud.getQuantizationBuffer(), 10},
+            {m_treeCull.occlusion ? m_treeCull.hiZ->getPyramid(frame) : m_treeCull.noOcclusionBuffer, 11},
+            {m_treeCull.occlusion ? m_treeCull.hiZ->getParams() : m_treeCull.noOcclusionBuffer, 12},
+            {m_treeCull.occlusion ? m_treeCull.hiZ->getRetestList(frame) : m_treeCull.noOcclusionBuffer, 13},
+            {m_treeCull.occlusion ? m_treeCull.hiZ->getPassParams(HiZSource::previousFrame) : m_treeCull.noOcclusionBuffer, 14}
+        };
+        appendPointStreams(pointCloud, l_nodes, b_nodes, {pointCloud.getNodeProxies()});
+        if (copyPoints) appendPointStreams(pointCloud, l_nodes, b_nodes, {pointCloud.getVisiblePoints(frame)});
+        if (!m_treeCull.nodesPass) m_treeCull.nodesPass = tgai.createComputePass({nodesShader, tga::InputLayout{l_nodes}});
+        m_treeCull.nodesSets.push_back(tgai.createInputSet({m_treeCull.nodesPass, b_nodes}));
+
+        // Reprojected frames test the pyramid of their framebuffer for gaps
+        if (!framebuffers.empty()) {
+            std::vector<tga::Binding> b_reproject = b_nodes;
+            b_reproject[11] = {m_treeCull.hiZ->getPyramid(frame), 11};
+            b_reproject[12] = {m_treeCull.hiZ->getParams(), 12};
+            b_reproject[13] = {m_treeCull.hiZ->getRetestList(frame), 13};
+            b_reproject[14] = {m_treeCull.hiZ->getPassParams(HiZSource::framebuffer), 14};
+            m_treeCull.reprojectSets.push_back(tgai.createInputSet({m_treeCull.nodesPass, b_reproject}));
+        }
+
+        // The second pass walks from the retest list instead of the cut and drops what is still occluded
+        if (m_treeCull.occlusion) {
+            b_nodes[3] = {m_treeCull.hiZ->getRetestList(frame), 3};
+            b_nodes[14] = {m_treeCull.hiZ->getPassParams(HiZSource::currentFrame), 14};
+            m_treeCull.retestSets.push_back(tgai.createInputSet({m_treeCull.nodesPass, b_nodes}));
+        }
+
+        // 2. Dispatch arguments of the point pass
+        if (!m_treeCull.argsPass) {
+            tga::InputLayout l_args{{
+                {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}
+            }};
+            m_treeCull.argsPass = tgai.createComputePass({argsShader, l_args});
+        }
+        m_treeCull.argsSets.push_back(tgai.createInputSet({m_treeCull.argsPass, {
+            {pointCloud.getCullWorkListBuffer(frame), 0}, {pointCloud.getCullDispatchBuffer(frame), 1}
+        }}));
+
+        // 3. Point ranges
+        // 0: Camera UBO, 1: Source, 2: Visible, 3: Indirect draw, 4: Work list, 5: Stats, 6: Point quantization,
+        // 7-10: Source and visible color/intensity streams (SoA only, no visible streams for indices)
+        std::vector<tga::BindingLayout> l_points{
+            {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer},
+            {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer},
+            {tga::BindingType::uniformBuffer}
+        };
+        std::vector<tga::Binding> b_points{
+            {cameraUbos[frame], 0}, {pointCloud.getSourceBuffer(), 1}, {pointCloud.getCullOutputBuffer(frame), 2},
+            {pointCloud.getIndirectBuffer(frame), 3}, {pointCloud.getCullWorkListBuffer(frame), 4}, {pointCloud.getCullStatsBuffer(frame), 5},
+            {pointCloud.getQuantizationBuffer(), 6}
+        };
+        appendPointStreams(pointCloud, l_points, b_points, {pointCloud.getSourcePoints()});
+        if (copyPoints) appendPointStreams(pointCloud, l_points, b_points, {pointCloud.getVisiblePoints(frame)});
+        if (!m_treeCull.pointsPass) m_treeCull.pointsPass = tgai.createComputePass({pointsShader, tga::InputLayout{l_points}});
+        m_treeCull.pointsSets.push_back(tgai.createInputSet({m_treeCull.pointsPass, b_points}));
+
+        m_treeCull.statsStaging.push_back(tgai.createStagingBuffer({sizeof(CullStats)}));
+    }
+
+    tgai.free(pointsShader);
+    tgai.free(argsShader);
+    tgai.free(nodesShader);
+}
@@ -0,0 +1,86 @@
+#include "GpuUtils.hpp"
+
+std::pair<uint32_t, uint32_t> getDispatchDimensions(size_t numThreads, uint32_t workGroupSize) {
+    if (numThreads == 0) return {0, 0};
+
+    // Standard Vulkan/OpenGL hardware limit for dimension X
+    const uint32_t MAX_DIM_X = 65535;
+
+    // 1. Calculate total workgroups needed (Ceiling Division)
+    // using uint64_t to prevent overflow during calculation before division
+    uint64_t totalGroups = (numThreads + workGroupSize - 1) / workGroupSize;
+
+    // 2. If it fits in one dimension, return (Total, 1)
+    if (totalGroups <= MAX_DIM_X) {
+        return {static_cast<uint32_t>(totalGroups), 1};
+    }
+
+    // 3. Otherwise, fill X completely and spill the remainder to Y
+    uint32_t groupCountX = MAX_DIM_X;
+    auto groupCountY = static_cast<uint32_t>((totalGroups + MAX_DIM_X - 1) / MAX_DIM_X);
+
+    return {groupCountX, groupCountY};
+}
+
+void appendPointStreams(const PointCloud& pointCloud, std::vector<tga::BindingLayout>& layout,
+                        std::vector<tga::Binding>& bindings, std::initializer_list<PointBuffers> pointSets) {
+    if (pointCloud.getPointFormat() != PointFormat::soa) return;
+
+    for (const PointBuffers& points : pointSets) {
+        for (const tga::Buffer& stream : {points.colors, points.intensities}) {
+            bindings.push_back({stream, static_cast<uint32_t>(layout.size())});
+            layout.push_back({tga::BindingType::storageBuffer});
+        }
+    }
+}
+
+namespace {
+
+std::string variantPath(uint32_t mortonBits, PointFormat pointFormat, CullOutput cullOutput,
+                        const std::string& name, uint32_t variants, const std::string& stage) {
+    std::string path = "shaders/" + name;
+    if ((variants & SHADER_MORTON_KEYS) && mortonBits > 32) path += "_64";
+    if (variants & SHADER_POINT_FORMAT) {
+        if (pointFormat == PointFormat::compact) path += "_compact";
+        if (pointFormat == PointFormat::soa) path += "_soa";
+    }
+    if ((variants & SHADER_CULL_OUTPUT) && cullOutput == CullOutput::indices) path += "_indices";
+    return path + "_" + stage + ".spv";
+}
+
+} // namespace
+
+std::string shaderPath(const PointCloud& pointCloud, const std::string& name, uint32_t variants,
+                       const std::string& stage) {
+    return variantPath(pointCloud.getMortonKeyBits(), pointCloud.getPointFormat(), pointCloud.getCullOutput(),
+                       name, variants, stage);
+}
+
+std::string shaderPath(const Config& config, const std::string& name, uint32_t variants, const std::string& stage) {
+    return variantPath(config.mortonBits, config.pointFormat, config.cullOutput, name, variants, stage);
+}
+
+void getPointDrawBindings(const PointCloud& pointCloud, const tga::Buffer& cameraUbo, uint32_t frame,
+                          std::vector<tga::BindingLayout>& layout, std::vector<tga::Binding>& bindings) {
+    layout = {
+        {tga::BindingType::uniformBuffer}, // Camera
+        {tga::BindingType::storageBuffer}, // Points
+        {tga::BindingType::uniformBuffer}, // Point quantization
+    };
+
+    if (pointCloud.getCullOutput() == CullOutput::indices) {
+        // Source points and LOD proxies, addressed through the visible indices
+        layout.push_back({tga::BindingType::storageBuffer}); // Visible indices
+        layout.push_back({tga::BindingType::storageBuffer}); // LOD proxies
+        bindings = {
+            {cameraUbo, 0, 0}, {pointCloud.getSourceBuffer(), 1, 0}, {pointCloud.getQuantizationBuffer(), 2, 0},
+            {pointCloud.getVisibleIndexBuffer(frame), 3, 0}, {pointCloud.getNodeProxyBuffer(), 4, 0}
+        };
+        appendPointStreams(pointCloud, layout, bindings, {pointCloud.getSourcePoints(), pointCloud.getNodeProxies()});
+    } else {
+        bindings = {
+            {cameraUbo, 0, 0}, {pointCloud.getVisibleBuffer(frame), 1, 0}, {pointCloud.getQuantizationBuffer(), 2, 0}
+        };
+        appendPointStreams(pointCloud, layout, bindings, {pointCloud.getVisiblePoints(frame)});
+    }
+}
@@ -0,0 +1,222 @@
+#include "HiZBuffer.hpp"
+#include "GpuUtils.hpp"
+#include "tga/tga_utils.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+HiZBuffer::HiZBuffer(tga::Interface& tgai, const PointCloud& pointCloud, const std::vector<tga::Buffer>& cameraUbos,
+                     uint32_t viewportWidth, uint32_t viewportHeight, RenderMode renderMode,
+                     const std::vector<tga::Buffer>& framebuffers)
+    : m_tgai(tgai) {
+    const uint32_t frameCount = pointCloud.getFramesInFlight();
+    if (cameraUbos.size() != frameCount) {
+        throw std::invalid_argument("HiZBuffer needs one camera buffer per frame in flight");
+    }
+    if (!framebuffers.empty() && framebuffers.size() != frameCount) {
+        throw std::invalid_argument("HiZBuffer needs one framebuffer per frame in flight");
+    }
+
+    // One base texel per pixel, so points only mark what they are drawn to; levels halve
+    // (rounded up) down to a single texel
+    m_params.baseWidth = std::max(1u, viewportWidth);
+    m_params.baseHeight = std::max(1u, viewportHeight);
+    m_params.enabled = 1;
+    m_params.quadSplats = renderMode == RenderMode::quads ? 1 : 0;
+    uint32_t totalTexels = 0;
+    uint32_t width = m_params.baseWidth;
+    uint32_t height = m_params.baseHeight;
+    while (m_params.levelCount < HIZ_MAX_LEVELS) {
+        m_params.levelOffsets[m_params.levelCount++] = totalTexels;
+        m_levelTexels.push_back(width * height);
+        totalTexels += width * height;
+        if (width == 1 && height == 1) break;
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+
+    m_paramsBuffer = tgai.createBuffer({
+        tga::BufferUsage::uniform,
+        sizeof(HiZParams),
+        tgai.createStagingBuffer({sizeof(HiZParams), tga::memoryAccess(m_params)})
+    });
+    for (HiZSource source : {HiZSource::previousFrame, HiZSource::currentFrame, HiZSource::framebuffer}) {
+        // Only the first pass defers occluded nodes; the second pass has the final say, and
+        // reprojected frames skip what the framebuffer already covers
+        OcclusionPassParams pass{source == HiZSource::previousFrame ? HIZ_RETEST_CAPACITY : 0,
+                                 source == HiZSource::framebuffer ? 1u : 0u, {}};
+        m_passParams[static_cast<uint32_t>(source)] = tgai.createBuffer({
+            tga::BufferUsage::uniform,
+            sizeof(OcclusionPassParams),
+            tgai.createStagingBuffer({sizeof(OcclusionPassParams), tga::memoryAccess(pass)})
+        });
+    }
+    for (uint32_t level = 1; level < m_params.levelCount; ++level) {
+        m_levelBuffers.push_back(tgai.createBuffer({
+            tga::BufferUsage::uniform,
+            sizeof(uint32_t),
+            tgai.createStagingBuffer({sizeof(uint32_t), tga::memoryAccess(level)})
+        }));
+    }
+
+    tga::Shader clearShader = tga::loadShader("shaders/hiz_clear_comp.spv", tga::ShaderType::compute, tgai);
+    tga::Shader argsShader = tga::loadShader("shaders/raster_args_comp.spv", tga::ShaderType::compute, tgai);
+    tga::Shader splatShader = tga::loadShader(shaderPath(pointCloud, "hiz_splat", SHADER_POINT_FORMAT | SHADER_CULL_OUTPUT),
+                                              tga::ShaderType::compute, tgai);
+    tga::Shader reduceShader = tga::loadShader("shaders/hiz_reduce_comp.spv", tga::ShaderType::compute, tgai);
+
+    m_clearPass = tgai.createComputePass({clearShader, tga::InputLayout{{
+        {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}
+    }}});
+    m_argsPass = tgai.createComputePass({argsShader, tga::InputLayout{{
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}
+    }}});
+    m_reducePass = tgai.createComputePass({reduceShader, tga::InputLayout{{
+        {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}, {tga::BindingType::uniformBuffer}
+    }}});
+
+    // 0: Camera UBO, 1: Visible points of the source draw (source points with indices), 2: Point quantization,
+    // 3: Indirect draw of the source, 4: Pyramid, 5: Hi-Z params,
+    // 6: Visible indices of the source draw, 7: LOD proxies (--cull-output=indices only)
+    const bool indices = pointCloud.getCullOutput() == CullOutput::indices;
+    std::vector<tga::BindingLayout> l_splat{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer},
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}
+    };
+    if (indices) {
+        l_splat.push_back({tga::BindingType::storageBuffer});
+        l_splat.push_back({tga::BindingType::storageBuffer});
+    }
+    m_splatPass = tgai.createComputePass({splatShader, tga::InputLayout{l_splat}});
+
+    // 0: Pyramid, 1: Hi-Z params, 2: Framebuffer
+    if (!framebuffers.empty()) {
+        tga::Shader framebufferShader = tga::loadShader("shaders/hiz_framebuffer_comp.spv", tga::ShaderType::compute, tgai);
+        m_framebufferPass = tgai.createComputePass({framebufferShader, tga::InputLayout{{
+            {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}
+        }}});
+        tgai.free(framebufferShader);
+    }
+
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        const uint32_t previous = (frame + frameCount - 1) % frameCount;
+        m_pyramids.push_back(tgai.createBuffer({tga::BufferUsage::storage, totalTexels * sizeof(uint32_t)}));
+        m_dispatchArgs.push_back(tgai.createBuffer({
+            tga::BufferUsage::indirect | tga::BufferUsage::storage,
+            sizeof(DispatchIndirectCommand)
+        }));
+
+        m_retestLists.push_back(tgai.createBuffer({
+            tga::BufferUsage::storage,
+            (1 + HIZ_RETEST_CAPACITY) * sizeof(uint32_t)
+        }));
+
+        m_clearSets.push_back(tgai.createInputSet({m_clearPass, {{m_pyramids[frame], 0}, {m_paramsBuffer, 1}}}));
+
+        // Per HiZSource: the draw of the frame before, or the one the first culling pass built
+        std::array<tga::InputSet, 2> argsSets{};
+        std::array<tga::InputSet, 2> splatSets{};
+        for (size_t slot = 0; slot < 2; ++slot) {
+            const uint32_t source = slot == static_cast<size_t>(HiZSource::currentFrame) ? frame : previous;
+            argsSets[slot] = tgai.createInputSet({m_argsPass, {
+                {pointCloud.getIndirectBuffer(source), 0}, {m_dispatchArgs[frame], 1}
+            }});
+
+            std::vector<tga::Binding> b_splat{
+                {cameraUbos[frame], 0}, {indices ? pointCloud.getSourceBuffer() : pointCloud.getVisibleBuffer(source), 1},
+                {pointCloud.getQuantizationBuffer(), 2}, {pointCloud.getIndirectBuffer(source), 3},
+                {m_pyramids[frame], 4}, {m_paramsBuffer, 5}
+            };
+            if (indices) {
+                b_splat.push_back({pointCloud.getVisibleIndexBuffer(source), 6});
+                b_splat.push_back({pointCloud.getNodeProxyBuffer(), 7});
+            }
+            splatSets[slot] = tgai.createInputSet({m_splatPass, b_splat});
+        }
+        m_argsSets.push_back(argsSets);
+        m_splatSets.push_back(splatSets);
+
+        if (m_framebufferPass) {
+            m_framebufferSets.push_back(tgai.createInputSet({m_framebufferPass, {
+                {m_pyramids[frame], 0}, {m_paramsBuffer, 1}, {framebuffers[frame], 2}
+            }}));
+        }
+
+        std::vector<tga::InputSet> reduceSets;
+        for (const tga::Buffer& levelBuffer : m_levelBuffers) {
+            reduceSets.push_back(tgai.createInputSet({m_reducePass, {
+                {m_pyramids[frame], 0}, {m_paramsBuffer, 1}, {levelBuffer, 2}
+            }}));
+        }
+        m_reduceSets.push_back(std::move(reduceSets));
+    }
+
+    tgai.free(reduceShader);
+    tgai.free(splatShader);
+    tgai.free(argsShader);
+    tgai.free(clearShader);
+}
+
+HiZBuffer::~HiZBuffer() {
+    for (const std::vector<tga::InputSet>& sets : m_reduceSets) {
+        for (tga::InputSet set : sets) m_tgai.free(set);
+    }
+    for (tga::InputSet set : m_framebufferSets) m_tgai.free(set);
+    for (const std::array<tga::InputSet, 2>& sets : m_splatSets) {
+        for (tga::InputSet set : sets) m_tgai.free(set);
+    }
+    for (const std::array<tga::InputSet, 2>& sets : m_argsSets) {
+        for (tga::InputSet set : sets) m_tgai.free(set);
+    }
+    for (tga::InputSet set : m_clearSets) m_tgai.free(set);
+    if (m_framebufferPass) m_tgai.free(m_framebufferPass);
+    if (m_reducePass) m_tgai.free(m_reducePass);
+    if (m_splatPass) m_tgai.free(m_splatPass);
+    if (m_argsPass) m_tgai.free(m_argsPass);
+    if (m_clearPass) m_tgai.free(m_clearPass);
+    for (tga::Buffer buffer : m_retestLists) m_tgai.free(buffer);
+    for (tga::Buffer buffer : m_dispatchArgs) m_tgai.free(buffer);
+    for (tga::Buffer buffer : m_pyramids) m_tgai.free(buffer);
+    for (tga::Buffer buffer : m_levelBuffers) m_tgai.free(buffer);
+    for (tga::Buffer buffer : m_passParams) {
+        if (buffer) m_tgai.free(buffer);
+    }
+    if (m_paramsBuffer) m_tgai.free(m_paramsBuffer);
+}
+
+void HiZBuffer::record(tga::CommandRecorder& recorder, uint32_t frame, HiZSource source) {
+    // The camera update and the culling (and drawing) of the source must be complete
+    recorder.barrier(tga::PipelineStage::Transfer, tga::PipelineStage::ComputeShader);
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+
+    auto [baseGroupsX, baseGroupsY] = getDispatchDimensions(m_levelTexels[0]);
+    if (source == HiZSource::framebuffer) {
+        // 1-2. The depth of the reprojected framebuffer, its gaps marked empty
+        recorder.setComputePass(m_framebufferPass).bindInputSet(m_framebufferSets[frame]);
+        recorder.dispatch(baseGroupsX, baseGroupsY, 1);
+    } else {
+        // 1. Reset the base level and size the splat from the source draw
+        const auto slot = static_cast<uint32_t>(source);
+        recorder.setComputePass(m_clearPass).bindInputSet(m_clearSets[frame]);
+        recorder.dispatch(baseGroupsX, baseGroupsY, 1);
+        recorder.setComputePass(m_argsPass).bindInputSet(m_argsSets[frame][slot]);
+        recorder.dispatch(1, 1, 1);
+        recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+        recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::DrawIndirect);
+
+        // 2. Nearest depth of the drawn footprint of every source point, seen from the current camera
+        recorder.setComputePass(m_splatPass).bindInputSet(m_splatSets[frame][slot]);
+        recorder.dispatchIndirect(m_dispatchArgs[frame]);
+    }
+
+    // 3. Farthest depth per texel of every coarser level
+    for (uint32_t level = 1; level < m_params.levelCount; ++level) {
+        recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+        auto [groupsX, groupsY] = getDispatchDimensions(m_levelTexels[level]);
+        recorder.setComputePass(m_reducePass).bindInputSet(m_reduceSets[frame][level - 1]);
+        recorder.dispatch(groupsX, groupsY, 1);
+    }
+
+    // The culling reads the pyramid and then overwrites (or, after the first pass, appends to) the outputs read above
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::Transfer);
+}
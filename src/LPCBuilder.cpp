@@ -0,0 +1,510 @@
+#include "LPCBuilder.hpp"
+#include "CpuLPCBuilder.hpp"
+#include "GpuUtils.hpp"
+#include "tga/tga_utils.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+
+LPCBuilder::LPCBuilder(tga::Interface& tgai, PointCloud& pointCloud, const Config& config)
+    : m_tgai(tgai), m_pointCloud(pointCloud), m_sortAlgorithm(config.sortAlgorithm) {
+    // Every point may be its own voxel, so the tree is built at that size and compacted by build()
+    pointCloud.createBuildScratch();
+    pointCloud.createTreeBuffers(static_cast<uint32_t>(pointCloud.getTotalPointCount()));
+
+    // 1. Morton
+    // tga::Shader s_morton = loadCompShader("shaders/octree/1_morton.spv");
+    tga::Shader mortonComputeShader = tga::loadShader(shaderPath(pointCloud, "1_morton", SHADER_MORTON_KEYS | SHADER_POINT_FORMAT), tga::ShaderType::compute, tgai);
+    tga::InputLayout l_morton{{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer},
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}
+    }};
+    m_passes.mortonPass = tgai.createComputePass({mortonComputeShader, l_morton});
+    m_sets.mortonSet = tgai.createInputSet({m_passes.mortonPass, {
+        {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getSourceBuffer(), 1},
+        {pointCloud.getMortonCodesBuffer(), 2}, {pointCloud.getSortIndicesBuffer(), 3},
+        {pointCloud.getQuantizationBuffer(), 4}
+    }});
+
+    // 2. Bitonic
+    tga::Shader bitonicSortComputeShader = tga::loadShader(shaderPath(pointCloud, "2_bitonic_sort", SHADER_MORTON_KEYS), tga::ShaderType::compute, tgai);
+    tga::InputLayout l_bitonic{{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}
+    }};
+    m_passes.bitonicSortPass = tgai.createComputePass({bitonicSortComputeShader, l_bitonic});
+    m_sets.bitonicSortSet = tgai.createInputSet({m_passes.bitonicSortPass, {
+        {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getMortonCodesBuffer(), 1},
+        {pointCloud.getSortIndicesBuffer(), 2}, {pointCloud.getBitonicParamsBuffer(), 3}
+    }});
+
+    // 2. Radix Sort (upsweep, scan, scatter)
+    tga::Shader radixUpsweepComputeShader = tga::loadShader(shaderPath(pointCloud, "2_radix_upsweep", SHADER_MORTON_KEYS), tga::ShaderType::compute, tgai);
+    tga::InputLayout l_radixUpsweep{{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer},
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}
+    }};
+    m_passes.radixUpsweepPass = tgai.createComputePass({radixUpsweepComputeShader, l_radixUpsweep});
+
+    tga::Shader radixScanComputeShader = tga::loadShader("shaders/2_radix_scan_comp.spv", tga::ShaderType::compute, tgai);
+    tga::InputLayout l_radixScan{{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::uniformBuffer},
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}
+    }};
+    m_passes.radixScanPass = tgai.createComputePass({radixScanComputeShader, l_radixScan});
+    m_sets.radixScanSet = tgai.createInputSet({m_passes.radixScanPass, {
+        {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getRadixParamsBuffer(), 1},
+        {pointCloud.getRadixTileHistogramBuffer(), 2}, {pointCloud.getRadixGlobalHistogramBuffer(), 3}
+    }});
+
+    tga::Shader radixScatterComputeShader = tga::loadShader(shaderPath(pointCloud, "2_radix_scatter", SHADER_MORTON_KEYS), tga::ShaderType::compute, tgai);
+    tga::InputLayout l_radixScatter{{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::uniformBuffer},
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer},
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer},
+        {tga::BindingType::storageBuffer}
+    }};
+    m_passes.radixScatterPass = tgai.createComputePass({radixScatterComputeShader, l_radixScatter});
+
+    // Ping-pong: even passes read the primary buffers, odd passes the alternate ones
+    const std::array<tga::Buffer, 2> codes{pointCloud.getMortonCodesBuffer(), pointCloud.getMortonCodesAltBuffer()};
+    const std::array<tga::Buffer, 2> indices{pointCloud.getSortIndicesBuffer(), pointCloud.getSortIndicesAltBuffer()};
+    for (size_t src = 0; src < 2; ++src) {
+        size_t dst = 1 - src;
+        m_sets.radixUpsweepSets[src] = tgai.createInputSet({m_passes.radixUpsweepPass, {
+            {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getRadixParamsBuffer(), 1}, {codes[src], 2},
+            {pointCloud.getRadixTileHistogramBuffer(), 3}, {pointCloud.getRadixGlobalHistogramBuffer(), 4}
+        }});
+        m_sets.radixScatterSets[src] = tgai.createInputSet({m_passes.radixScatterPass, {
+            {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getRadixParamsBuffer(), 1},
+            {codes[src], 2}, {indices[src], 3}, {codes[dst], 4}, {indices[dst], 5},
+            {pointCloud.getRadixTileHistogramBuffer(), 6}
+        }});
+    }
+
+    // 3. Reorder
+    tga::Shader reorderComputeShader = tga::loadShader(shaderPath(pointCloud, "3_reorder", SHADER_POINT_FORMAT), tga::ShaderType::compute, tgai);
+    std::vector<tga::BindingLayout> l_reorder{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer},
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}
+    };
+    std::vector<tga::Binding> b_reorder{
+        {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getSourceBuffer(), 1},
+        {pointCloud.getSortIndicesBuffer(), 2}, {pointCloud.getVisibleBuffer(), 3}, // Using Visible as temp dst
+        {pointCloud.getQuantizationBuffer(), 4}
+    };
+    appendPointStreams(pointCloud, l_reorder, b_reorder, {pointCloud.getSourcePoints(), pointCloud.getVisiblePoints()});
+    m_passes.reorderPass = tgai.createComputePass({reorderComputeShader, tga::InputLayout{l_reorder}});
+    m_sets.reorderSet = tgai.createInputSet({m_passes.reorderPass, b_reorder});
+
+    // 4. Mark Heads
+    tga::Shader markHeadsComputeShader = tga::loadShader(shaderPath(pointCloud, "4_mark_heads", SHADER_MORTON_KEYS), tga::ShaderType::compute, tgai);
+    tga::InputLayout l_mark{{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}
+    }};
+    m_passes.markHeadsPass = tgai.createComputePass({markHeadsComputeShader, l_mark});
+    m_sets.markHeadsSet = tgai.createInputSet({m_passes.markHeadsPass, {
+        {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getMortonCodesBuffer(), 1},
+        {pointCloud.getHeadFlagsBuffer(), 2}
+    }});
+
+    // 4b. Head Flag Scan (reduce, partials, downsweep)
+    tga::Shader scanReduceComputeShader = tga::loadShader("shaders/4_scan_reduce_comp.spv", tga::ShaderType::compute, tgai);
+    tga::InputLayout l_scanReduce{{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}
+    }};
+    m_passes.scanReducePass = tgai.createComputePass({scanReduceComputeShader, l_scanReduce});
+    m_sets.scanReduceSet = tgai.createInputSet({m_passes.scanReducePass, {
+        {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getHeadFlagsBuffer(), 1},
+        {pointCloud.getScanBlockSumsBuffer(), 2}
+    }});
+
+    // The LPC uniforms are bound as storage here so the partials pass can write numUnique
+    tga::Shader scanPartialsComputeShader = tga::loadShader("shaders/4_scan_partials_comp.spv", tga::ShaderType::compute, tgai);
+    tga::InputLayout l_scanPartials{{
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}
+    }};
+    m_passes.scanPartialsPass = tgai.createComputePass({scanPartialsComputeShader, l_scanPartials});
+    m_sets.scanPartialsSet = tgai.createInputSet({m_passes.scanPartialsPass, {
+        {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getScanBlockSumsBuffer(), 1}
+    }});
+
+    tga::Shader scanDownsweepComputeShader = tga::loadShader("shaders/4_scan_downsweep_comp.spv", tga::ShaderType::compute, tgai);
+    tga::InputLayout l_scanDownsweep{{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer},
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}
+    }};
+    m_passes.scanDownsweepPass = tgai.createComputePass({scanDownsweepComputeShader, l_scanDownsweep});
+    m_sets.scanDownsweepSet = tgai.createInputSet({m_passes.scanDownsweepPass, {
+        {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getHeadFlagsBuffer(), 1},
+        {pointCloud.getScanBlockSumsBuffer(), 2}, {pointCloud.getScannedIndicesBuffer(), 3}
+    }});
+
+    // 4c. Dispatch Arguments for the numUnique-sized stages
+    tga::Shader dispatchArgsComputeShader = tga::loadShader("shaders/5_dispatch_args_comp.spv", tga::ShaderType::compute, tgai);
+    tga::InputLayout l_dispatchArgs{{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}
+    }};
+    m_passes.dispatchArgsPass = tgai.createComputePass({dispatchArgsComputeShader, l_dispatchArgs});
+    m_sets.dispatchArgsSet = tgai.createInputSet({m_passes.dispatchArgsPass, {
+        {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getLPCDispatchBuffer(), 1}
+    }});
+
+    // 5. Scatter
+    tga::Shader scatterComputeShader = tga::loadShader(shaderPath(pointCloud, "5_scatter", SHADER_MORTON_KEYS), tga::ShaderType::compute, tgai);
+    tga::InputLayout l_scatter{
+        {
+            {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer},
+            {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}
+        }};
+    m_passes.scatterPass = tgai.createComputePass({scatterComputeShader, l_scatter});
+    m_sets.scatterSet = tgai.createInputSet({m_passes.scatterPass, {
+    {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getMortonCodesBuffer(), 1},
+    {pointCloud.getHeadFlagsBuffer(), 2}, {pointCloud.getScannedIndicesBuffer(), 3},
+    {pointCloud.getUniqueCodesBuffer(), 4}, {pointCloud.getVoxelStartsBuffer(), 5}}
+    });
+
+    // 6. Init Leaves
+    tga::Shader initLeavesComputeShader = tga::loadShader(shaderPath(pointCloud, "6_init_leaves", SHADER_MORTON_KEYS), tga::ShaderType::compute, tgai);
+    tga::InputLayout l_initLeaves{
+        {
+            {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer},
+            {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}
+        }};
+    m_passes.initLeavesPass = tgai.createComputePass({initLeavesComputeShader, l_initLeaves});
+    m_sets.initLeavesSet = tgai.createInputSet({m_passes.initLeavesPass, {
+    {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getUniqueCodesBuffer(), 1},
+        {pointCloud.getVoxelStartsBuffer(), 2}, {pointCloud.getNodesBuffer(), 3}
+    }});
+
+    tga::Shader buildInternalComputeShader = tga::loadShader(shaderPath(pointCloud, "7_build_internal", SHADER_MORTON_KEYS), tga::ShaderType::compute, tgai);
+    tga::InputLayout l_buildInternal{
+        {
+            {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer},
+        }};
+    m_passes.buildInternalPass = tgai.createComputePass({buildInternalComputeShader, l_buildInternal});
+    m_sets.buildInternalSet = tgai.createInputSet({m_passes.buildInternalPass, {
+    {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getUniqueCodesBuffer(), 1}, {pointCloud.getNodesBuffer(), 2}
+    }});
+
+    // 8. Refit Leaves (the sorted points are still in the visible buffer during the build)
+    tga::Shader refitLeavesComputeShader = tga::loadShader(shaderPath(pointCloud, "8_refit_leaves", SHADER_POINT_FORMAT), tga::ShaderType::compute, tgai);
+    std::vector<tga::BindingLayout> l_refitLeaves{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer},
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer},
+        {tga::BindingType::uniformBuffer}
+    };
+    std::vector<tga::Binding> b_refitLeaves{
+        {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getVisibleBuffer(), 1}, {pointCloud.getNodesBuffer(), 2},
+        {pointCloud.getNodeBoundsBuffer(), 3}, {pointCloud.getRefitFlagsBuffer(), 4}, {pointCloud.getNodeProxyBuffer(), 5},
+        {pointCloud.getQuantizationBuffer(), 6}
+    };
+    appendPointStreams(pointCloud, l_refitLeaves, b_refitLeaves, {pointCloud.getVisiblePoints(), pointCloud.getNodeProxies()});
+    m_passes.refitLeavesPass = tgai.createComputePass({refitLeavesComputeShader, tga::InputLayout{l_refitLeaves}});
+    m_sets.refitLeavesSet = tgai.createInputSet({m_passes.refitLeavesPass, b_refitLeaves});
+
+    // 9. Refit Internal
+    tga::Shader refitInternalComputeShader = tga::loadShader(shaderPath(pointCloud, "9_refit_internal", SHADER_POINT_FORMAT), tga::ShaderType::compute, tgai);
+    std::vector<tga::BindingLayout> l_refitInternal{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer},
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}
+    };
+    std::vector<tga::Binding> b_refitInternal{
+        {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getNodesBuffer(), 1},
+        {pointCloud.getNodeBoundsBuffer(), 2}, {pointCloud.getRefitFlagsBuffer(), 3}, {pointCloud.getNodeProxyBuffer(), 4},
+        {pointCloud.getQuantizationBuffer(), 5}
+    };
+    appendPointStreams(pointCloud, l_refitInternal, b_refitInternal, {pointCloud.getNodeProxies()});
+    m_passes.refitInternalPass = tgai.createComputePass({refitInternalComputeShader, tga::InputLayout{l_refitInternal}});
+    m_sets.refitInternalSet = tgai.createInputSet({m_passes.refitInternalPass, b_refitInternal});
+
+    // 10. Culling Cut
+    tga::Shader cullCutComputeShader = tga::loadShader(shaderPath(pointCloud, "10_cull_cut", SHADER_MORTON_KEYS), tga::ShaderType::compute, tgai);
+    tga::InputLayout l_cullCut{{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}
+    }};
+    m_passes.cullCutPass = tgai.createComputePass({cullCutComputeShader, l_cullCut});
+    m_sets.cullCutSet = tgai.createInputSet({m_passes.cullCutPass, {
+        {pointCloud.getLPCUniformsBuffer(), 0}, {pointCloud.getNodesBuffer(), 1}, {pointCloud.getCullCutBuffer(), 2}
+    }});
+
+    for (tga::Shader shader : {mortonComputeShader, bitonicSortComputeShader, radixUpsweepComputeShader, radixScanComputeShader,
+                               radixScatterComputeShader, reorderComputeShader, markHeadsComputeShader, scanReduceComputeShader,
+                               scanPartialsComputeShader, scanDownsweepComputeShader, dispatchArgsComputeShader,
+                               scatterComputeShader, initLeavesComputeShader, buildInternalComputeShader,
+                               refitLeavesComputeShader, refitInternalComputeShader, cullCutComputeShader}) {
+        tgai.free(shader);
+    }
+}
+
+LPCBuilder::~LPCBuilder() {
+    for (tga::InputSet set : {m_sets.mortonSet, m_sets.bitonicSortSet, m_sets.radixUpsweepSets[0], m_sets.radixUpsweepSets[1],
+                              m_sets.radixScanSet, m_sets.radixScatterSets[0], m_sets.radixScatterSets[1], m_sets.reorderSet,
+                              m_sets.markHeadsSet, m_sets.scanReduceSet, m_sets.scanPartialsSet, m_sets.scanDownsweepSet,
+                              m_sets.dispatchArgsSet, m_sets.scatterSet, m_sets.initLeavesSet, m_sets.buildInternalSet,
+                              m_sets.refitLeavesSet, m_sets.refitInternalSet, m_sets.cullCutSet}) {
+        if (set) m_tgai.free(set);
+    }
+    for (tga::ComputePass pass : {m_passes.mortonPass, m_passes.bitonicSortPass, m_passes.radixUpsweepPass,
+                                  m_passes.radixScanPass, m_passes.radixScatterPass, m_passes.reorderPass,
+                                  m_passes.markHeadsPass, m_passes.scanReducePass, m_passes.scanPartialsPass,
+                                  m_passes.scanDownsweepPass, m_passes.dispatchArgsPass, m_passes.scatterPass,
+                                  m_passes.initLeavesPass, m_passes.buildInternalPass, m_passes.refitLeavesPass,
+                                  m_passes.refitInternalPass, m_passes.cullCutPass}) {
+        if (pass) m_tgai.free(pass);
+    }
+}
+
+void LPCBuilder::build(std::vector<LPCStageTiming>* timings) {
+    std::cout << "--- Building Layered Point Cloud (" << m_pointCloud.getMortonKeyBits() << "-bit Morton keys) ---" << std::endl;
+    uint32_t numPoints = m_pointCloud.getTotalPointCount();
+    auto dims = getDispatchDimensions(numPoints);
+    auto scanDims = getDispatchDimensions(m_pointCloud.getScanBlockCount(), 1);
+
+    // The whole build is recorded into one command buffer. numUnique is produced
+    // by the GPU scan and sizes the tree stages through indirect dispatches; the
+    // host reads it back only once the build has finished, to compact the tree.
+    // When timings are requested, every stage is submitted and waited for on its own.
+    LPCUniforms result{};
+    tga::StagingBuffer stageResult = m_tgai.createStagingBuffer({sizeof(LPCUniforms)});
+    uint32_t cutCount = 0;
+    tga::StagingBuffer stageCutCount = m_tgai.createStagingBuffer({sizeof(uint32_t)});
+
+    tga::CommandBuffer cmd{};
+    {
+        std::optional<tga::CommandRecorder> rec;
+        rec.emplace(m_tgai, cmd);
+        auto endStage = [&](const char* stage) {
+            if (!timings) return;
+            cmd = rec->endRecording();
+            auto start = std::chrono::steady_clock::now();
+            m_tgai.execute(cmd);
+            m_tgai.waitForCompletion(cmd);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            timings->push_back({stage, elapsed.count()});
+            rec.emplace(m_tgai, cmd);
+        };
+
+        // The cut pass appends to its list, so its count starts at zero
+        rec->inlineBufferUpdate(m_pointCloud.getCullCutBuffer(), &cutCount, sizeof(uint32_t));
+        rec->barrier(tga::PipelineStage::Transfer, tga::PipelineStage::ComputeShader);
+
+        // 1. Morton
+        std::cout << "- Computing Morton codes " << std::endl;
+        rec->setComputePass(m_passes.mortonPass).bindInputSet(m_sets.mortonSet);
+        rec->dispatch(dims.first, dims.second, 1);
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+        endStage("morton");
+
+        // 2. Sort
+        std::cout << "- Sorting Morton codes ("
+                  << (m_sortAlgorithm == SortAlgorithm::radix ? "radix" : "bitonic") << ")" << std::endl;
+        if (m_sortAlgorithm == SortAlgorithm::radix) {
+            recordRadixSort(*rec, numPoints);
+        } else {
+            recordBitonicSort(*rec, numPoints);
+        }
+        endStage("sort");
+
+        // 3. Reorder
+        std::cout << "- Reordering Morton codes" << std::endl;
+        rec->setComputePass(m_passes.reorderPass).bindInputSet(m_sets.reorderSet);
+        rec->dispatch(dims.first, dims.second, 1);
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+        endStage("reorder");
+
+        // 4. Mark Heads
+        std::cout << "- Marking Heads" << std::endl;
+        rec->setComputePass(m_passes.markHeadsPass).bindInputSet(m_sets.markHeadsSet);
+        rec->dispatch(dims.first, dims.second, 1);
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+        endStage("mark_heads");
+
+        // 4b. Exclusive scan of the head flags (reduce, scan block sums, downsweep).
+        // The partials pass also writes numUnique into the LPC uniforms.
+        std::cout << "- Scanning head flags" << std::endl;
+        rec->setComputePass(m_passes.scanReducePass).bindInputSet(m_sets.scanReduceSet);
+        rec->dispatch(scanDims.first, scanDims.second, 1);
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+
+        rec->setComputePass(m_passes.scanPartialsPass).bindInputSet(m_sets.scanPartialsSet);
+        rec->dispatch(1, 1, 1);
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+
+        rec->setComputePass(m_passes.scanDownsweepPass).bindInputSet(m_sets.scanDownsweepSet);
+        rec->dispatch(scanDims.first, scanDims.second, 1);
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+
+        // 4c. Size the tree stages from numUnique
+        rec->setComputePass(m_passes.dispatchArgsPass).bindInputSet(m_sets.dispatchArgsSet);
+        rec->dispatch(1, 1, 1);
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::DrawIndirect);
+        endStage("scan");
+
+        // 5. Scatter
+        std::cout << "- Scattering unique codes" << std::endl;
+        rec->setComputePass(m_passes.scatterPass).bindInputSet(m_sets.scatterSet);
+        rec->dispatch(dims.first, dims.second, 1);
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+        endStage("scatter");
+
+        // 6. Init Leaves
+        std::cout << "- Initializing leaves" << std::endl;
+        rec->setComputePass(m_passes.initLeavesPass).bindInputSet(m_sets.initLeavesSet);
+        rec->dispatchIndirect(m_pointCloud.getLPCDispatchBuffer(), LPC_DISPATCH_LEAVES * sizeof(DispatchIndirectCommand));
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+        endStage("init_leaves");
+
+        // 7. Build Internal
+        std::cout << "- Building internal nodes" << std::endl;
+        rec->setComputePass(m_passes.buildInternalPass).bindInputSet(m_sets.buildInternalSet);
+        rec->dispatchIndirect(m_pointCloud.getLPCDispatchBuffer(), LPC_DISPATCH_INTERNAL * sizeof(DispatchIndirectCommand));
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+        endStage("build_internal");
+
+        // 8./9. Refit: leaf bounds and proxies from their points, then a bottom-up
+        // climb where the second child to arrive merges them into its parent
+        std::cout << "- Refitting node bounds" << std::endl;
+        rec->setComputePass(m_passes.refitLeavesPass).bindInputSet(m_sets.refitLeavesSet);
+        rec->dispatchIndirect(m_pointCloud.getLPCDispatchBuffer(), LPC_DISPATCH_LEAVES * sizeof(DispatchIndirectCommand));
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+
+        rec->setComputePass(m_passes.refitInternalPass).bindInputSet(m_sets.refitInternalSet);
+        rec->dispatchIndirect(m_pointCloud.getLPCDispatchBuffer(), LPC_DISPATCH_LEAVES * sizeof(DispatchIndirectCommand));
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+        endStage("refit");
+
+        // 10. Culling Cut: the roots of the subtrees walked by cull_nodes
+        std::cout << "- Selecting culling subtrees" << std::endl;
+        rec->setComputePass(m_passes.cullCutPass).bindInputSet(m_sets.cullCutSet);
+        rec->dispatchIndirect(m_pointCloud.getLPCDispatchBuffer(), LPC_DISPATCH_NODES * sizeof(DispatchIndirectCommand));
+        rec->barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::Transfer);
+        endStage("cull_cut");
+
+        // Read back the uniforms to learn numUnique on the host
+        rec->bufferDownload(m_pointCloud.getLPCUniformsBuffer(), stageResult, sizeof(LPCUniforms));
+        rec->bufferDownload(m_pointCloud.getCullCutBuffer(), stageCutCount, sizeof(uint32_t));
+        rec->barrier(tga::PipelineStage::Transfer, tga::PipelineStage::VertexShader);
+
+        cmd = rec->endRecording();
+        m_tgai.execute(cmd);
+        m_tgai.waitForCompletion(cmd);
+        m_tgai.free(cmd);
+    }
+
+    std::memcpy(&result, m_tgai.getMapping(stageResult), sizeof(LPCUniforms));
+    m_tgai.free(stageResult);
+    std::memcpy(&cutCount, m_tgai.getMapping(stageCutCount), sizeof(uint32_t));
+    m_tgai.free(stageCutCount);
+    m_pointCloud.setCullCutCount(cutCount);
+
+    // Node point ranges index the sorted order, so make it the source of culling and rendering
+    m_pointCloud.swapSortedPoints();
+
+    // With the scratch released, move the tree into buffers sized for numUnique
+    auto start = std::chrono::steady_clock::now();
+    m_pointCloud.compactTreeBuffers(result.numUnique);
+    if (timings) {
+        timings->push_back({"compact", std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count()});
+    }
+
+    std::cout << "FINISHED! " << numPoints << " points in " << result.numUnique << " voxels, "
+              << cutCount << " culling subtrees" << std::endl;
+}
+
+void LPCBuilder::recordRadixSort(tga::CommandRecorder& rec, uint32_t numPoints) {
+    if (numPoints == 0) return;
+
+    const uint32_t numTiles = m_pointCloud.getRadixTileCount();
+    auto tileDims = getDispatchDimensions(numTiles, 1);
+
+    // Every pass accumulates into its own slice of the global histogram, so one clear suffices
+    const uint32_t numPasses = m_pointCloud.getRadixPassCount();
+    std::array<uint32_t, RADIX_SORT_MAX_PASSES * RADIX_SORT_BINS> zeros{};
+    rec.inlineBufferUpdate(m_pointCloud.getRadixGlobalHistogramBuffer(), zeros.data(), numPasses * RADIX_SORT_BINS * sizeof(uint32_t));
+
+    for (uint32_t pass = 0; pass < numPasses; ++pass) {
+        const size_t src = pass % 2;
+        RadixSortParams params{pass * RADIX_SORT_BITS, pass, numTiles};
+
+        // A. Update the per-pass parameters once the previous pass stopped reading them
+        rec.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::Transfer);
+        rec.inlineBufferUpdate(m_pointCloud.getRadixParamsBuffer(), &params, sizeof(params));
+        rec.barrier(tga::PipelineStage::Transfer, tga::PipelineStage::ComputeShader);
+
+        // B. Upsweep: per-tile digit counts
+        rec.setComputePass(m_passes.radixUpsweepPass).bindInputSet(m_sets.radixUpsweepSets[src]);
+        rec.dispatch(tileDims.first, tileDims.second, 1);
+        rec.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+
+        // C. Scan: one workgroup per digit turns the counts into scatter offsets
+        rec.setComputePass(m_passes.radixScanPass).bindInputSet(m_sets.radixScanSet);
+        rec.dispatch(RADIX_SORT_BINS, 1, 1);
+        rec.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+
+        // D. Stable scatter into the other buffer pair
+        rec.setComputePass(m_passes.radixScatterPass).bindInputSet(m_sets.radixScatterSets[src]);
+        rec.dispatch(tileDims.first, tileDims.second, 1);
+        rec.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+    }
+}
+
+void LPCBuilder::recordBitonicSort(tga::CommandRecorder& rec, uint32_t numPoints) {
+    auto dims = getDispatchDimensions(numPoints);
+
+    uint32_t pot = 1;
+    while(pot < numPoints) pot <<= 1;
+
+    struct SortParams { uint32_t j, k; };
+
+    for (uint32_t k = 2; k <= pot; k <<= 1) {
+        for (uint32_t j = k >> 1; j > 0; j >>= 1) {
+            SortParams p{j, k};
+
+            // A. Update the UBO with current stage parameters
+            rec.inlineBufferUpdate(m_pointCloud.getBitonicParamsBuffer(), &p, sizeof(p));
+
+            // B. Barrier: Ensure Transfer (Update) completes before Compute reads UBO
+            rec.barrier(tga::PipelineStage::Transfer, tga::PipelineStage::ComputeShader);
+
+            // C. Dispatch Sort Step
+            rec.setComputePass(m_passes.bitonicSortPass).bindInputSet(m_sets.bitonicSortSet);
+            rec.dispatch(dims.first, dims.second, 1);
+
+            // D. Barrier:
+            // 1. Compute -> Compute: Ensure sorting of this step finishes before next step reads data
+            // 2. Compute -> Transfer: Ensure shader is done reading 'j,k' before we overwrite them in next loop
+            rec.barrier(tga::PipelineStage::ComputeShader,
+                        tga::PipelineStage::ComputeShader);
+        }
+    }
+}
+
+void buildLayeredPointCloud(tga::Interface& tgai, PointCloud& pointCloud, const Config& config,
+                            std::vector<LPCStageTiming>* timings) {
+    switch (config.buildBackend) {
+        case BuildBackend::gpu:
+            LPCBuilder(tgai, pointCloud, config).build(timings);
+            break;
+        case BuildBackend::cpu: {
+            LPCHierarchy lpc = CpuLPCBuilder(pointCloud).build(timings);
+            auto start = std::chrono::steady_clock::now();
+            pointCloud.uploadLPC(lpc);
+            if (timings) {
+                timings->push_back({"upload", std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start).count()});
+            }
+            break;
+        }
+        case BuildBackend::validate: {
+            LPCHierarchy reference = CpuLPCBuilder(pointCloud).build();
+            LPCBuilder(tgai, pointCloud, config).build(timings);
+            if (!validateLPC(pointCloud, reference, config.sortAlgorithm == SortAlgorithm::radix)) {
+                throw std::runtime_error("The GPU LPC build differs from the CPU reference");
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,184 @@
+#include "LasSource.hpp"
+#include "ThreadPool.hpp"
+
+#include <pdal/PointTable.hpp>
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/Options.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#include <iostream>
+
+namespace {
+
+/// Points converted per task of the thread pool, bounds the per-thread scratch memory.
+constexpr size_t LAS_CHUNK_SIZE = 1 << 16;
+
+/// Packed record of the X/Y/Z dimensions as returned by PointRef::getPackedData.
+struct LasPosition {
+    double x, y, z;
+};
+
+/// Packed record of all dimensions the loader reads.
+struct LasRecord {
+    double x, y, z;
+    uint16_t red, green, blue, intensity;
+};
+static_assert(sizeof(LasPosition) == 3 * sizeof(double), "LasPosition must match the packed dimension layout");
+static_assert(sizeof(LasRecord) == 3 * sizeof(double) + 4 * sizeof(uint16_t), "LasRecord must match the packed dimension layout");
+
+/// Dimensions of a LasPosition, in record order.
+const pdal::DimTypeList& lasPositionDims() {
+    static const pdal::DimTypeList dims{
+        {pdal::Dimension::Id::X, pdal::Dimension::Type::Double},
+        {pdal::Dimension::Id::Y, pdal::Dimension::Type::Double},
+        {pdal::Dimension::Id::Z, pdal::Dimension::Type::Double}
+    };
+    return dims;
+}
+
+/// Dimensions of a LasRecord, in record order.
+const pdal::DimTypeList& lasRecordDims() {
+    static const pdal::DimTypeList dims{
+        {pdal::Dimension::Id::X, pdal::Dimension::Type::Double},
+        {pdal::Dimension::Id::Y, pdal::Dimension::Type::Double},
+        {pdal::Dimension::Id::Z, pdal::Dimension::Type::Double},
+        {pdal::Dimension::Id::Red, pdal::Dimension::Type::Unsigned16},
+        {pdal::Dimension::Id::Green, pdal::Dimension::Type::Unsigned16},
+        {pdal::Dimension::Id::Blue, pdal::Dimension::Type::Unsigned16},
+        {pdal::Dimension::Id::Intensity, pdal::Dimension::Type::Unsigned16}
+    };
+    return dims;
+}
+
+/// Viewer axes of a LAS position: Z up becomes Y up, Y is inverted.
+glm::dvec3 toViewerAxes(double x, double y, double z) {
+    return {x, z, -y};
+}
+
+AABB emptyBounds() {
+    return {glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())};
+}
+
+/**
+ * @brief Converts raw LAS records into viewer-space attributes and grows the bounds by them.
+ *
+ * Positions are remapped to viewer axes and shifted by the origin in double
+ * precision. Colors and intensities are normalized from 16 bit to [0, 1].
+ */
+void convertRecords(const LasRecord* records, size_t count, const glm::dvec3& origin,
+                    glm::vec3* positions, glm::vec3* colors, float* intensities, AABB& bounds) {
+    for (size_t k = 0; k < count; ++k) {
+        positions[k] = glm::vec3(toViewerAxes(records[k].x, records[k].y, records[k].z) - origin);
+    }
+
+    constexpr float toUnit = 1.0f / 65535.0f;
+    for (size_t k = 0; k < count; ++k) {
+        colors[k] = glm::vec3(records[k].red, records[k].green, records[k].blue) * toUnit;
+        intensities[k] = static_cast<float>(records[k].intensity) * toUnit;
+    }
+
+    for (size_t k = 0; k < count; ++k) {
+        bounds.min = glm::min(bounds.min, positions[k]);
+        bounds.max = glm::max(bounds.max, positions[k]);
+    }
+}
+
+/**
+ * @brief Streaming table that hands every filled chunk to a callback before PDAL overwrites it.
+ */
+class ChunkedPointTable : public pdal::FixedPointTable {
+public:
+    using ChunkHandler = std::function<void(pdal::BasePointTable& table, size_t count)>;
+
+    ChunkedPointTable(size_t capacity, ChunkHandler handler)
+        : pdal::FixedPointTable(capacity), m_handler(std::move(handler)) {}
+
+    void reset() override {
+        if (numPoints() > 0) m_handler(*this, numPoints());
+        pdal::FixedPointTable::reset();
+    }
+
+private:
+    ChunkHandler m_handler;
+};
+
+pdal::Stage* createReader(pdal::StageFactory& factory, const std::string& path) {
+    pdal::Options options;
+    options.add("filename", path);
+    pdal::Stage* reader = factory.createStage("readers.las");
+    if (!reader) throw std::runtime_error("PDAL has no LAS reader for " + path);
+    reader->setOptions(options);
+    return reader;
+}
+
+} // namespace
+
+LasSource::LasSource(const std::string& path) : m_path(path) {
+    pdal::StageFactory factory;
+    pdal::Stage* reader = createReader(factory, path);
+
+    // The normalization needs the bounds before the first point is converted:
+    // take them from the header, scan the file once without keeping points otherwise
+    pdal::QuickInfo header = reader->preview();
+    if (header.valid() && !header.m_bounds.empty()) {
+        m_bounds.min = toViewerAxes(header.m_bounds.minx, header.m_bounds.maxy, header.m_bounds.minz);
+        m_bounds.max = toViewerAxes(header.m_bounds.maxx, header.m_bounds.miny, header.m_bounds.maxz);
+        m_pointCount = header.m_pointCount;
+        return;
+    }
+
+    std::cout << "No bounds in the LAS header of " << path << ", scanning the file first" << std::endl;
+    ChunkedPointTable scanTable(STREAM_CHUNK_SIZE, [&](pdal::BasePointTable& table, size_t count) {
+        for (size_t idx = 0; idx < count; ++idx) {
+            LasPosition r;
+            pdal::PointRef(table, idx).getPackedData(lasPositionDims(), reinterpret_cast<char*>(&r));
+            glm::dvec3 position = toViewerAxes(r.x, r.y, r.z);
+            m_bounds.min = glm::min(m_bounds.min, position);
+            m_bounds.max = glm::max(m_bounds.max, position);
+        }
+        m_pointCount += count;
+    });
+    reader->prepare(scanTable);
+    reader->execute(scanTable);
+}
+
+void LasSource::read(const glm::dvec3& origin, const BatchFn& fn) {
+    pdal::StageFactory factory;
+    pdal::Stage* reader = createReader(factory, m_path);
+
+    // Chunk-sized scratch and the workers, reused for every chunk
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    ThreadPool pool(static_cast<unsigned>(std::clamp<size_t>(STREAM_CHUNK_SIZE / LAS_CHUNK_SIZE, 1, hardware)));
+    PointAttributes batch;
+    batch.resize(STREAM_CHUNK_SIZE);
+    std::vector<AABB> threadBounds(pool.size());
+
+    ChunkedPointTable table(STREAM_CHUNK_SIZE, [&](pdal::BasePointTable& chunkTable, size_t count) {
+        std::fill(threadBounds.begin(), threadBounds.end(), emptyBounds());
+        pool.parallelFor(count, LAS_CHUNK_SIZE, [&](unsigned thread, size_t begin, size_t end) {
+            std::vector<LasRecord> records(end - begin);
+            for (size_t k = 0; k < records.size(); ++k) {
+                pdal::PointRef(chunkTable, begin + k).getPackedData(lasRecordDims(), reinterpret_cast<char*>(&records[k]));
+            }
+
+            convertRecords(records.data(), records.size(), origin,
+                           batch.positions.data() + begin, batch.colors.data() + begin,
+                           batch.intensities.data() + begin, threadBounds[thread]);
+        });
+
+        AABB batchBounds = emptyBounds();
+        for (const AABB& bounds : threadBounds) {
+            batchBounds.min = glm::min(batchBounds.min, bounds.min);
+            batchBounds.max = glm::max(batchBounds.max, bounds.max);
+        }
+        fn(batch, count, batchBounds);
+    });
+    reader->prepare(table);
+    reader->execute(table);
+}
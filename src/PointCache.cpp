@@ -0,0 +1,139 @@
+#include "PointCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t HASH_SAMPLE_SIZE = 64 * 1024; ///< Bytes hashed per sampled block of the source.
+constexpr uint64_t HASH_SAMPLE_COUNT = 32;     ///< Sampled blocks, the first and the last included.
+
+uint64_t fnv1a(const uint8_t* data, size_t size, uint64_t hash) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+bool isPointCachePath(const std::string& path) {
+    return std::filesystem::path(path).extension() == ".pspire";
+}
+
+PointCacheKey computePointCacheKey(const std::vector<std::string>& sourcePaths) {
+    // Sizes add up and the hashes are chained in input order
+    PointCacheKey key;
+    key.contentHash = FNV_OFFSET_BASIS;
+    for (const std::string& sourcePath : sourcePaths) {
+        PointCacheKey fileKey = computePointCacheKey(sourcePath, key.contentHash);
+        if (fileKey == PointCacheKey{}) return {};
+        key.fileSize += fileKey.fileSize;
+        key.contentHash = fileKey.contentHash;
+    }
+    return key;
+}
+
+PointCacheKey computePointCacheKey(const std::string& sourcePath, uint64_t seed) {
+    PointCacheKey key;
+    std::error_code error;
+    key.fileSize = std::filesystem::file_size(sourcePath, error);
+    if (error) return {};
+
+    // Blocks are spread evenly between the first and the last one, overlapping for small files
+    std::ifstream file(sourcePath, std::ios::binary);
+    std::vector<uint8_t> sample(std::min<uint64_t>(HASH_SAMPLE_SIZE, key.fileSize));
+    const uint64_t lastOffset = key.fileSize - sample.size();
+    key.contentHash = seed;
+    for (uint64_t i = 0; i < HASH_SAMPLE_COUNT; ++i) {
+        file.seekg(static_cast<std::streamoff>(lastOffset * i / (HASH_SAMPLE_COUNT - 1)));
+        file.read(reinterpret_cast<char*>(sample.data()), static_cast<std::streamsize>(sample.size()));
+        key.contentHash = fnv1a(sample.data(), sample.size(), key.contentHash);
+    }
+    if (!file) return {};
+
+    return key;
+}
+
+std::unique_ptr<PointCache> PointCache::open(const std::string& path, const std::optional<PointCacheKey>& key,
+                                             PointFormat pointFormat, uint32_t mortonBits) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(PointCacheHeader)) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file alive
+    if (mapping == MAP_FAILED) return nullptr;
+
+    std::unique_ptr<PointCache> cache(new PointCache(static_cast<const uint8_t*>(mapping), size));
+    const PointCacheHeader& header = cache->getHeader();
+    const PointCacheHeader expected;
+
+    bool valid = std::memcmp(header.magic, expected.magic, sizeof(expected.magic)) == 0 &&
+                 header.version == POINT_CACHE_VERSION &&
+                 (!key || header.key == *key) &&
+                 header.pointFormat == static_cast<uint32_t>(pointFormat) &&
+                 header.mortonBits == mortonBits;
+    for (const PointCacheHeader::Section& section : header.sections) {
+        valid = valid && section.offset <= size && section.size <= size - section.offset;
+    }
+    if (!valid) return nullptr;
+
+    // Sections are read front to back exactly once during the upload
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    return cache;
+}
+
+PointCache::~PointCache() {
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+}
+
+std::span<const uint8_t> PointCache::getSection(CacheSection section) const {
+    const PointCacheHeader::Section& range = getHeader().sections[static_cast<size_t>(section)];
+    return {m_data + range.offset, static_cast<size_t>(range.size)};
+}
+
+PointCacheWriter::PointCacheWriter(const std::string& path)
+    : m_path(path), m_file(path, std::ios::binary | std::ios::trunc) {
+    if (!m_file) throw std::runtime_error("Cannot create point cache: " + path);
+
+    // Placeholder, replaced by finish() once all sections are known
+    PointCacheHeader placeholder;
+    std::memset(placeholder.magic, 0, sizeof(placeholder.magic));
+    m_file.write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+}
+
+void PointCacheWriter::writeSection(CacheSection section, const void* data, size_t size) {
+    // Pad to the section alignment
+    static const char padding[POINT_CACHE_ALIGNMENT] = {};
+    size_t offset = static_cast<size_t>(m_file.tellp());
+    size_t aligned = (offset + POINT_CACHE_ALIGNMENT - 1) / POINT_CACHE_ALIGNMENT * POINT_CACHE_ALIGNMENT;
+    m_file.write(padding, static_cast<std::streamsize>(aligned - offset));
+    m_file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    if (!m_file) throw std::runtime_error("Failed writing point cache: " + m_path);
+
+    m_sections[static_cast<size_t>(section)] = {aligned, size};
+}
+
+void PointCacheWriter::finish(PointCacheHeader header) {
+    std::copy(std::begin(m_sections), std::end(m_sections), std::begin(header.sections));
+    m_file.seekp(0);
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.close();
+    if (!m_file) throw std::runtime_error("Failed writing point cache: " + m_path);
+}
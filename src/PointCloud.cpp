@@ -1,53 +1,258 @@
 #include "PointCloud.hpp"
+#include "CpuLPCBuilder.hpp"
+#include "GpuUtils.hpp"
+#include "PointCache.hpp"
+#include "PointSource.hpp"
+#include "ThreadPool.hpp"
+#include "UploadService.hpp"
 
 #include <tga/tga_utils.hpp>
+#include <glm/gtc/packing.hpp>
 
-#include <pdal/PointTable.hpp>
-#include <pdal/PointView.hpp>
-#include <pdal/StageFactory.hpp>
-#include <pdal/Options.hpp>
-
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <limits>
+#include <optional>
+#include <stdexcept>
+#include <thread>
 
 #include <iostream>
 
-PointCloud::PointCloud(tga::Interface &tgai) : m_tgai(tgai) {
-    // Load the default asset
-    loadLAS("assets/neuschwanstein/3DRM_Neuschwanstein.las");
+namespace {
 
-    if (m_points.empty()) return;
+uint32_t unorm8(float value) {
+    return static_cast<uint32_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
 
-    size_t dataSize = m_points.size() * sizeof(Point);
+uint32_t unorm16(float value) {
+    return static_cast<uint32_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
 
-    // Create the Source Buffer.
-    // This buffer contains the complete dataset and is read-only for the compute shader.
-    m_pointBuffer = tgai.createBuffer({
-        tga::BufferUsage::storage,
-        dataSize,
-        tgai.createStagingBuffer({dataSize, reinterpret_cast<uint8_t*>(m_points.data())})
-    });
+AABB emptyBounds() {
+    return {glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())};
+}
 
-    // Create the Visible Buffer.
-    // This buffer is written to by the compute shader and read by the vertex shader.
-    // It is allocated to match the source size to handle the worst-case scenario (all points visible).
-    m_visiblePointBuffer = tgai.createBuffer({
-        tga::BufferUsage::storage,
-        dataSize
-    });
+/// Points encoded per task of the thread pool while streaming.
+constexpr size_t ENCODE_CHUNK_SIZE = 1 << 16;
 
-    // Initialize the Indirect Draw Command.
-    // vertexCount = 6 (for a quad), instanceCount = 0 (reset/filled by compute shader).
-    tga::DrawIndirectCommand cmd{6, 0, 0, 0};
+unsigned encodeThreadCount(size_t pointCount) {
+    size_t chunkCount = (pointCount + ENCODE_CHUNK_SIZE - 1) / ENCODE_CHUNK_SIZE;
+    size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    return static_cast<unsigned>(std::clamp<size_t>(chunkCount, 1, hardware));
+}
 
-    m_indirectDrawBuffer = tgai.createBuffer({
-        tga::BufferUsage::indirect | tga::BufferUsage::storage,
-        sizeof(tga::DrawIndirectCommand),
-        tgai.createStagingBuffer({sizeof(cmd), reinterpret_cast<uint8_t*>(&cmd)})
+void growBounds(AABB& bounds, const AABB& other) {
+    bounds.min = glm::min(bounds.min, other.min);
+    bounds.max = glm::max(bounds.max, other.max);
+}
+
+} // namespace
+
+PointQuantization computePointQuantization(const AABB& bounds) {
+    // Quantization grid of the compact format: the cloud bounds in 2^21 - 1 steps per axis
+    const float quantizationMax = static_cast<float>((1u << POINT_QUANTIZATION_BITS) - 1u);
+    glm::vec3 extent = bounds.max - bounds.min;
+    PointQuantization quantization{};
+    quantization.origin = bounds.min;
+    quantization.step = extent / quantizationMax;
+    for (int axis = 0; axis < 3; ++axis) {
+        quantization.invStep[axis] = extent[axis] > 0.0f ? quantizationMax / extent[axis] : 0.0f;
+    }
+    return quantization;
+}
+
+std::array<size_t, 3> getPointStreamStrides(PointFormat format) {
+    switch (format) {
+        case PointFormat::compact: return {sizeof(CompactPoint), 0, 0};
+        case PointFormat::soa: return {SOA_POSITION_SIZE, SOA_COLOR_SIZE, SOA_INTENSITY_SIZE};
+        default: return {sizeof(Point), 0, 0};
+    }
+}
+
+glm::uvec3 quantizePointPosition(const PointQuantization& quantization, const glm::vec3& position) {
+    const float quantizationMax = static_cast<float>((1u << POINT_QUANTIZATION_BITS) - 1u);
+    glm::vec3 scaled = glm::round((position - quantization.origin) * quantization.invStep);
+    return glm::uvec3(glm::clamp(scaled, 0.0f, quantizationMax));
+}
+
+void encodePointRange(PointFormat format, const PointQuantization& quantization, const PointAttributes& attributes,
+                      size_t begin, size_t count, const std::array<uint8_t*, 3>& streams, const float* splatSizes) {
+    const size_t end = begin + count;
+    auto splatSize = [&](size_t i) { return splatSizes ? splatSizes[i] : 0.0f; };
+    switch (format) {
+        case PointFormat::full: {
+            Point* points = reinterpret_cast<Point*>(streams[0]);
+            for (size_t i = begin; i < end; ++i) {
+                points[i] = Point{attributes.positions[i], splatSize(i), attributes.colors[i], attributes.intensities[i]};
+            }
+            break;
+        }
+        case PointFormat::compact: {
+            // Quantized to the cloud bounds, the splat size as a half float
+            CompactPoint* packed = reinterpret_cast<CompactPoint*>(streams[0]);
+            for (size_t i = begin; i < end; ++i) {
+                const glm::vec3& color = attributes.colors[i];
+                glm::uvec3 q = quantizePointPosition(quantization, attributes.positions[i]);
+
+                packed[i].positionLow = q.x | (q.y << 21);
+                packed[i].positionHigh = (q.y >> 11) | (q.z << 10);
+                packed[i].color = unorm8(color.x) | (unorm8(color.y) << 8) | (unorm8(color.z) << 16) | (255u << 24);
+                packed[i].intensitySplat = unorm16(attributes.intensities[i]) |
+                                           (static_cast<uint32_t>(glm::packHalf1x16(splatSize(i))) << 16);
+            }
+            break;
+        }
+        case PointFormat::soa: {
+            glm::vec4* positions = reinterpret_cast<glm::vec4*>(streams[0]);
+            uint32_t* colors = reinterpret_cast<uint32_t*>(streams[1]);
+            float* intensities = reinterpret_cast<float*>(streams[2]);
+            for (size_t i = begin; i < end; ++i) {
+                const glm::vec3& color = attributes.colors[i];
+                positions[i] = glm::vec4(attributes.positions[i], splatSize(i));
+                colors[2 * i] = unorm16(color.x) | (unorm16(color.y) << 16);
+                colors[2 * i + 1] = unorm16(color.z) | (0xFFFFu << 16);
+                intensities[i] = attributes.intensities[i];
+            }
+            break;
+        }
+    }
+}
+
+PointCloud::PointCloud(tga::Interface &tgai, const Config& config)
+    : m_tgai(tgai), m_mortonBits(config.mortonBits), m_pointFormat(config.pointFormat), m_cullOutput(config.cullOutput),
+      m_frames(config.framesInFlight) {
+    // Load the inputs (the default asset unless --input is given)
+    m_sourcePaths = config.inputPaths;
+    if (config.cacheMode != CacheMode::off) {
+        m_cachePath = config.cachePath.empty()
+            ? std::filesystem::path(m_sourcePaths.front()).replace_extension(".pspire").string()
+            : config.cachePath;
+    }
+    if (config.cacheMode == CacheMode::on) {
+        // A cache given as the input, or one whose sources are not around, is trusted as is
+        const bool cacheInput = isPointCachePath(m_sourcePaths.front());
+        std::optional<PointCacheKey> key;
+        if (!cacheInput) key = computePointCacheKey(m_sourcePaths);
+        const bool sourcesMissing = key && *key == PointCacheKey{};
+        if (sourcesMissing) key.reset();
+        m_cache = PointCache::open(m_cachePath, key, m_pointFormat, m_mortonBits);
+        if (m_cache && sourcesMissing) {
+            std::cout << "Inputs not readable, restoring " << m_cachePath << " without checking its source" << std::endl;
+        }
+        if (cacheInput && !m_cache) {
+            throw std::runtime_error("Cannot restore " + m_cachePath +
+                                     ": not a point cache of this version, --point-format and --morton-bits");
+        }
+    }
+
+    if (m_cache) {
+        // The cache holds the built hierarchy, its sections are uploaded once all buffers exist
+        const PointCacheHeader& header = m_cache->getHeader();
+        std::cout << "--- Loading Cache: " << m_cachePath << " ---" << std::endl;
+        m_pointCount = header.numPoints;
+        m_bounds = header.bounds;
+        m_quantization = header.quantization;
+        m_sourcePoints = createPointBuffers(m_pointCount, false);
+    } else if (config.loadMode == LoadMode::stream) {
+        // Creates the source buffers and quantization while reading
+        streamPoints(*openPointSources(m_sourcePaths));
+    } else {
+        loadPoints(*openPointSources(m_sourcePaths));
+        computeQuantization(m_bounds);
+
+        // Create the Source Buffer.
+        // This buffer contains the complete dataset and is read-only for the compute shader.
+        if (m_pointCount > 0) m_sourcePoints = createPointBuffers(m_pointCount, true);
+    }
+
+    createBuffers();
+}
+
+PointCloud::PointCloud(tga::Interface& tgai, PointAttributes points, const Config& config)
+    : m_tgai(tgai), m_attributes(std::move(points)), m_mortonBits(config.mortonBits), m_pointFormat(config.pointFormat),
+      m_cullOutput(config.cullOutput), m_frames(config.framesInFlight) {
+    m_pointCount = m_attributes.size();
+    m_bounds = emptyBounds();
+    for (const glm::vec3& position : m_attributes.positions) {
+        m_bounds.min = glm::min(m_bounds.min, position);
+        m_bounds.max = glm::max(m_bounds.max, position);
+    }
+    computeQuantization(m_bounds);
+    if (m_pointCount > 0) m_sourcePoints = createPointBuffers(m_pointCount, true);
+
+    createBuffers();
+}
+
+void PointCloud::createBuffers() {
+    if (m_pointCount == 0) return;
+    tga::Interface& tgai = m_tgai;
+
+    // Visible indices address up to 2 * numPoints nodes below VISIBLE_PROXY_BIT
+    if (m_cullOutput == CullOutput::indices && 2 * m_pointCount > VISIBLE_PROXY_BIT) {
+        throw std::runtime_error("--cull-output=indices supports at most 2^30 points");
+    }
+
+    m_quantizationBuffer = tgai.createBuffer({
+        tga::BufferUsage::uniform,
+        sizeof(PointQuantization),
+        tgai.createStagingBuffer({sizeof(PointQuantization), tga::memoryAccess(m_quantization)})
     });
 
+    std::cout << "Point format: " << getPointSize() << " bytes per point, "
+              << m_pointCount * getPointSize() / (1024 * 1024) << " MiB, "
+              << m_frames.size() << (m_cullOutput == CullOutput::indices ? " visible index buffer(s)" : " visible buffer(s)")
+              << std::endl;
+
+    for (FrameBuffers& frame : m_frames) {
+        if (m_cullOutput == CullOutput::indices) {
+            // Create the Visible Index Buffer.
+            // One index per visible point or LOD proxy; a proxy replaces at least two points,
+            // so the point count still bounds the worst case, at 4 bytes instead of a whole point.
+            frame.visibleIndices = tgai.createBuffer({
+                tga::BufferUsage::storage,
+                m_pointCount * sizeof(uint32_t)
+            });
+        } else {
+            // Create the Visible Buffer.
+            // This buffer is written to by the compute shader and read by the vertex shader.
+            // It is allocated to match the source size to handle the worst-case scenario (all points visible).
+            frame.visiblePoints = createPointBuffers(m_pointCount, false);
+        }
+
+        // Initialize the Indirect Draw Command.
+        // vertexCount = 6 (for a quad), instanceCount = 0 (reset/filled by compute shader).
+        tga::DrawIndirectCommand cmd{6, 0, 0, 0};
+
+        frame.indirectDraw = tgai.createBuffer({
+            tga::BufferUsage::indirect | tga::BufferUsage::storage,
+            sizeof(tga::DrawIndirectCommand),
+            tgai.createStagingBuffer({sizeof(cmd), reinterpret_cast<uint8_t*>(&cmd)})
+        });
+
+        // Every emitted range is a leaf or a fully visible node, split into chunks.
+        // Leaves are disjoint, so numUnique + numPoints / CULL_CHUNK_SIZE items always suffice.
+        size_t maxWorkItems = m_pointCount + m_pointCount / CULL_CHUNK_SIZE + 1;
+        frame.cullWorkList = tgai.createBuffer({
+            tga::BufferUsage::storage,
+            sizeof(CullWorkListHeader) + maxWorkItems * sizeof(CullWorkItem)
+        });
+
+        frame.cullDispatch = tgai.createBuffer({
+            tga::BufferUsage::indirect | tga::BufferUsage::storage,
+            sizeof(DispatchIndirectCommand)
+        });
+
+        frame.cullStats = tgai.createBuffer({
+            tga::BufferUsage::storage,
+            sizeof(CullStats)
+        });
+    }
+
     // Create the Point Count Uniform Buffer.
     // Used by the compute shader to perform bounds checking on the dispatch index.
-    uint32_t totalCount = static_cast<uint32_t>(m_points.size());
+    uint32_t totalCount = static_cast<uint32_t>(m_pointCount);
 
     tga::StagingBufferInfo stagingInfo{
         sizeof(uint32_t),
@@ -60,169 +265,505 @@ PointCloud::PointCloud(tga::Interface &tgai) : m_tgai(tgai) {
         m_tgai.createStagingBuffer(stagingInfo)
     });
 
-    // Morton Codes (uint)
+    // Indirect dispatch arguments of the numUnique-sized stages, filled on the GPU
+    m_lpcDispatchBuffer = tgai.createBuffer({
+        tga::BufferUsage::indirect | tga::BufferUsage::storage,
+        LPC_DISPATCH_COUNT * sizeof(DispatchIndirectCommand)
+    });
+
+    // Set up LPC uniforms
+    // numUnique starts at 0 and is written on the GPU by the scan, hence the storage usage.
+    LPCUniforms lpcUniforms = {m_bounds, static_cast<uint32_t>(m_pointCount), 0, computeMortonScale(m_bounds)};
+    m_lpcUniformsBuffer = tgai.createBuffer({
+        tga::BufferUsage::uniform | tga::BufferUsage::storage,
+        sizeof(LPCUniforms),
+        tgai.createStagingBuffer({sizeof(LPCUniforms), tga::memoryAccess(lpcUniforms)})});
+
+    if (m_cache) uploadCache();
+}
+
+void PointCloud::createBuildScratch() {
+    if (m_pointCount == 0) return;
+    tga::Interface& tgai = m_tgai;
+
+    // The GPU build reorders the points into the visible buffer of frame 0, with
+    // --cull-output=indices it exists only for the build
+    if (m_cullOutput == CullOutput::indices) m_frames[0].visiblePoints = createPointBuffers(m_pointCount, false);
+
+    // Morton Codes (uint, or uvec2 for 63-bit keys)
     m_mortonCodesBuffer = tgai.createBuffer({
         tga::BufferUsage::storage,
-        m_points.size() * sizeof(uint32_t)
+        m_pointCount * getMortonKeySize()
     });
 
-    // Sort Indices (uint)
+    // Sort Indices (uint), reused for the scanned indices once the reorder has read them
     m_sortIndicesBuffer = tgai.createBuffer({
         tga::BufferUsage::storage,
-        m_points.size() * sizeof(uint32_t)
+        m_pointCount * sizeof(uint32_t)
     });
 
-    m_bitonicParamsBuffer = tgai.createBuffer({
-    tga::BufferUsage::uniform,
-    2 * sizeof(uint32_t) // j, k
+    // Radix sort scratch: ping-pong key/value buffers and the digit histograms.
+    // The alternate indices are free after the sort and hold the head flags, then the refit counters.
+    m_mortonCodesAltBuffer = tgai.createBuffer({
+        tga::BufferUsage::storage,
+        m_pointCount * getMortonKeySize()
+    });
+
+    m_sortIndicesAltBuffer = tgai.createBuffer({
+        tga::BufferUsage::storage,
+        m_pointCount * sizeof(uint32_t)
+    });
+
+    m_radixTileHistogramBuffer = tgai.createBuffer({
+        tga::BufferUsage::storage,
+        static_cast<size_t>(getRadixTileCount()) * RADIX_SORT_BINS * sizeof(uint32_t)
     });
 
-    // Head Flags (uint) - Needs TransferSrc for CPU download
-    m_headFlagsBuffer = tgai.createBuffer({
+    m_radixGlobalHistogramBuffer = tgai.createBuffer({
         tga::BufferUsage::storage,
-        m_points.size() * sizeof(uint32_t)
+        RADIX_SORT_MAX_PASSES * RADIX_SORT_BINS * sizeof(uint32_t)
+    });
+
+    m_radixParamsBuffer = tgai.createBuffer({
+        tga::BufferUsage::uniform,
+        sizeof(RadixSortParams)
+    });
+
+    m_bitonicParamsBuffer = tgai.createBuffer({
+        tga::BufferUsage::uniform,
+        2 * sizeof(uint32_t) // j, k
     });
 
-    m_scannedIndicesBuffer = tgai.createBuffer({
+    m_scanBlockSumsBuffer = tgai.createBuffer({
         tga::BufferUsage::storage,
-        m_points.size() * sizeof(uint32_t)
+        static_cast<size_t>(getScanBlockCount()) * sizeof(uint32_t)
     });
 
+    size_t bytes = m_pointCount * (2 * getMortonKeySize() + 2 * sizeof(uint32_t)) +
+                   (static_cast<size_t>(getRadixTileCount()) * RADIX_SORT_BINS + getScanBlockCount()) * sizeof(uint32_t);
+    if (m_cullOutput == CullOutput::indices) bytes += m_pointCount * getPointSize();
+    std::cout << "LPC build scratch: " << bytes / (1024 * 1024) << " MiB" << std::endl;
+}
+
+void PointCloud::createTreeBuffers(uint32_t numUnique) {
+    m_numUnique = numUnique;
+    releaseTreeBuffers();
+    if (m_pointCount == 0) return;
+    tga::Interface& tgai = m_tgai;
+
+    // Every buffer is sized for numUnique leaves (at least one, so none is empty)
+    const size_t leafCount = std::max<size_t>(numUnique, 1);
+    const size_t nodeCount = 2 * leafCount - 1;
+
     m_uniqueCodesBuffer = tgai.createBuffer({
         tga::BufferUsage::storage,
-        m_points.size() * sizeof(uint32_t)
+        leafCount * getMortonKeySize()
     });
 
     m_voxelStartsBuffer = tgai.createBuffer({
         tga::BufferUsage::storage,
-        m_points.size() * sizeof(uint32_t)
+        leafCount * sizeof(uint32_t)
     });
 
-    // TODO optimize to make as small as possible
+    // numUnique - 1 internal nodes followed by numUnique leaves
     m_nodesBuffer = tgai.createBuffer({
         tga::BufferUsage::storage,
-        2 * m_points.size() * sizeof(Node)
+        nodeCount * sizeof(Node)
     });
 
-    // Set up LPC uniforms
-    /// TODO initialize the number of cells in the index correctly!
-    LPCUniforms lpcUniforms = {m_bounds, static_cast<uint32_t>(m_points.size()), 0};
-    m_lpcUniformsBuffer = tgai.createBuffer({
-        tga::BufferUsage::uniform,
-        sizeof(LPCUniforms),
-        tgai.createStagingBuffer({sizeof(LPCUniforms), tga::memoryAccess(lpcUniforms)})});
+    // Per-node bounds, indexed like the nodes
+    m_nodeBoundsBuffer = tgai.createBuffer({
+        tga::BufferUsage::storage,
+        nodeCount * sizeof(AABB)
+    });
+
+    // Averaged representative point of every node, drawn by the LOD traversal
+    m_nodeProxies = createPointBuffers(nodeCount, false);
+
+    // Culling subtree roots: a count followed by at most numUnique node indices
+    m_cullCutBuffer = tgai.createBuffer({
+        tga::BufferUsage::storage,
+        (1 + leafCount) * sizeof(uint32_t)
+    });
+
+    const size_t bytes = leafCount * (getMortonKeySize() + 2 * sizeof(uint32_t)) +
+                         nodeCount * (sizeof(Node) + sizeof(AABB) + getPointSize()) + sizeof(uint32_t);
+    std::cout << "LPC tree: " << bytes / (1024 * 1024) << " MiB for " << numUnique << " voxels" << std::endl;
+}
+
+void PointCloud::compactTreeBuffers(uint32_t numUnique) {
+    // The sections are sized from m_numUnique and the cut count, so they only cover the used part
+    m_numUnique = numUnique;
+    if (m_pointCount == 0 || numUnique == m_pointCount) return;
+
+    std::vector<std::vector<uint8_t>> contents(POINT_CACHE_SECTION_COUNT);
+    for (CacheSection section : {CacheSection::uniqueCodes, CacheSection::voxelStarts, CacheSection::nodes,
+                                 CacheSection::nodeBounds, CacheSection::proxyPoints, CacheSection::proxyColors,
+                                 CacheSection::proxyIntensities, CacheSection::cullCut}) {
+        contents[static_cast<size_t>(section)] = downloadSection(section);
+    }
+
+    createTreeBuffers(numUnique);
+    uploadSections(std::vector<std::span<const uint8_t>>(contents.begin(), contents.end()));
 }
 
 PointCloud::~PointCloud() {
-    if (m_pointBuffer) m_tgai.free(m_pointBuffer);
-    if (m_visiblePointBuffer) m_tgai.free(m_visiblePointBuffer);
-    if (m_indirectDrawBuffer) m_tgai.free(m_indirectDrawBuffer);
+    releaseBuildScratch();
+    releaseTreeBuffers();
+    freePointBuffers(m_sourcePoints);
+    for (FrameBuffers& frame : m_frames) {
+        freePointBuffers(frame.visiblePoints);
+        if (frame.visibleIndices) m_tgai.free(frame.visibleIndices);
+        if (frame.indirectDraw) m_tgai.free(frame.indirectDraw);
+        if (frame.cullWorkList) m_tgai.free(frame.cullWorkList);
+        if (frame.cullDispatch) m_tgai.free(frame.cullDispatch);
+        if (frame.cullStats) m_tgai.free(frame.cullStats);
+    }
     if (m_pointCountBuffer) m_tgai.free(m_pointCountBuffer);
-    if (m_mortonCodesBuffer) m_tgai.free(m_mortonCodesBuffer);
-    if (m_sortIndicesBuffer) m_tgai.free(m_sortIndicesBuffer);
     if (m_lpcUniformsBuffer) m_tgai.free(m_lpcUniformsBuffer);
-    if (m_bitonicParamsBuffer) m_tgai.free(m_bitonicParamsBuffer);
-}
-
-void PointCloud::loadLAS(const std::string& filepath) {
-    std::cout << "--- Loading File: " << filepath << " ---" << std::endl;
-
-    // Configure PDAL pipeline
-    pdal::Options options;
-    options.add("filename", filepath);
-    pdal::StageFactory factory;
-    pdal::Stage* reader = factory.createStage("readers.las");
-    reader->setOptions(options);
-    pdal::PointTable table;
-    reader->prepare(table);
-    pdal::PointViewSet viewSet = reader->execute(table);
-    pdal::PointViewPtr view = *viewSet.begin();
-    pdal::PointId pointCount = view->size();
-
-    // =========================================================
-    // DEBUG: PRINT LAS STRUCTURE
-    // =========================================================
-    pdal::PointLayoutPtr layout = view->layout();
-    pdal::Dimension::IdList dims = layout->dims();
-
-    std::cout << "\n=== LAS Record Structure ===" << std::endl;
-    std::cout << "Total Points: " << pointCount << std::endl;
-    std::cout << "Dimensions found:" << std::endl;
-
-    for (auto id : dims) {
-        std::string name = layout->dimName(id);
-        std::string type = pdal::Dimension::interpretationName(layout->dimType(id));
-        size_t size = layout->dimSize(id);
-
-        std::cout << " - " << std::left << std::setw(15) << name
-                  << " | Type: " << std::setw(15) << type
-                  << " | Size: " << size << " bytes" << std::endl;
-    }
-    std::cout << "============================\n" << std::endl;
-    // =========================================================
-
-    // Pass 1: Calculate global bounding box for normalization
-    m_points.reserve(pointCount);
-
-    // Initialize bounds logic
-    glm::dvec3 globalMin = {
-        std::numeric_limits<double>::max(),
-        std::numeric_limits<double>::max(),
-        std::numeric_limits<double>::max()
-    };
+    if (m_lpcDispatchBuffer) m_tgai.free(m_lpcDispatchBuffer);
+    if (m_quantizationBuffer) m_tgai.free(m_quantizationBuffer);
+}
 
-    glm::dvec3 globalMax = {
-        std::numeric_limits<double>::lowest(),
-        std::numeric_limits<double>::lowest(),
-        std::numeric_limits<double>::lowest()
+void PointCloud::loadPoints(PointSource& source) {
+    std::cout << "--- Loading: " << source.getName() << " ---" << std::endl;
+    const auto loadStart = std::chrono::steady_clock::now();
+
+    // The bounds are known up front, so every batch arrives already shifted to start at 0
+    const SourceBounds& raw = source.getBounds();
+    m_attributes.resize(source.getPointCount());
+    m_bounds = emptyBounds();
+    size_t loaded = 0;
+    source.read(raw.min, [&](const PointAttributes& batch, size_t count, const AABB& batchBounds) {
+        // The count of a source may only be an estimate
+        if (loaded + count > m_attributes.size()) m_attributes.resize(loaded + count);
+        std::copy_n(batch.positions.begin(), count, m_attributes.positions.begin() + loaded);
+        std::copy_n(batch.colors.begin(), count, m_attributes.colors.begin() + loaded);
+        std::copy_n(batch.intensities.begin(), count, m_attributes.intensities.begin() + loaded);
+        growBounds(m_bounds, batchBounds);
+        loaded += count;
+    });
+    m_attributes.resize(loaded);
+    m_pointCount = loaded;
+
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - loadStart).count();
+    std::cout << "Loaded " << loaded << " points in " << seconds << " s ("
+              << static_cast<double>(loaded) / std::max(seconds, 1e-6f) / 1e6 << " M points/s)" << std::endl;
+
+    std::cout << "Point cloud min: " << "(" << m_bounds.min.x << ", " << m_bounds.min.y << ", " << m_bounds.min.z << ")" << std::endl;
+    std::cout << "Point cloud max: " << "(" << m_bounds.max.x << ", " << m_bounds.max.y << ", " << m_bounds.max.z << ")" << std::endl;
+}
+
+void PointCloud::streamPoints(PointSource& source) {
+    std::cout << "--- Streaming: " << source.getName() << " ---" << std::endl;
+    const auto loadStart = std::chrono::steady_clock::now();
+
+    const size_t pointCount = source.getPointCount();
+    if (pointCount == 0) return;
+
+    // Every shifted position lies in the source bounds, so they define the quantization grid
+    const SourceBounds& raw = source.getBounds();
+    computeQuantization({glm::vec3(0.0f), glm::vec3(raw.max - raw.min)});
+    m_sourcePoints = createPointBuffers(pointCount, false);
+
+    const std::array<size_t, 3> strides = getStreamStrides();
+    const std::array<tga::Buffer, 3> targets{m_sourcePoints.points, m_sourcePoints.colors, m_sourcePoints.intensities};
+    size_t slotSize = 0;
+    for (size_t stride : strides) slotSize += STREAM_CHUNK_SIZE * stride;
+    UploadService uploads(m_tgai, slotSize, STREAM_UPLOAD_SLOTS);
+
+    // The encoding workers, reused for every batch
+    ThreadPool pool(encodeThreadCount(STREAM_CHUNK_SIZE));
+    m_bounds = emptyBounds();
+    size_t uploaded = 0;
+
+    source.read(raw.min, [&](const PointAttributes& batch, size_t count, const AABB& batchBounds) {
+        // Points beyond the announced count have no room in the source buffers
+        count = std::min(count, pointCount - uploaded);
+        if (count == 0) return;
+
+        // Nothing is drawn yet, so waiting for a staging slot only throttles the reader
+        const auto batchReady = UploadService::Clock::now();
+        uint8_t* slot = uploads.reserve(slotSize, true);
+        std::array<uint8_t*, 3> streams{};
+        size_t streamOffset = 0;
+        for (size_t s = 0; s < streams.size(); ++s) {
+            streams[s] = slot + streamOffset;
+            streamOffset += STREAM_CHUNK_SIZE * strides[s];
+        }
+
+        pool.parallelFor(count, ENCODE_CHUNK_SIZE, [&](unsigned, size_t begin, size_t end) {
+            encodePoints(batch, begin, end - begin, streams);
+        });
+
+        for (size_t s = 0; s < streams.size(); ++s) {
+            if (strides[s] > 0) uploads.copy(streams[s], targets[s], uploaded * strides[s], count * strides[s]);
+        }
+        uploads.submit(batchReady);
+        growBounds(m_bounds, batchBounds);
+        uploaded += count;
+    });
+    m_pointCount = uploaded;
+
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - loadStart).count();
+    std::cout << "Streamed " << uploaded << " points in " << seconds << " s ("
+              << static_cast<double>(uploaded) / std::max(seconds, 1e-6f) / 1e6 << " M points/s, "
+              << STREAM_CHUNK_SIZE << " points per chunk)" << std::endl;
+
+    std::cout << "Point cloud min: " << "(" << m_bounds.min.x << ", " << m_bounds.min.y << ", " << m_bounds.min.z << ")" << std::endl;
+    std::cout << "Point cloud max: " << "(" << m_bounds.max.x << ", " << m_bounds.max.y << ", " << m_bounds.max.z << ")" << std::endl;
+}
+
+std::vector<std::pair<tga::Buffer, size_t>> PointCloud::getCacheSections() const {
+    const std::array<size_t, 3> strides = getStreamStrides();
+    const size_t nodeCount = getNodeCount();
+
+    std::vector<std::pair<tga::Buffer, size_t>> sections(POINT_CACHE_SECTION_COUNT);
+    auto set = [&](CacheSection section, const tga::Buffer& buffer, size_t size) {
+        sections[static_cast<size_t>(section)] = {buffer, buffer ? size : 0};
     };
+    set(CacheSection::points, m_sourcePoints.points, m_pointCount * strides[0]);
+    set(CacheSection::colors, m_sourcePoints.colors, m_pointCount * strides[1]);
+    set(CacheSection::intensities, m_sourcePoints.intensities, m_pointCount * strides[2]);
+    set(CacheSection::lpcUniforms, m_lpcUniformsBuffer, sizeof(LPCUniforms));
+    set(CacheSection::uniqueCodes, m_uniqueCodesBuffer, m_numUnique * getMortonKeySize());
+    set(CacheSection::voxelStarts, m_voxelStartsBuffer, m_numUnique * sizeof(uint32_t));
+    set(CacheSection::nodes, m_nodesBuffer, nodeCount * sizeof(Node));
+    set(CacheSection::nodeBounds, m_nodeBoundsBuffer, nodeCount * sizeof(AABB));
+    set(CacheSection::proxyPoints, m_nodeProxies.points, nodeCount * strides[0]);
+    set(CacheSection::proxyColors, m_nodeProxies.colors, nodeCount * strides[1]);
+    set(CacheSection::proxyIntensities, m_nodeProxies.intensities, nodeCount * strides[2]);
+    set(CacheSection::cullCut, m_cullCutBuffer, (1 + static_cast<size_t>(m_cullCutCount)) * sizeof(uint32_t));
+    set(CacheSection::lpcDispatch, m_lpcDispatchBuffer, LPC_DISPATCH_COUNT * sizeof(DispatchIndirectCommand));
+    return sections;
+}
+
+void PointCloud::uploadSections(const std::vector<std::span<const uint8_t>>& data) {
+    // One staging buffer per section, all copies in one submission
+    const auto sections = getCacheSections();
+    std::vector<tga::StagingBuffer> staging;
+    tga::CommandBuffer cmd{};
+    {
+        tga::CommandRecorder rec(m_tgai, cmd);
+        for (size_t i = 0; i < sections.size(); ++i) {
+            const auto& [buffer, size] = sections[i];
+            if (!buffer || data[i].empty()) continue;
+
+            staging.push_back(m_tgai.createStagingBuffer({data[i].size(), const_cast<uint8_t*>(data[i].data())}));
+            rec.bufferUpload(staging.back(), buffer, std::min(data[i].size(), size));
+        }
+        rec.barrier(tga::PipelineStage::Transfer, tga::PipelineStage::ComputeShader);
+
+        cmd = rec.endRecording();
+        m_tgai.execute(cmd);
+        m_tgai.waitForCompletion(cmd);
+        m_tgai.free(cmd);
+    }
+    for (tga::StagingBuffer& buffer : staging) m_tgai.free(buffer);
+}
+
+void PointCloud::uploadCache() {
+    const PointCacheHeader& header = m_cache->getHeader();
+    createTreeBuffers(static_cast<uint32_t>(header.numUnique));
+    m_cullCutCount = header.cutCount;
 
-    // Iterate through points to find min/max values
-    for (pdal::PointId idx = 0; idx < pointCount; ++idx) {
-        double x = view->getFieldAs<double>(pdal::Dimension::Id::X, idx);
-        double y = view->getFieldAs<double>(pdal::Dimension::Id::Y, idx);
-        double z = view->getFieldAs<double>(pdal::Dimension::Id::Z, idx);
+    // Staging buffers are filled straight from the mapping
+    std::vector<std::span<const uint8_t>> data(POINT_CACHE_SECTION_COUNT);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = m_cache->getSection(static_cast<CacheSection>(i));
+    uploadSections(data);
 
-        if (x < globalMin.x) globalMin.x = x;
-        if (y < globalMin.y) globalMin.y = y;
-        if (z < globalMin.z) globalMin.z = z;
+    m_cache.reset();
+    m_loadedFromCache = true;
+    std::cout << "Restored " << m_pointCount << " points in " << m_numUnique << " voxels from the cache" << std::endl;
+}
 
-        if (y > globalMax.y) globalMax.y = y;
+bool PointCloud::writeCache() {
+    if (m_cachePath.empty() || m_loadedFromCache) return false;
+
+    try {
+        PointCacheHeader header;
+        header.pointFormat = static_cast<uint32_t>(m_pointFormat);
+        header.mortonBits = m_mortonBits;
+        header.cutCount = m_cullCutCount;
+        header.key = computePointCacheKey(m_sourcePaths);
+        header.bounds = m_bounds;
+        header.quantization = m_quantization;
+        header.numPoints = m_pointCount;
+        header.numUnique = m_numUnique;
+
+        // One section in flight at a time keeps the host memory at the largest section
+        PointCacheWriter writer(m_cachePath);
+        for (size_t i = 0; i < POINT_CACHE_SECTION_COUNT; ++i) {
+            std::vector<uint8_t> data = downloadSection(static_cast<CacheSection>(i));
+            if (!data.empty()) writer.writeSection(static_cast<CacheSection>(i), data.data(), data.size());
+        }
+        writer.finish(header);
+        std::cout << "Wrote point cache " << m_cachePath << std::endl;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Warning: " << e.what() << ", continuing without a cache" << std::endl;
+        return false;
     }
+}
+
+std::vector<uint8_t> PointCloud::downloadSection(CacheSection section) const {
+    const auto [buffer, size] = getCacheSections()[static_cast<size_t>(section)];
+    if (!buffer || size == 0) return {};
+
+    tga::StagingBuffer staging = m_tgai.createStagingBuffer({size});
+    tga::CommandBuffer cmd{};
+    tga::CommandRecorder rec(m_tgai, cmd);
+    rec.bufferDownload(buffer, staging, size);
+    cmd = rec.endRecording();
+    m_tgai.execute(cmd);
+    m_tgai.waitForCompletion(cmd);
+    m_tgai.free(cmd);
+
+    const uint8_t* mapping = static_cast<const uint8_t*>(m_tgai.getMapping(staging));
+    std::vector<uint8_t> data(mapping, mapping + size);
+    m_tgai.free(staging);
+    return data;
+}
+
+void PointCloud::uploadLPC(const LPCHierarchy& lpc) {
+    createTreeBuffers(lpc.getUniqueCount());
+    m_cullCutCount = static_cast<uint32_t>(lpc.cutNodes.size());
+    const size_t nodeCount = lpc.nodes.size();
+    const std::array<size_t, 3> strides = getStreamStrides();
+
+    // Points and proxies in the GPU format
+    std::array<std::vector<uint8_t>, 3> points;
+    std::array<std::vector<uint8_t>, 3> proxies;
+    for (size_t s = 0; s < strides.size(); ++s) {
+        points[s].resize(m_pointCount * strides[s]);
+        proxies[s].resize(nodeCount * strides[s]);
+    }
+    encodePoints(lpc.sortedPoints, 0, m_pointCount, {points[0].data(), points[1].data(), points[2].data()});
+    encodePoints(lpc.proxies, 0, nodeCount, {proxies[0].data(), proxies[1].data(), proxies[2].data()},
+                 lpc.proxySplatSizes.data());
+
+    std::vector<uint8_t> uniqueCodes = lpc.packUniqueCodes(getMortonKeySize());
+
+    std::vector<uint32_t> cullCut{m_cullCutCount};
+    cullCut.insert(cullCut.end(), lpc.cutNodes.begin(), lpc.cutNodes.end());
+
+    LPCUniforms lpcUniforms = {m_bounds, static_cast<uint32_t>(m_pointCount), m_numUnique, computeMortonScale(m_bounds)};
+
+    // Same arguments as 5_dispatch_args.comp
+    auto dispatchCommand = [](size_t numThreads) {
+        auto [x, y] = getDispatchDimensions(numThreads);
+        return DispatchIndirectCommand{x, y, 1};
+    };
+    std::array<DispatchIndirectCommand, LPC_DISPATCH_COUNT> dispatch{};
+    dispatch[LPC_DISPATCH_LEAVES] = dispatchCommand(m_numUnique);
+    dispatch[LPC_DISPATCH_INTERNAL] = dispatchCommand(m_numUnique - 1);
+    dispatch[LPC_DISPATCH_NODES] = dispatchCommand(nodeCount);
+
+    auto bytes = [](const auto& container) {
+        return std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(container.data()),
+                                        container.size() * sizeof(*container.data()));
+    };
+    std::vector<std::span<const uint8_t>> data(POINT_CACHE_SECTION_COUNT);
+    auto set = [&](CacheSection section, std::span<const uint8_t> contents) { data[static_cast<size_t>(section)] = contents; };
+    set(CacheSection::points, bytes(points[0]));
+    set(CacheSection::colors, bytes(points[1]));
+    set(CacheSection::intensities, bytes(points[2]));
+    set(CacheSection::lpcUniforms, {reinterpret_cast<const uint8_t*>(&lpcUniforms), sizeof(lpcUniforms)});
+    set(CacheSection::uniqueCodes, bytes(uniqueCodes));
+    set(CacheSection::voxelStarts, bytes(lpc.voxelStarts));
+    set(CacheSection::nodes, bytes(lpc.nodes));
+    set(CacheSection::nodeBounds, bytes(lpc.nodeBounds));
+    set(CacheSection::proxyPoints, bytes(proxies[0]));
+    set(CacheSection::proxyColors, bytes(proxies[1]));
+    set(CacheSection::proxyIntensities, bytes(proxies[2]));
+    set(CacheSection::cullCut, bytes(cullCut));
+    set(CacheSection::lpcDispatch, bytes(dispatch));
+    uploadSections(data);
+
+    std::cout << "Uploaded " << m_numUnique << " voxels and " << nodeCount << " nodes built on the CPU" << std::endl;
+}
+
+void PointCloud::computeQuantization(const AABB& bounds) {
+    m_quantization = computePointQuantization(bounds);
+}
+
+std::array<size_t, 3> PointCloud::getStreamStrides() const {
+    return getPointStreamStrides(m_pointFormat);
+}
 
-    // Initialize the member AABB bounds
-    m_bounds.min = glm::vec3(std::numeric_limits<float>::max());
-    m_bounds.max = glm::vec3(std::numeric_limits<float>::lowest());
+glm::uvec3 PointCloud::quantizePosition(const glm::vec3& position) const {
+    return quantizePointPosition(m_quantization, position);
+}
 
-    // Pass 2: Normalize coordinates and populate the point vector
-    for (pdal::PointId idx = 0; idx < pointCount; ++idx) {
-        double rawX = view->getFieldAs<double>(pdal::Dimension::Id::X, idx);
-        double rawY = view->getFieldAs<double>(pdal::Dimension::Id::Y, idx);
-        double rawZ = view->getFieldAs<double>(pdal::Dimension::Id::Z, idx);
+glm::vec3 PointCloud::getStoredPosition(const glm::vec3& position) const {
+    if (m_pointFormat != PointFormat::compact) return position;
+    // decodePosition in include/point.glsl
+    return m_quantization.origin + glm::vec3(quantizePosition(position)) * m_quantization.step;
+}
+
+void PointCloud::encodePoints(const PointAttributes& attributes, size_t begin, size_t count,
+                              const std::array<uint8_t*, 3>& streams, const float* splatSizes) const {
+    encodePointRange(m_pointFormat, m_quantization, attributes, begin, count, streams, splatSizes);
+}
 
-        // Normalize X and Z to start at 0
-        float normX = static_cast<float>(rawX - globalMin.x);
-        float normZ = static_cast<float>(rawZ - globalMin.z);
+PointBuffers PointCloud::createPointBuffers(size_t count, bool upload) {
+    const std::array<size_t, 3> strides = getStreamStrides();
+
+    // Host copies of the streams, only filled when uploading the loaded points
+    std::array<std::vector<uint8_t>, 3> data;
+    if (upload) {
+        for (size_t s = 0; s < data.size(); ++s) data[s].resize(count * strides[s]);
+        encodePoints(m_attributes, 0, count, {data[0].data(), data[1].data(), data[2].data()});
+    }
+
+    // Creates a storage buffer, optionally filled from its host stream
+    auto createStream = [&](size_t s) {
+        size_t size = count * strides[s];
+        if (!upload) return m_tgai.createBuffer({tga::BufferUsage::storage, size});
+        return m_tgai.createBuffer({
+            tga::BufferUsage::storage,
+            size,
+            m_tgai.createStagingBuffer({size, data[s].data()})
+        });
+    };
 
-        // Invert Y axis for coordinate system compatibility.
-        // Calculates distance from the maximum Y to flip the axis while keeping values positive.
-        float invNormY = static_cast<float>(globalMax.y - rawY);
+    PointBuffers buffers;
+    buffers.points = createStream(0);
+    if (strides[1] > 0) buffers.colors = createStream(1);
+    if (strides[2] > 0) buffers.intensities = createStream(2);
+    return buffers;
+}
 
-        glm::vec3 pos{normX, normZ, invNormY};
+void PointCloud::freePointBuffers(PointBuffers& buffers) {
+    if (buffers.points) m_tgai.free(buffers.points);
+    if (buffers.colors) m_tgai.free(buffers.colors);
+    if (buffers.intensities) m_tgai.free(buffers.intensities);
+    buffers = {};
+}
 
-        // Update the global bounding box
-        m_bounds.min = glm::min(m_bounds.min, pos);
-        m_bounds.max = glm::max(m_bounds.max, pos);
+void PointCloud::freeBuffer(tga::Buffer& buffer) {
+    if (buffer) m_tgai.free(buffer);
+    buffer = {};
+}
 
-        // Normalize color intensity (16-bit to float [0-1])
-        float r = static_cast<float>(view->getFieldAs<uint16_t>(pdal::Dimension::Id::Red, idx)) / 65535.0f;
-        float g = static_cast<float>(view->getFieldAs<uint16_t>(pdal::Dimension::Id::Green, idx)) / 65535.0f;
-        float b = static_cast<float>(view->getFieldAs<uint16_t>(pdal::Dimension::Id::Blue, idx)) / 65535.0f;
-        float i = static_cast<float>(view->getFieldAs<uint16_t>(pdal::Dimension::Id::Intensity, idx)) / 65535.0f;
+void PointCloud::swapSortedPoints() {
+    std::swap(m_sourcePoints, m_frames[0].visiblePoints);
+    releaseBuildScratch();
+}
 
-        m_points.push_back(Point{pos, {r, g, b}, i});
+void PointCloud::releaseBuildScratch() {
+    // The aliases of the sort indices go with them
+    for (tga::Buffer* buffer : {&m_mortonCodesBuffer, &m_sortIndicesBuffer, &m_mortonCodesAltBuffer, &m_sortIndicesAltBuffer,
+                                &m_radixTileHistogramBuffer, &m_radixGlobalHistogramBuffer, &m_radixParamsBuffer,
+                                &m_bitonicParamsBuffer, &m_scanBlockSumsBuffer}) {
+        freeBuffer(*buffer);
     }
+    if (m_cullOutput == CullOutput::indices && !m_frames.empty()) freePointBuffers(m_frames[0].visiblePoints);
+}
 
-    std::cout << "Point cloud min: " << "(" << m_bounds.min.x << ", " << m_bounds.min.y << ", " << m_bounds.min.z << ")" << std::endl;
-    std::cout << "Point cloud max: " << "(" << m_bounds.max.x << ", " << m_bounds.max.y << ", " << m_bounds.max.z << ")" << std::endl;
-}
\ No newline at end of file
+void PointCloud::releaseTreeBuffers() {
+    for (tga::Buffer* buffer : {&m_uniqueCodesBuffer, &m_voxelStartsBuffer, &m_nodesBuffer, &m_nodeBoundsBuffer, &m_cullCutBuffer}) {
+        freeBuffer(*buffer);
+    }
+    freePointBuffers(m_nodeProxies);
+}
@@ -0,0 +1,208 @@
+#include "PointRasterizer.hpp"
+#include "DeviceFeatures.hpp"
+#include "GpuUtils.hpp"
+#include "tga/tga_utils.hpp"
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+/**
+ * @brief Throws unless the device TGA created has the 64-bit buffer atomics of raster_points enabled.
+ */
+void requireBufferInt64Atomics() {
+    const DeviceFeatures& features = getDeviceFeatures();
+    if (!features.intercepted) {
+        throw std::runtime_error("--render=compute needs the Vulkan device created through DeviceFeatures.cpp "
+                                 "(link with --wrap=vkCreateDevice), use --render=quads");
+    }
+    if (!features.bufferInt64Atomics) {
+        throw std::runtime_error("--render=compute requires shaderInt64 and shaderBufferInt64Atomics, which " +
+                                 features.deviceName + " does not support (use --render=quads)");
+    }
+}
+
+} // namespace
+
+PointRasterizer::PointRasterizer(tga::Interface& tgai, const PointCloud& pointCloud, const std::vector<tga::Buffer>& cameraUbos,
+                                 tga::Window window, tga::ClearOperation clear)
+    : PointRasterizer(tgai, pointCloud, cameraUbos, window, tgai.resolution(window), clear) {}
+
+PointRasterizer::PointRasterizer(tga::Interface& tgai, const PointCloud& pointCloud, const std::vector<tga::Buffer>& cameraUbos,
+                                 tga::Texture texture, uint32_t width, uint32_t height, tga::ClearOperation clear)
+    : PointRasterizer(tgai, pointCloud, cameraUbos, texture, {width, height}, clear) {}
+
+PointRasterizer::PointRasterizer(tga::Interface& tgai, const PointCloud& pointCloud, const std::vector<tga::Buffer>& cameraUbos,
+                                 std::variant<tga::Window, tga::Texture> target, std::pair<uint32_t, uint32_t> size,
+                                 tga::ClearOperation clear)
+    : m_tgai(tgai), m_pointCloud(pointCloud), m_pixelCount(size.first * size.second) {
+    if (cameraUbos.size() != pointCloud.getFramesInFlight()) {
+        throw std::invalid_argument("PointRasterizer needs one camera buffer per frame in flight");
+    }
+    requireBufferInt64Atomics();
+
+    RasterParams params{size.first, size.second, {0, 0}};
+    m_paramsBuffer = tgai.createBuffer({
+        tga::BufferUsage::uniform,
+        sizeof(RasterParams),
+        tgai.createStagingBuffer({sizeof(RasterParams), tga::memoryAccess(params)})
+    });
+
+    tga::Shader clearShader = tga::loadShader("shaders/raster_clear_comp.spv", tga::ShaderType::compute, tgai);
+    tga::Shader argsShader = tga::loadShader("shaders/raster_args_comp.spv", tga::ShaderType::compute, tgai);
+    tga::Shader rasterShader = tga::loadShader(shaderPath(pointCloud, "raster_points", SHADER_POINT_FORMAT | SHADER_CULL_OUTPUT),
+                                               tga::ShaderType::compute, tgai);
+    tga::Shader reprojectShader = tga::loadShader("shaders/raster_reproject_comp.spv", tga::ShaderType::compute, tgai);
+    tga::Shader resolveVert = tga::loadShader("shaders/raster_resolve_vert.spv", tga::ShaderType::vertex, tgai);
+    tga::Shader resolveFrag = tga::loadShader("shaders/raster_resolve_frag.spv", tga::ShaderType::fragment, tgai);
+
+    // Framebuffer and its size, shared by the clear and the resolve
+    tga::InputLayout framebufferLayout{{
+        {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}
+    }};
+    m_clearPass = tgai.createComputePass({clearShader, framebufferLayout});
+    m_argsPass = tgai.createComputePass({argsShader, tga::InputLayout{{
+        {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}
+    }}});
+
+    // 0: Previous camera UBO, 1: Camera UBO, 2: Previous framebuffer, 3: Framebuffer, 4: Raster params
+    m_reprojectPass = tgai.createComputePass({reprojectShader, tga::InputLayout{{
+        {tga::BindingType::uniformBuffer}, {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer},
+        {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}
+    }}});
+
+    // Drawn over whatever the target holds, without depth test
+    m_resolvePass = std::visit([&](auto renderTarget) {
+        return tgai.createRenderPass({
+            resolveVert, resolveFrag, renderTarget, {},
+            framebufferLayout,
+            clear,
+            tga::PerPixelOperations{tga::CompareOperation::ignore, false},
+            tga::RasterizerConfig{tga::FrontFace::counterclockwise, tga::CullMode::none}
+        });
+    }, target);
+
+    // The layouts are the same for every frame, only the bound buffers differ
+    for (uint32_t frame = 0; frame < pointCloud.getFramesInFlight(); ++frame) {
+        m_framebuffers.push_back(tgai.createBuffer({tga::BufferUsage::storage, m_pixelCount * sizeof(uint64_t)}));
+        m_dispatchArgs.push_back(tgai.createBuffer({
+            tga::BufferUsage::indirect | tga::BufferUsage::storage,
+            sizeof(DispatchIndirectCommand)
+        }));
+
+        m_clearSets.push_back(tgai.createInputSet({m_clearPass, {{m_framebuffers[frame], 0}, {m_paramsBuffer, 1}}}));
+        m_resolveSets.push_back(tgai.createInputSet({m_resolvePass, {{m_framebuffers[frame], 0}, {m_paramsBuffer, 1}}}));
+        m_argsSets.push_back(tgai.createInputSet({m_argsPass, {
+            {pointCloud.getIndirectBuffer(frame), 0}, {m_dispatchArgs[frame], 1}
+        }}));
+
+        // 0: Camera UBO, 1: Visible points (source points with indices), 2: Point quantization,
+        // 3: Indirect draw, 4: Framebuffer, 5: Raster params,
+        // 6: Visible indices, 7: LOD proxies (--cull-output=indices only),
+        // then the color/intensity streams of the point buffers (SoA only)
+        const bool indices = pointCloud.getCullOutput() == CullOutput::indices;
+        std::vector<tga::BindingLayout> l_raster{
+            {tga::BindingType::uniformBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer},
+            {tga::BindingType::storageBuffer}, {tga::BindingType::storageBuffer}, {tga::BindingType::uniformBuffer}
+        };
+        std::vector<tga::Binding> b_raster{
+            {cameraUbos[frame], 0}, {indices ? pointCloud.getSourceBuffer() : pointCloud.getVisibleBuffer(frame), 1},
+            {pointCloud.getQuantizationBuffer(), 2},
+            {pointCloud.getIndirectBuffer(frame), 3}, {m_framebuffers[frame], 4}, {m_paramsBuffer, 5}
+        };
+        if (indices) {
+            l_raster.push_back({tga::BindingType::storageBuffer});
+            l_raster.push_back({tga::BindingType::storageBuffer});
+            b_raster.push_back({pointCloud.getVisibleIndexBuffer(frame), 6});
+            b_raster.push_back({pointCloud.getNodeProxyBuffer(), 7});
+            appendPointStreams(pointCloud, l_raster, b_raster, {pointCloud.getSourcePoints(), pointCloud.getNodeProxies()});
+        } else {
+            appendPointStreams(pointCloud, l_raster, b_raster, {pointCloud.getVisiblePoints(frame)});
+        }
+        if (!m_rasterPass) m_rasterPass = tgai.createComputePass({rasterShader, tga::InputLayout{l_raster}});
+        m_rasterSets.push_back(tgai.createInputSet({m_rasterPass, b_raster}));
+    }
+
+    // Every framebuffer exists now; with a single frame in flight, the reprojection is never recorded
+    const uint32_t frameCount = pointCloud.getFramesInFlight();
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        const uint32_t previous = (frame + frameCount - 1) % frameCount;
+        m_reprojectSets.push_back(tgai.createInputSet({m_reprojectPass, {
+            {cameraUbos[previous], 0}, {cameraUbos[frame], 1}, {m_framebuffers[previous], 2},
+            {m_framebuffers[frame], 3}, {m_paramsBuffer, 4}
+        }}));
+    }
+
+    tgai.free(resolveFrag);
+    tgai.free(resolveVert);
+    tgai.free(reprojectShader);
+    tgai.free(rasterShader);
+    tgai.free(argsShader);
+    tgai.free(clearShader);
+}
+
+PointRasterizer::~PointRasterizer() {
+    for (tga::InputSet set : m_resolveSets) m_tgai.free(set);
+    for (tga::InputSet set : m_reprojectSets) m_tgai.free(set);
+    for (tga::InputSet set : m_rasterSets) m_tgai.free(set);
+    for (tga::InputSet set : m_argsSets) m_tgai.free(set);
+    for (tga::InputSet set : m_clearSets) m_tgai.free(set);
+    if (m_resolvePass) m_tgai.free(m_resolvePass);
+    if (m_reprojectPass) m_tgai.free(m_reprojectPass);
+    if (m_rasterPass) m_tgai.free(m_rasterPass);
+    if (m_argsPass) m_tgai.free(m_argsPass);
+    if (m_clearPass) m_tgai.free(m_clearPass);
+    for (tga::Buffer buffer : m_dispatchArgs) m_tgai.free(buffer);
+    for (tga::Buffer buffer : m_framebuffers) m_tgai.free(buffer);
+    if (m_paramsBuffer) m_tgai.free(m_paramsBuffer);
+}
+
+void PointRasterizer::recordRaster(tga::CommandRecorder& recorder, uint32_t frame, bool clear) {
+    // The culling output (points and instance count) must be complete
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+
+    // 1. Reset the framebuffer to the far plane, unless it holds the reprojected previous frame
+    if (clear) {
+        auto [clearGroupsX, clearGroupsY] = getDispatchDimensions(m_pixelCount);
+        recorder.setComputePass(m_clearPass).bindInputSet(m_clearSets[frame]);
+        recorder.dispatch(clearGroupsX, clearGroupsY, 1);
+    }
+
+    // 2. Size the raster pass from the number of visible points
+    recorder.setComputePass(m_argsPass).bindInputSet(m_argsSets[frame]);
+    recorder.dispatch(1, 1, 1);
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::DrawIndirect);
+
+    // 3. One thread per visible point, nearest point per pixel wins
+    recorder.setComputePass(m_rasterPass).bindInputSet(m_rasterSets[frame]);
+    recorder.dispatchIndirect(m_dispatchArgs[frame]);
+
+    // The resolve reads the framebuffer in its fragment shader
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::FragmentShader);
+}
+
+void PointRasterizer::recordReprojection(tga::CommandRecorder& recorder, uint32_t frame) {
+    // The camera update and the rasterization of the previous frame must be complete
+    recorder.barrier(tga::PipelineStage::Transfer, tga::PipelineStage::ComputeShader);
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+
+    auto [groupsX, groupsY] = getDispatchDimensions(m_pixelCount);
+    recorder.setComputePass(m_clearPass).bindInputSet(m_clearSets[frame]);
+    recorder.dispatch(groupsX, groupsY, 1);
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+
+    // One thread per pixel of the previous frame, nearest sample per pixel wins
+    recorder.setComputePass(m_reprojectPass).bindInputSet(m_reprojectSets[frame]);
+    recorder.dispatch(groupsX, groupsY, 1);
+
+    // The culling reads the reprojected depth, the raster pass adds to it
+    recorder.barrier(tga::PipelineStage::ComputeShader, tga::PipelineStage::ComputeShader);
+}
+
+void PointRasterizer::recordResolve(tga::CommandRecorder& recorder, uint32_t frame, uint32_t targetFrame) {
+    // Fullscreen triangle
+    recorder.setRenderPass(m_resolvePass, targetFrame)
+            .bindInputSet(m_resolveSets[frame])
+            .draw(3, 0);
+}
@@ -0,0 +1,105 @@
+#include "PointSource.hpp"
+#include "BunnyLoader.hpp"
+#include "LasSource.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+
+/**
+ * @brief Point source of a registered PLY scan set (a bun.conf file).
+ *
+ * PLY headers carry no bounds, so the scans are loaded in full when the
+ * source is opened (in parallel, see loadBunny) and the bounds are taken from
+ * the loaded positions. Scans have no colors: every point is white at full
+ * intensity.
+ */
+class PlySource : public PointSource {
+public:
+    explicit PlySource(const std::string& path)
+        : m_path(path), m_positions(loadBunny(path, std::filesystem::path(path).parent_path().string())) {
+        for (const glm::vec3& position : m_positions) {
+            m_bounds.min = glm::min(m_bounds.min, glm::dvec3(position));
+            m_bounds.max = glm::max(m_bounds.max, glm::dvec3(position));
+        }
+    }
+
+    std::string getName() const override { return m_path; }
+    size_t getPointCount() const override { return m_positions.size(); }
+    const SourceBounds& getBounds() const override { return m_bounds; }
+
+    void read(const glm::dvec3& origin, const BatchFn& fn) override {
+        PointAttributes batch;
+        batch.resize(std::min(STREAM_CHUNK_SIZE, m_positions.size()));
+        std::fill(batch.colors.begin(), batch.colors.end(), glm::vec3(1.0f));
+        std::fill(batch.intensities.begin(), batch.intensities.end(), 1.0f);
+
+        const glm::vec3 shift(origin);
+        for (size_t first = 0; first < m_positions.size(); first += STREAM_CHUNK_SIZE) {
+            size_t count = std::min(STREAM_CHUNK_SIZE, m_positions.size() - first);
+            AABB bounds{glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())};
+            for (size_t k = 0; k < count; ++k) {
+                batch.positions[k] = m_positions[first + k] - shift;
+                bounds.min = glm::min(bounds.min, batch.positions[k]);
+                bounds.max = glm::max(bounds.max, batch.positions[k]);
+            }
+            fn(batch, count, bounds);
+        }
+    }
+
+private:
+    std::string m_path;
+    std::vector<glm::vec3> m_positions;
+    SourceBounds m_bounds;
+};
+
+/**
+ * @brief Several inputs read one after another as a single source.
+ */
+class MergedPointSource : public PointSource {
+public:
+    explicit MergedPointSource(std::vector<std::unique_ptr<PointSource>> sources) : m_sources(std::move(sources)) {
+        for (const std::unique_ptr<PointSource>& source : m_sources) {
+            m_pointCount += source->getPointCount();
+            if (!source->getBounds().empty()) m_bounds.grow(source->getBounds());
+        }
+    }
+
+    std::string getName() const override {
+        std::string name;
+        for (const std::unique_ptr<PointSource>& source : m_sources) {
+            name += (name.empty() ? "" : ", ") + source->getName();
+        }
+        return name;
+    }
+
+    size_t getPointCount() const override { return m_pointCount; }
+    const SourceBounds& getBounds() const override { return m_bounds; }
+
+    void read(const glm::dvec3& origin, const BatchFn& fn) override {
+        for (const std::unique_ptr<PointSource>& source : m_sources) source->read(origin, fn);
+    }
+
+private:
+    std::vector<std::unique_ptr<PointSource>> m_sources;
+    size_t m_pointCount = 0;
+    SourceBounds m_bounds;
+};
+
+} // namespace
+
+std::unique_ptr<PointSource> openPointSource(const std::string& path) {
+    if (isBunnyConf(path)) return std::make_unique<PlySource>(path);
+    return std::make_unique<LasSource>(path);
+}
+
+std::unique_ptr<PointSource> openPointSources(const std::vector<std::string>& paths) {
+    if (paths.empty()) throw std::runtime_error("No input given");
+    if (paths.size() == 1) return openPointSource(paths.front());
+
+    std::vector<std::unique_ptr<PointSource>> sources;
+    for (const std::string& path : paths) sources.push_back(openPointSource(path));
+    return std::make_unique<MergedPointSource>(std::move(sources));
+}
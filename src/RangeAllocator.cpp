@@ -0,0 +1,55 @@
+#include "RangeAllocator.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+RangeAllocator::RangeAllocator(size_t capacity) : m_capacity(capacity) {
+    if (capacity > 0) m_free.emplace(0, capacity);
+}
+
+size_t RangeAllocator::allocate(size_t size, size_t alignment) {
+    if (size == 0) throw std::invalid_argument("RangeAllocator cannot allocate an empty range");
+
+    for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+        const auto [rangeOffset, rangeSize] = *it;
+        size_t offset = (rangeOffset + alignment - 1) & ~(alignment - 1);
+        size_t padding = offset - rangeOffset;
+        if (padding >= rangeSize || rangeSize - padding < size) continue;
+
+        // Keep the padding in front and the tail behind the range free
+        m_free.erase(it);
+        if (padding > 0) m_free.emplace(rangeOffset, padding);
+        if (rangeSize - padding > size) m_free.emplace(offset + size, rangeSize - padding - size);
+        m_used += size;
+        return offset;
+    }
+    return INVALID_OFFSET;
+}
+
+void RangeAllocator::release(size_t offset, size_t size) {
+    m_used -= size;
+    auto next = m_free.lower_bound(offset);
+
+    // Merge with the free range right behind
+    if (next != m_free.end() && offset + size == next->first) {
+        size += next->second;
+        next = m_free.erase(next);
+    }
+
+    // Merge with the free range right in front
+    if (next != m_free.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            previous->second += size;
+            return;
+        }
+    }
+    m_free.emplace(offset, size);
+}
+
+size_t RangeAllocator::getLargestFree() const {
+    size_t largest = 0;
+    for (const auto& [offset, size] : m_free) largest = std::max(largest, size);
+    return largest;
+}
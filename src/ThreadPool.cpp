@@ -0,0 +1,72 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned worker = 1; worker < threadCount; ++worker) {
+        m_threads.emplace_back(&ThreadPool::workerLoop, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) thread.join();
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const ChunkFn& fn) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+
+    // A single chunk is not worth waking anyone up
+    if (m_threads.empty() || count <= grain) {
+        for (size_t begin = 0; begin < count; begin += grain) fn(0, begin, std::min(count, begin + grain));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &fn;
+        m_count = count;
+        m_grain = grain;
+        m_nextChunk = 0;
+        m_busyWorkers = static_cast<unsigned>(m_threads.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    runChunks(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&] { return m_busyWorkers == 0; });
+    m_job = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned worker) {
+    uint64_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seenGeneration; });
+            if (m_stop) return;
+            seenGeneration = m_generation;
+        }
+
+        runChunks(worker);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busyWorkers == 0) m_done.notify_one();
+    }
+}
+
+void ThreadPool::runChunks(unsigned worker) {
+    const size_t chunkCount = (m_count + m_grain - 1) / m_grain;
+    for (size_t chunk = m_nextChunk++; chunk < chunkCount; chunk = m_nextChunk++) {
+        size_t begin = chunk * m_grain;
+        (*m_job)(worker, begin, std::min(m_count, begin + m_grain));
+    }
+}
@@ -0,0 +1,408 @@
+#include "TileManager.hpp"
+#include "LasSource.hpp"
+#include "ThreadPool.hpp"
+
+#include <tga/tga_utils.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+bool isTileFile(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".las" || extension == ".laz";
+}
+
+/// Lists the .las/.laz files of a directory (sorted), or the paths of a list file, one per line.
+std::vector<std::string> listTiles(const std::string& tilesPath) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> paths;
+
+    if (fs::is_directory(tilesPath)) {
+        for (const fs::directory_entry& entry : fs::directory_iterator(tilesPath)) {
+            if (entry.is_regular_file() && isTileFile(entry.path())) paths.push_back(entry.path().string());
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    std::ifstream file(tilesPath);
+    if (!file) throw std::runtime_error("Cannot open tile list " + tilesPath);
+
+    // Relative entries are relative to the list file
+    const fs::path base = fs::path(tilesPath).parent_path();
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos || line[begin] == '#') continue;
+        size_t end = line.find_last_not_of(" \t\r");
+        fs::path path = line.substr(begin, end - begin + 1);
+        paths.push_back((path.is_relative() ? base / path : path).string());
+    }
+    return paths;
+}
+
+/// Frustum planes (xyz normal pointing inside, w distance) of a Vulkan projection with depth in [0, 1].
+std::array<glm::vec4, 6> extractFrustumPlanes(const glm::mat4& m) {
+    auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+    return {row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(2), row(3) - row(2)};
+}
+
+bool intersectsFrustum(const std::array<glm::vec4, 6>& planes, const AABB& box) {
+    for (const glm::vec4& plane : planes) {
+        // The corner farthest along the plane normal
+        glm::vec3 corner(plane.x >= 0.0f ? box.max.x : box.min.x,
+                         plane.y >= 0.0f ? box.max.y : box.min.y,
+                         plane.z >= 0.0f ? box.max.z : box.min.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) return false;
+    }
+    return true;
+}
+
+float distanceToBox(const AABB& box, const glm::vec3& point) {
+    return glm::length(glm::max(glm::max(box.min - point, point - box.max), glm::vec3(0.0f)));
+}
+
+} // namespace
+
+TileManager::TileManager(tga::Interface& tgai, const Config& config)
+    : m_tgai(tgai), m_pointFormat(config.pointFormat), m_framesInFlight(config.framesInFlight),
+      m_allocator(0)
+{
+    std::cout << "--- Indexing tiles: " << config.tilesPath << " ---" << std::endl;
+    const std::vector<std::string> paths = listTiles(config.tilesPath);
+    if (paths.empty()) throw std::runtime_error("No .las/.laz tiles in " + config.tilesPath);
+
+    // Only the headers are read, in parallel as every open goes through PDAL
+    std::vector<std::unique_ptr<LasSource>> sources(paths.size());
+    std::vector<std::string> errors(paths.size());
+    ThreadPool pool(static_cast<unsigned>(std::min<size_t>(paths.size(), std::max(1u, std::thread::hardware_concurrency()))));
+    pool.parallelFor(paths.size(), 1, [&](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            try {
+                sources[i] = std::make_unique<LasSource>(paths[i]);
+            } catch (const std::exception& e) {
+                errors[i] = e.what();
+            }
+        }
+    });
+
+    SourceBounds dataset;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!sources[i] || sources[i]->getPointCount() == 0 || sources[i]->getBounds().empty()) {
+            std::cerr << "Skipping tile " << paths[i] << (errors[i].empty() ? ": empty" : ": " + errors[i]) << std::endl;
+            continue;
+        }
+        dataset.grow(sources[i]->getBounds());
+    }
+    if (dataset.empty()) throw std::runtime_error("No readable tiles in " + config.tilesPath);
+
+    // All tiles share one origin and one quantization grid, so their points land in one viewer space
+    m_origin = dataset.min;
+    m_bounds = {glm::vec3(0.0f), glm::vec3(dataset.max - dataset.min)};
+    m_quantization = computePointQuantization(m_bounds);
+
+    size_t totalPoints = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!sources[i] || sources[i]->getPointCount() == 0 || sources[i]->getBounds().empty()) continue;
+        const SourceBounds& bounds = sources[i]->getBounds();
+        Tile tile;
+        tile.info = {paths[i], {glm::vec3(bounds.min - m_origin), glm::vec3(bounds.max - m_origin)}, sources[i]->getPointCount()};
+        m_tiles.push_back(std::move(tile));
+        totalPoints += sources[i]->getPointCount();
+    }
+
+    // The arena holds as many points as the budget allows, one storage buffer per stream
+    const std::array<size_t, 3> strides = getPointStreamStrides(m_pointFormat);
+    for (size_t stride : strides) m_bytesPerPoint += stride;
+    const size_t budgetBytes = static_cast<size_t>(config.tileBudgetMB) * 1024 * 1024;
+    const size_t capacity = budgetBytes / m_bytesPerPoint;
+    m_allocator = RangeAllocator(capacity);
+
+    std::array<tga::Buffer*, 3> targets{&m_arena.points, &m_arena.colors, &m_arena.intensities};
+    for (size_t s = 0; s < strides.size(); ++s) {
+        if (strides[s] > 0) *targets[s] = tgai.createBuffer({tga::BufferUsage::storage, capacity * strides[s]});
+    }
+
+    // One staging slot per frame in flight, plus the one of the current frame
+    m_uploads = std::make_unique<UploadService>(tgai, TILE_UPLOAD_POINTS_PER_FRAME * m_bytesPerPoint, m_framesInFlight + 1);
+
+    m_quantizationBuffer = tgai.createBuffer({
+        tga::BufferUsage::uniform,
+        sizeof(PointQuantization),
+        tgai.createStagingBuffer({sizeof(PointQuantization), tga::memoryAccess(m_quantization)})
+    });
+
+    m_stats.tileCount = m_tiles.size();
+    m_stats.budgetBytes = capacity * m_bytesPerPoint;
+    std::cout << "Indexed " << m_tiles.size() << " tiles, " << totalPoints << " points ("
+              << totalPoints * m_bytesPerPoint / (1024 * 1024) << " MiB), tile budget "
+              << config.tileBudgetMB << " MiB (" << capacity << " points)" << std::endl;
+    std::cout << "Dataset extent: (" << m_bounds.max.x << ", " << m_bounds.max.y << ", " << m_bounds.max.z << ")" << std::endl;
+
+    m_loader = std::thread(&TileManager::loaderLoop, this);
+}
+
+TileManager::~TileManager() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    if (m_loader.joinable()) m_loader.join();
+    m_uploads.reset();
+
+    if (m_arena.points) m_tgai.free(m_arena.points);
+    if (m_arena.colors) m_tgai.free(m_arena.colors);
+    if (m_arena.intensities) m_tgai.free(m_arena.intensities);
+    if (m_quantizationBuffer) m_tgai.free(m_quantizationBuffer);
+}
+
+void TileManager::loaderLoop() {
+    while (true) {
+        size_t index;
+        {
+            // Stop reading ahead while enough tiles wait for their upload
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] {
+                return m_stop || (!m_requests.empty() && m_loaded.size() + m_loading < TILE_MAX_PENDING_LOADS);
+            });
+            if (m_stop) return;
+            index = m_requests.front();
+            m_requests.pop_front();
+            ++m_loading;
+        }
+
+        // The tile info is immutable after construction, so it is read without the lock
+        const TileInfo& info = m_tiles[index].info;
+        LoadedTile loaded;
+        loaded.tile = index;
+        try {
+            LasSource source(info.path);
+            source.read(m_origin, [&](const PointAttributes& batch, size_t count, const AABB&) {
+                // The batch is reused by the source, keep a copy of its valid points
+                PointAttributes& copy = loaded.batches.emplace_back();
+                copy.positions.assign(batch.positions.begin(), batch.positions.begin() + count);
+                copy.colors.assign(batch.colors.begin(), batch.colors.begin() + count);
+                copy.intensities.assign(batch.intensities.begin(), batch.intensities.begin() + count);
+                loaded.pointCount += count;
+            });
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to load tile " << info.path << ": " << e.what() << std::endl;
+            loaded.batches.clear();
+            loaded.pointCount = 0;
+        }
+        loaded.loadedAt = UploadService::Clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_loading;
+            m_loaded.push_back(std::move(loaded));
+        }
+    }
+}
+
+void TileManager::update(const glm::mat4& viewProjection, const glm::vec3& eye, uint64_t frameNumber) {
+    // 1. The frame that last used this frame's slot has completed, and with it the uploads submitted before it.
+    // Ranges of evicted tiles are free again once the frames in flight that could draw them completed.
+    m_uploads->collect(frameNumber > m_framesInFlight ? frameNumber - m_framesInFlight : 0);
+    auto retired = std::partition(m_retired.begin(), m_retired.end(), [&](const RetiredRange& range) {
+        return range.frameNumber + m_framesInFlight > frameNumber;
+    });
+    for (auto it = retired; it != m_retired.end(); ++it) m_allocator.release(it->firstPoint, it->count);
+    m_retired.erase(retired, m_retired.end());
+
+    // 2. Select the tiles in the frustum, nearest first, as far as they fit the arena together
+    const std::array<glm::vec4, 6> planes = extractFrustumPlanes(viewProjection);
+    std::vector<std::pair<float, size_t>> candidates;
+    for (size_t i = 0; i < m_tiles.size(); ++i) {
+        if (m_tiles[i].state == TileState::failed) continue;
+        if (intersectsFrustum(planes, m_tiles[i].info.bounds)) {
+            candidates.emplace_back(distanceToBox(m_tiles[i].info.bounds, eye), i);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    m_visible.clear();
+    std::vector<size_t> requests;
+    size_t selectedPoints = 0;
+    for (const auto& [distance, index] : candidates) {
+        Tile& tile = m_tiles[index];
+        bool allocated = tile.state == TileState::uploading || tile.state == TileState::resident;
+        size_t points = allocated ? tile.loadedCount : tile.info.pointCount;
+        if (selectedPoints + points > m_allocator.getCapacity()) break;
+        selectedPoints += points;
+        m_visible.push_back(index);
+
+        // Selected tiles are never evicted in this update, including the ones still being loaded
+        tile.lastUsed = frameNumber;
+        if (tile.state == TileState::resident) {
+            ++m_stats.hits;
+        } else {
+            ++m_stats.misses;
+            requests.push_back(index);
+        }
+    }
+
+    // 3. Replace the queue with this frame's misses; tiles already being read finish regardless
+    std::vector<LoadedTile> loaded;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t index : m_requests) m_tiles[index].state = TileState::unloaded;
+        m_requests.clear();
+        for (size_t index : requests) {
+            if (m_tiles[index].state != TileState::unloaded) continue;
+            m_tiles[index].state = TileState::requested;
+            m_requests.push_back(index);
+        }
+        loaded.swap(m_loaded);
+    }
+    m_wake.notify_one();
+
+    // 4. Stage the tiles read so far into the arena, the draws below wait for them on the GPU
+    uploadTiles(loaded, frameNumber);
+
+    // 5. Draw the selected tiles that are resident
+    m_draws.clear();
+    for (size_t index : m_visible) {
+        const Tile& tile = m_tiles[index];
+        if (tile.state != TileState::resident) continue;
+        m_draws.push_back({static_cast<uint32_t>(tile.firstPoint), static_cast<uint32_t>(tile.loadedCount)});
+    }
+    m_stats.visibleTiles = m_visible.size();
+    m_stats.drawnTiles = m_draws.size();
+}
+
+void TileManager::uploadTiles(std::vector<LoadedTile>& loaded, uint64_t frameNumber) {
+    const std::array<size_t, 3> strides = getPointStreamStrides(m_pointFormat);
+    const std::array<tga::Buffer, 3> targets{m_arena.points, m_arena.colors, m_arena.intensities};
+
+    std::vector<LoadedTile> unfinished;
+    auto oldest = UploadService::Clock::time_point::max();
+    for (LoadedTile& tile : loaded) {
+        Tile& target = m_tiles[tile.tile];
+        if (tile.pointCount == 0) {
+            target.state = TileState::failed;
+            continue;
+        }
+
+        if (target.state == TileState::requested) {
+            size_t firstPoint = allocateRange(tile.pointCount, frameNumber);
+            if (firstPoint == RangeAllocator::INVALID_OFFSET) {
+                // Ranges freed by evictions are still drawn by frames in flight: keep the
+                // points for a later update. With nothing to evict, drop them.
+                if (!m_retired.empty()) {
+                    unfinished.push_back(std::move(tile));
+                } else {
+                    target.state = TileState::unloaded;
+                }
+                continue;
+            }
+            target.state = TileState::uploading;
+            target.firstPoint = firstPoint;
+            target.loadedCount = tile.pointCount;
+            m_stats.residentBytes += tile.pointCount * m_bytesPerPoint;
+        }
+
+        // Every batch is encoded straight into the staging ring, as far as this update's slot holds
+        while (tile.uploadedBatches < tile.batches.size()) {
+            PointAttributes& batch = tile.batches[tile.uploadedBatches];
+            const size_t count = batch.size();
+            uint8_t* staged = count * m_bytesPerPoint <= m_uploads->getAvailable()
+                ? m_uploads->reserve(count * m_bytesPerPoint) : nullptr;
+            if (!staged) break;
+
+            std::array<uint8_t*, 3> streams{};
+            size_t streamOffset = 0;
+            for (size_t s = 0; s < streams.size(); ++s) {
+                streams[s] = staged + streamOffset;
+                streamOffset += count * strides[s];
+            }
+            encodePointRange(m_pointFormat, m_quantization, batch, 0, count, streams);
+            for (size_t s = 0; s < streams.size(); ++s) {
+                if (strides[s] > 0) {
+                    m_uploads->copy(streams[s], targets[s], (target.firstPoint + tile.uploadedPoints) * strides[s], count * strides[s]);
+                }
+            }
+
+            batch = {};
+            ++tile.uploadedBatches;
+            tile.uploadedPoints += count;
+            m_stats.uploadedBytes += count * m_bytesPerPoint;
+            oldest = std::min(oldest, tile.loadedAt);
+        }
+
+        if (tile.uploadedBatches < tile.batches.size()) {
+            unfinished.push_back(std::move(tile));
+            continue;
+        }
+        // Drawable right away: this frame's draws are submitted after the batch
+        target.state = TileState::resident;
+        ++m_stats.residentTiles;
+    }
+    m_uploads->submit(oldest, frameNumber);
+
+    if (!unfinished.empty()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loaded.insert(m_loaded.begin(), std::make_move_iterator(unfinished.begin()), std::make_move_iterator(unfinished.end()));
+    }
+}
+
+size_t TileManager::allocateRange(size_t count, uint64_t frameNumber) {
+    while (true) {
+        size_t firstPoint = m_allocator.allocate(count);
+        if (firstPoint != RangeAllocator::INVALID_OFFSET) return firstPoint;
+
+        // Enough is retired already, it becomes free within framesInFlight updates
+        size_t retiredPoints = 0;
+        for (const RetiredRange& range : m_retired) retiredPoints += range.count;
+        if (retiredPoints >= count) return RangeAllocator::INVALID_OFFSET;
+
+        // Evict the least recently selected tile, never one selected in this update
+        size_t victim = m_tiles.size();
+        for (size_t i = 0; i < m_tiles.size(); ++i) {
+            const Tile& tile = m_tiles[i];
+            if (tile.state != TileState::resident || tile.lastUsed == frameNumber) continue;
+            if (victim == m_tiles.size() || tile.lastUsed < m_tiles[victim].lastUsed) victim = i;
+        }
+        if (victim == m_tiles.size()) return RangeAllocator::INVALID_OFFSET;
+        evict(victim, frameNumber);
+    }
+}
+
+void TileManager::evict(size_t index, uint64_t frameNumber) {
+    Tile& tile = m_tiles[index];
+    m_retired.push_back({frameNumber, tile.firstPoint, tile.loadedCount});
+    m_stats.residentBytes -= tile.loadedCount * m_bytesPerPoint;
+    --m_stats.residentTiles;
+    ++m_stats.evictions;
+    tile.state = TileState::unloaded;
+    tile.loadedCount = 0;
+}
+
+void TileManager::getDrawBindings(const tga::Buffer& cameraUbo, std::vector<tga::BindingLayout>& layout,
+                                  std::vector<tga::Binding>& bindings) const {
+    layout = {
+        {tga::BindingType::uniformBuffer}, // Camera
+        {tga::BindingType::storageBuffer}, // Arena points
+        {tga::BindingType::uniformBuffer}, // Point quantization
+    };
+    bindings = {{cameraUbo, 0, 0}, {m_arena.points, 1, 0}, {m_quantizationBuffer, 2, 0}};
+
+    // Colors and intensities of the SoA layout, as appendPointStreams() binds them
+    if (m_pointFormat == PointFormat::soa) {
+        for (const tga::Buffer& stream : {m_arena.colors, m_arena.intensities}) {
+            bindings.push_back({stream, static_cast<uint32_t>(layout.size())});
+            layout.push_back({tga::BindingType::storageBuffer});
+        }
+    }
+}
@@ -0,0 +1,116 @@
+#include "UploadService.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+/// Alignment of reservations, enough for every point stream the encoders write.
+constexpr size_t RESERVE_ALIGNMENT = 16;
+
+size_t alignUp(size_t value) {
+    return (value + RESERVE_ALIGNMENT - 1) & ~(RESERVE_ALIGNMENT - 1);
+}
+
+double millisecondsBetween(UploadService::Clock::time_point begin, UploadService::Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+} // namespace
+
+UploadService::UploadService(tga::Interface& tgai, size_t slotSize, uint32_t slotCount)
+    : m_tgai(tgai), m_slotSize(slotSize), m_slots(std::max(1u, slotCount)) {
+    for (Slot& slot : m_slots) {
+        slot.staging = tgai.createStagingBuffer({slotSize});
+        slot.mapping = static_cast<uint8_t*>(tgai.getMapping(slot.staging));
+    }
+}
+
+UploadService::~UploadService() {
+    // An open batch holds no copies anyone waits for, it is ended unsubmitted
+    if (m_recorder) m_slots[m_next].commands = m_recorder->endRecording();
+    m_recorder.reset();
+
+    for (Slot& slot : m_slots) {
+        if (slot.inFlight) m_tgai.waitForCompletion(slot.commands);
+        if (slot.commands) m_tgai.free(slot.commands);
+        m_tgai.free(slot.staging);
+    }
+}
+
+size_t UploadService::getAvailable() const {
+    const Slot& slot = m_slots[m_next];
+    if (m_recorder) return m_slotSize - std::min(m_slotSize, alignUp(slot.used));
+    return slot.inFlight ? 0 : m_slotSize;
+}
+
+uint8_t* UploadService::reserve(size_t size, bool wait) {
+    if (size > m_slotSize) throw std::invalid_argument("Upload of " + std::to_string(size) + " bytes exceeds the staging slot");
+
+    Slot& slot = m_slots[m_next];
+    if (!m_recorder) {
+        if (slot.inFlight) {
+            if (!wait) {
+                ++m_stats.refused;
+                return nullptr;
+            }
+            retire(slot);
+        }
+        m_recorder.emplace(m_tgai, slot.commands);
+        slot.used = 0;
+    }
+
+    size_t offset = alignUp(slot.used);
+    if (offset > m_slotSize || m_slotSize - offset < size) return nullptr;
+    slot.used = offset + size;
+    return slot.mapping + offset;
+}
+
+void UploadService::copy(const uint8_t* staged, const tga::Buffer& dst, size_t dstOffset, size_t size) {
+    Slot& slot = m_slots[m_next];
+    m_recorder->bufferUpload(slot.staging, dst, size, static_cast<size_t>(staged - slot.mapping), dstOffset);
+}
+
+void UploadService::submit(Clock::time_point dataSince, uint64_t frameNumber) {
+    if (!m_recorder) return;
+
+    Slot& slot = m_slots[m_next];
+    slot.commands = m_recorder->endRecording();
+    m_recorder.reset();
+    m_tgai.execute(slot.commands);
+    slot.inFlight = true;
+    slot.frameNumber = frameNumber;
+    slot.dataSince = dataSince;
+    slot.submitted = Clock::now();
+    m_next = (m_next + 1) % m_slots.size();
+}
+
+void UploadService::collect(uint64_t completedFrame) {
+    for (Slot& slot : m_slots) {
+        if (slot.inFlight && slot.frameNumber <= completedFrame) retire(slot);
+    }
+}
+
+void UploadService::retire(Slot& slot) {
+    m_tgai.waitForCompletion(slot.commands);
+    slot.inFlight = false;
+    const Clock::time_point now = Clock::now();
+
+    ++m_stats.batches;
+    m_stats.bytes += slot.used;
+    m_queuedMsTotal += millisecondsBetween(slot.dataSince, slot.submitted);
+    const double readyMs = millisecondsBetween(slot.dataSince, now);
+    m_readyMsTotal += readyMs;
+    m_stats.queuedMs = m_queuedMsTotal / static_cast<double>(m_stats.batches);
+    m_stats.readyMs = m_readyMsTotal / static_cast<double>(m_stats.batches);
+    m_stats.maxReadyMs = std::max(m_stats.maxReadyMs, readyMs);
+
+    // The bandwidth window opens with the first batch after an idle second
+    if (m_windowBytes == 0) m_windowStart = slot.submitted;
+    m_windowBytes += slot.used;
+    const double seconds = std::chrono::duration<double>(now - m_windowStart).count();
+    if (seconds >= 1.0) {
+        m_stats.bandwidthMBs = static_cast<double>(m_windowBytes) / (1024.0 * 1024.0) / seconds;
+        m_windowBytes = 0;
+    }
+}
@@ -0,0 +1,62 @@
+#include "tga/tga.hpp"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Config.hpp"
+#include "LPCBuilder.hpp"
+#include "PointCache.hpp"
+#include "PointCloud.hpp"
+
+/*
+ * pointspire-build: headless preprocessing of a point cloud into a .pspire cache.
+ *
+ * Runs ingest, Morton codes, sort and the tree build without a window or a
+ * swapchain, so it works on servers with a software Vulkan device, and
+ * writes the result for the viewer to restore.
+ *
+ * Usage: pointspire-build --input=<file.las|bun.conf>[,...] [--output=<file.pspire>] [viewer options]
+ * The viewer options that shape the cache (--point-format, --morton-bits,
+ * --sort, --load, --build) are accepted as well; the viewer must run with the
+ * same --point-format and --morton-bits to pick the cache up.
+ */
+int main(int argc, char** argv) {
+    try {
+        // --output is the tool's name for --cache-file, everything else goes to the shared parser
+        std::vector<std::string> args(argv, argv + argc);
+        for (std::string& arg : args) {
+            if (std::string_view(arg).starts_with("--output=")) arg = "--cache-file=" + arg.substr(9);
+        }
+        std::vector<char*> forwarded;
+        for (std::string& arg : args) forwarded.push_back(arg.data());
+
+        Config config = parseCommandLine(static_cast<int>(forwarded.size()), forwarded.data());
+        if (isPointCachePath(config.inputPaths.front())) {
+            throw std::invalid_argument("--input is already a built cache, pass the point cloud it was built from");
+        }
+        if (config.cacheMode == CacheMode::off) {
+            throw std::invalid_argument("--cache=off leaves nothing to write");
+        }
+        if (!config.tilesPath.empty()) {
+            throw std::invalid_argument("--tiles are streamed by the viewer, there is no hierarchy to build");
+        }
+        config.cacheMode = CacheMode::rebuild;
+        config.framesInFlight = 1; // Nothing is drawn, only the build uses the visible buffer
+
+        tga::Interface tgai;
+        PointCloud pointCloud(tgai, config);
+        if (pointCloud.getTotalPointCount() == 0) {
+            std::string inputs;
+            for (const std::string& path : config.inputPaths) inputs += (inputs.empty() ? "" : ", ") + path;
+            throw std::runtime_error("No points loaded from " + inputs);
+        }
+
+        buildLayeredPointCloud(tgai, pointCloud, config);
+        if (!pointCloud.writeCache()) return -1;
+    } catch (const std::exception& e) {
+        std::cerr << "Fatal Error: " << e.what() << "\n";
+        return -1;
+    }
+    return 0;
+}